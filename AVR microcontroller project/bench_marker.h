@@ -0,0 +1,51 @@
+/*
+ * bench_marker.h
+ *
+ * Markers for the cycle-accounting benchmark (host/simavr_bench.c). When
+ * the firmware is built with BENCH_MARKERS defined each marker is a
+ * single write of the marker number to GPIOR0, which the simulator
+ * watches. In a normal build the markers compile to nothing, and the
+ * marker numbers can be shared with the simulator side.
+ */
+
+#ifndef BENCH_MARKER_H_
+#define BENCH_MARKER_H_
+
+// Top of every input polling loop outside of play_game()
+#define BENCH_INPUT_POLL 1
+// Top of every play_game() iteration (also an input poll)
+#define BENCH_GAME_LOOP 2
+// computer_turn() entry and exit. The computer only chooses its target
+// here; the shot lands when the firing animation ends.
+#define BENCH_TURN_START 3
+#define BENCH_TURN_END 4
+// A new game has started
+#define BENCH_GAME_START 5
+// handle_game_over() has been reached
+#define BENCH_GAME_OVER 6
+// terminal_bench(): BENCH_TERMINAL_CALLS calls each of
+// move_terminal_cursor() and set_display_attribute() through printf_P(),
+// then the same calls without it
+#define BENCH_TERMINAL_PRINTF 7
+#define BENCH_TERMINAL_DIRECT 8
+#define BENCH_TERMINAL_END 9
+#define BENCH_TERMINAL_CALLS 8
+// The computer's shot landing (resolve_computer_shot() in game.c)
+#define BENCH_SHOT_START 10
+#define BENCH_SHOT_END 11
+// A frame being sent to the LED matrix and terminal during a game (the
+// display task, and the final frame in is_game_over())
+#define BENCH_COMMIT_START 12
+#define BENCH_COMMIT_END 13
+// scheduler_sleep_unless() going to sleep and waking up
+#define BENCH_SLEEP 14
+#define BENCH_WAKE 15
+
+#ifdef BENCH_MARKERS
+#include <avr/io.h>
+#define BENCH_MARK(marker) (GPIOR0 = (marker))
+#else
+#define BENCH_MARK(marker) do { } while (0)
+#endif
+
+#endif /* BENCH_MARKER_H_ */
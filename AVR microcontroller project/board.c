@@ -0,0 +1,228 @@
+/*
+ * board.c
+ *
+ * Bitboard grids - see board.h
+ */
+
+#include "board.h"
+#include <avr/pgmspace.h>
+#include "game.h"
+
+void board_load(Board* board, const uint8_t grid[GRID_NUM_ROWS][GRID_NUM_COLUMNS])
+{
+	for (uint8_t i = 0; i < NUM_SHIPS; i++)
+	{
+		board->ships[i] = 0;
+	}
+	board->fleet = 0;
+	for (uint8_t y = 0; y < GRID_NUM_ROWS; y++)
+	{
+		for (uint8_t x = 0; x < GRID_NUM_COLUMNS; x++)
+		{
+			uint8_t ship = grid[y][x] & SHIP_MASK;
+			if (ship != SEA && ship <= NUM_SHIPS)
+			{
+				board->ships[ship - 1] |= BOARD_CELL(x, y);
+				board->fleet |= BOARD_CELL(x, y);
+			}
+		}
+	}
+	board->fired = 0;
+	board->hit = 0;
+	board->sunk = 0;
+	board->afloat = 0;
+	board->newly_sunk = 0;
+	
+	// Ships are straight lines, so the lowest numbered cell and whether
+	// the next is beside it give every cell
+	for (uint8_t i = 0; i < NUM_SHIPS; i++)
+	{
+		ShipCells* cells = &board->cells[i];
+		Bitboard ship = board->ships[i];
+		cells->size = board_count(ship);
+		cells->first = 0;
+		cells->step = 1;
+		if (!ship)
+		{
+			continue;
+		}
+		while (!(ship & 1))
+		{
+			ship >>= 1;
+			cells->first++;
+		}
+		if (cells->size > 1 && !(ship & 2))
+		{
+			cells->step = GRID_NUM_COLUMNS;
+		}
+		board->hits_to_sink[i] = cells->size;
+		board->afloat |= 1 << i;
+	}
+}
+
+uint8_t board_ship_at(const Board* board, uint8_t x, uint8_t y)
+{
+	Bitboard cell = BOARD_CELL(x, y);
+	if (!(board->fleet & cell))
+	{
+		return SEA;
+	}
+	uint8_t i = 0;
+	while (!(board->ships[i] & cell))
+	{
+		i++;
+	}
+	return i + 1;
+}
+
+uint8_t board_cell(const Board* board, uint8_t x, uint8_t y)
+{
+	Bitboard cell = BOARD_CELL(x, y);
+	uint8_t value = board_ship_at(board, x, y);
+	if (board->hit & cell)
+	{
+		value |= HIT_MASK;
+	} else if (board->fired & cell)
+	{
+		value |= MISS_MASK;
+	}
+	if (board->sunk & cell)
+	{
+		value |= SUNK_MASK;
+	}
+	return value;
+}
+
+Bitboard board_fire(Board* board, Bitboard targets)
+{
+	Bitboard new_hits = targets & ~board->fired & board->fleet;
+	board->fired |= targets;
+	board->hit |= new_hits;
+	if (!new_hits)
+	{
+		return 0;
+	}
+	
+	// Count the hits off the ships they landed on
+	for (uint8_t i = 0; i < NUM_SHIPS; i++)
+	{
+		Bitboard ship_hits = new_hits & board->ships[i];
+		if (!ship_hits)
+		{
+			continue;
+		}
+		board->hits_to_sink[i] -= board_count(ship_hits);
+		if (board->hits_to_sink[i] == 0)
+		{
+			board->sunk |= board->ships[i];
+			board->afloat &= ~(1 << i);
+			board->newly_sunk |= 1 << i;
+		}
+	}
+	return new_hits;
+}
+
+uint8_t board_update_sunk(Board* board)
+{
+	uint8_t newly_sunk = board->newly_sunk;
+	board->newly_sunk = 0;
+	return newly_sunk;
+}
+
+Bitboard board_area(uint8_t x, uint8_t y)
+{
+	// Columns x - 1 to x + 1 of a row; the shift drops column -1 and the
+	// cast column 8
+	uint8_t columns = (uint8_t)((0x07 << x) >> 1);
+	Bitboard area = (Bitboard)columns << (y * GRID_NUM_COLUMNS);
+	area |= (area << GRID_NUM_COLUMNS) | (area >> GRID_NUM_COLUMNS);
+	return area;
+}
+
+Bitboard board_neighbours_horizontal(Bitboard cells)
+{
+	return ((cells << 1) & ~BOARD_COLUMN(0)) | ((cells >> 1) & ~BOARD_COLUMN(GRID_NUM_COLUMNS - 1));
+}
+
+Bitboard board_neighbours_vertical(Bitboard cells)
+{
+	return (cells << GRID_NUM_COLUMNS) | (cells >> GRID_NUM_COLUMNS);
+}
+
+Bitboard board_neighbours(Bitboard cells)
+{
+	return board_neighbours_horizontal(cells) | board_neighbours_vertical(cells);
+}
+
+// Cells set in each value of a nibble
+static const uint8_t nibble_count[16] PROGMEM = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+
+static uint8_t byte_count(uint8_t byte)
+{
+	return pgm_read_byte(&nibble_count[byte & 0x0F]) + pgm_read_byte(&nibble_count[byte >> 4]);
+}
+
+uint8_t board_count(Bitboard cells)
+{
+	uint8_t count = 0;
+	for (uint8_t i = 0; i < sizeof(cells); i++)
+	{
+		count += byte_count(cells);
+		cells >>= 8;
+	}
+	return count;
+}
+
+uint8_t board_select(Bitboard cells, uint8_t n)
+{
+	// Skip whole rows, then step through the row the cell is in
+	uint8_t cell = 0;
+	uint8_t row = cells;
+	uint8_t count;
+	while ((count = byte_count(row)) <= n)
+	{
+		n -= count;
+		cells >>= 8;
+		row = cells;
+		cell += 8;
+	}
+	while (1)
+	{
+		if (row & 1)
+		{
+			if (n == 0)
+			{
+				return cell;
+			}
+			n--;
+		}
+		row >>= 1;
+		cell++;
+	}
+}
+
+void cell_pool_fill(CellPool* pool)
+{
+	for (uint8_t cell = 0; cell < GRID_NUM_ROWS * GRID_NUM_COLUMNS; cell++)
+	{
+		pool->cells[cell] = cell;
+	}
+	pool->count = GRID_NUM_ROWS * GRID_NUM_COLUMNS;
+}
+
+void cell_pool_remove(CellPool* pool, uint8_t x, uint8_t y)
+{
+	uint8_t cell = y * GRID_NUM_COLUMNS + x;
+	uint8_t position = 0;
+	while (position < pool->count && pool->cells[position] != cell)
+	{
+		position++;
+	}
+	if (position == pool->count)
+	{
+		return;
+	}
+	pool->count--;
+	pool->cells[position] = pool->cells[pool->count];
+	pool->cells[pool->count] = cell;
+}
@@ -0,0 +1,132 @@
+/*
+ * board.h
+ *
+ * Bitboard representation of a player's grid. Each of the 64 cells is
+ * one bit of a uint64_t, bit (y * 8 + x), so a whole plane of the grid
+ * can be tested or updated with a few mask operations. A board keeps one
+ * plane for each ship plus the cells fired at, the cells hit and the
+ * cells of sunk ships.
+ *
+ * board_cell() packs a cell back into the ship id and HIT_MASK /
+ * MISS_MASK / SUNK_MASK byte the rendering code was written against.
+ */
+
+#ifndef BOARD_H_
+#define BOARD_H_
+
+#include <stdint.h>
+#include "ledmatrix.h"
+
+#define NUM_SHIPS 6
+
+typedef uint64_t Bitboard;
+
+// Where a ship is: its first cell (y * 8 + x, the lowest numbered), the
+// step to each next cell (1 along a row, 8 up a column) and its length
+typedef struct {
+	uint8_t first;
+	uint8_t step;
+	uint8_t size;
+} ShipCells;
+
+typedef struct {
+	Bitboard ships[NUM_SHIPS];	// ship id i + 1 (see game.h)
+	Bitboard fleet;				// every ship
+	Bitboard fired;
+	Bitboard hit;
+	Bitboard sunk;
+	ShipCells cells[NUM_SHIPS];
+	uint8_t hits_to_sink[NUM_SHIPS];
+	uint8_t afloat;				// bit i set while ship i + 1 is afloat
+	uint8_t newly_sunk;			// sunk since board_update_sunk()
+} Board;
+
+// The bit for a cell
+#define BOARD_CELL(x, y) ((Bitboard)1 << ((y) * GRID_NUM_COLUMNS + (x)))
+
+// Every cell of a row or a column
+#define BOARD_ROW(y) ((Bitboard)0xFF << ((y) * GRID_NUM_COLUMNS))
+#define BOARD_COLUMN(x) ((Bitboard)0x0101010101010101ULL << (x))
+
+// Flags in the byte returned by board_cell()
+#define HIT_MASK 128
+#define MISS_MASK 64
+#define SUNK_MASK 32
+
+// Set up a board from a grid of ship ids (as in game.h), with no shots
+// fired. grid is indexed [y][x].
+void board_load(Board* board, const uint8_t grid[GRID_NUM_ROWS][GRID_NUM_COLUMNS]);
+
+// Ship id at a cell, SEA if there is none
+uint8_t board_ship_at(const Board* board, uint8_t x, uint8_t y);
+
+// The cell as a ship id with HIT_MASK, MISS_MASK and SUNK_MASK set as
+// they apply
+uint8_t board_cell(const Board* board, uint8_t x, uint8_t y);
+
+// Fire at every cell in targets that hasn't been fired at already.
+// Returns the cells that were newly hit. A ship is sunk (marked in the
+// sunk plane and taken out of afloat) as its last cell is hit.
+Bitboard board_fire(Board* board, Bitboard targets);
+
+// A bit for each ship sunk since the last call (bit i for ship id i + 1)
+uint8_t board_update_sunk(Board* board);
+
+// The cell number (y * 8 + x) of cell n of ship i (ship id i + 1)
+static inline uint8_t board_ship_cell(const Board* board, uint8_t i, uint8_t n)
+{
+	return board->cells[i].first + n * board->cells[i].step;
+}
+
+// The cells within one of (x, y), including it, clipped to the grid
+Bitboard board_area(uint8_t x, uint8_t y);
+
+// The cells to the left and right of, above and below, or next to (in
+// any of the four directions) the cells given, clipped to the grid
+Bitboard board_neighbours_horizontal(Bitboard cells);
+Bitboard board_neighbours_vertical(Bitboard cells);
+Bitboard board_neighbours(Bitboard cells);
+
+// Number of cells set
+uint8_t board_count(Bitboard cells);
+
+// The cell number (y * 8 + x) of the nth cell set, counting from 0 in
+// bit order. n must be less than board_count(cells).
+uint8_t board_select(Bitboard cells, uint8_t n);
+
+// The cells of a grid not yet fired at, kept so that one can be picked
+// with a single random draw. cells[0] to cells[count - 1] are the cells
+// (numbered y * 8 + x, as the bits of a Bitboard) in no particular order.
+// Removing a cell swaps the last one into its place; it is found by
+// searching, as a cell is removed only once per shot and an index of
+// positions would take another 64 bytes of RAM.
+typedef struct {
+	uint8_t cells[GRID_NUM_ROWS * GRID_NUM_COLUMNS];
+	uint8_t count;
+} CellPool;
+
+// Put every cell in the pool
+void cell_pool_fill(CellPool* pool);
+
+// Take a cell out of the pool. Does nothing if it isn't there.
+void cell_pool_remove(CellPool* pool, uint8_t x, uint8_t y);
+
+// The cell at a position in the pool (0 to count - 1)
+static inline uint8_t cell_pool_get(const CellPool* pool, uint8_t position)
+{
+	return pool->cells[position];
+}
+
+// Non-zero if a cell has been fired at
+static inline uint8_t board_fired_at(const Board* board, uint8_t x, uint8_t y)
+{
+	return (board->fired & BOARD_CELL(x, y)) != 0;
+}
+
+// Non-zero once every ship has been sunk
+static inline uint8_t board_all_sunk(const Board* board)
+{
+	return board->afloat == 0;
+}
+
+#endif /* BOARD_H_ */
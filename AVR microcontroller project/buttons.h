@@ -3,8 +3,10 @@
  *
  * Author: Peter Sutton
  *
- * We assume four push buttons (B0 to B3) are connected to pins B0 to B3. We configure
- * pin change interrupts on these pins.
+ * We assume four push buttons (B0 to B3) are connected to pins B0 to B3. The
+ * pins are sampled every millisecond from the timer 0 interrupt and debounced
+ * there, and pushes are posted to the input queue (input.h). A button held
+ * down repeats its push, as a keyboard does.
  */ 
 
 
@@ -21,18 +23,45 @@
 
 #define NUM_BUTTONS 4
 
-/* Set up pin change interrupts on pins B0 to B3.
+/* Milliseconds a pin must be steady before a push or release counts */
+#ifndef BUTTON_DEBOUNCE_MS
+#define BUTTON_DEBOUNCE_MS 10
+#endif
+
+/* Default auto-repeat: first repeat after the delay, then every interval */
+#ifndef BUTTON_REPEAT_DELAY_MS
+#define BUTTON_REPEAT_DELAY_MS 500
+#endif
+#ifndef BUTTON_REPEAT_INTERVAL_MS
+#define BUTTON_REPEAT_INTERVAL_MS 150
+#endif
+
+typedef struct {
+	uint16_t dropped;	// pushes lost because the queue was full
+	uint16_t bounced;	// changes that didn't last BUTTON_DEBOUNCE_MS
+} ButtonStats;
+
+/* Set up the buttons, taking any held down now as already pushed.
  * It is assumed that global interrupts are off when this function is called
  * and are enabled sometime after this function is called.
  */
-void init_button_interrupts(void);
+void init_buttons(void);
+
+/* Sample and debounce the buttons. Called from the timer 0 interrupt
+ * every millisecond.
+ */
+void buttons_sample(void);
+
+/* Stop buttons held down now from repeating until they are released.
+ */
+void buttons_clear(void);
 
-/* Return the last button pushed (0 to 3) or -1 (NO_BUTTON_PUSHED) if 
- * there are no button pushes to return. (A small queue of button pushes
- * is kept. This function should be called frequently enough to
- * ensure the queue does not overflow. Excess button pushes are
- * discarded.)
+/* Set how long a button must be held before its push repeats, and how
+ * often it repeats after that. An interval of 0 turns auto-repeat off.
  */
-int8_t button_pushed(void);
+void button_set_repeat(uint16_t delay_ms, uint16_t interval_ms);
+
+/* Return a copy of the dropped and bounced counts. */
+ButtonStats button_stats(void);
 
 #endif /* BUTTONS_H_ */
@@ -0,0 +1,98 @@
+/*
+ * events.c
+ *
+ * Game event bus - see events.h
+ */
+
+#include "events.h"
+#include <stdint.h>
+#include <string.h>
+
+typedef struct {
+	EventHandler handler;
+	uint8_t mask;
+} Subscriber;
+
+static Event queue[EVENT_QUEUE_SIZE];
+static uint8_t head;
+static uint8_t tail;
+static Subscriber subscribers[EVENT_MAX_HANDLERS];
+static uint8_t num_subscribers;
+static uint8_t dispatching;
+static EventStats stats;
+
+void events_init(void)
+{
+	head = 0;
+	tail = 0;
+	num_subscribers = 0;
+	dispatching = 0;
+	memset(&stats, 0, sizeof(stats));
+}
+
+uint8_t events_subscribe(EventHandler handler, uint8_t mask)
+{
+	if (num_subscribers >= EVENT_MAX_HANDLERS)
+	{
+		return 0;
+	}
+	subscribers[num_subscribers].handler = handler;
+	subscribers[num_subscribers].mask = mask;
+	num_subscribers++;
+	return 1;
+}
+
+void event_post(EventType type, uint8_t player, uint8_t cell, uint8_t detail)
+{
+	// head and tail run freely; their difference is the number queued
+	if ((uint8_t)(head - tail) == EVENT_QUEUE_SIZE)
+	{
+		if (dispatching)
+		{
+			stats.dropped++;
+			return;
+		}
+		stats.full++;
+		events_dispatch();
+	}
+	Event* event = &queue[head & (EVENT_QUEUE_SIZE - 1)];
+	event->type = type;
+	event->player = player;
+	event->cell = cell;
+	event->detail = detail;
+	head++;
+	stats.posted++;
+	if ((uint8_t)(head - tail) > stats.most_queued)
+	{
+		stats.most_queued = head - tail;
+	}
+}
+
+uint8_t events_pending(void)
+{
+	return head != tail;
+}
+
+void events_dispatch(void)
+{
+	dispatching = 1;
+	while (tail != head)
+	{
+		const Event* event = &queue[tail & (EVENT_QUEUE_SIZE - 1)];
+		uint8_t mask = EVENT_MASK(event->type);
+		for (uint8_t i = 0; i < num_subscribers; i++)
+		{
+			if (subscribers[i].mask & mask)
+			{
+				subscribers[i].handler(event);
+			}
+		}
+		tail++;
+	}
+	dispatching = 0;
+}
+
+const EventStats* events_stats(void)
+{
+	return &stats;
+}
@@ -0,0 +1,74 @@
+/*
+ * events.h
+ *
+ * A small event bus. The game posts typed events (shots, hits, misses,
+ * sinkings, game over, mode changes, new games) into a ring; the
+ * display, sound, terminal and remote code subscribe handlers, and
+ * events_dispatch() passes each queued event, in order, to every handler
+ * that wants its type. The game logic never waits for output, and the
+ * output code never looks at strings to work out what happened.
+ */
+
+#ifndef EVENTS_H_
+#define EVENTS_H_
+
+#include <stdint.h>
+
+// Must be a power of two
+#define EVENT_QUEUE_SIZE 8
+#define EVENT_MAX_HANDLERS 5
+
+typedef enum {
+	EVENT_SHOT_FIRED,	// player fired at cell; the hits and misses follow
+	EVENT_HIT,			// player's shot at cell hit a ship
+	EVENT_MISS,			// player's shot at cell missed
+	EVENT_SUNK,			// player sank ship number detail (0 to NUM_SHIPS - 1)
+	EVENT_GAME_OVER,	// player won
+	EVENT_MODE_CHANGE,	// the computer's mode is now detail
+	EVENT_NEW_GAME,		// a game has started against the computer in mode detail
+	NUM_EVENT_TYPES
+} EventType;
+
+// Handlers are given the types they want as a mask of these
+#define EVENT_MASK(type) (1 << (type))
+
+// Cells are numbered y * 8 + x, as in board.h. player is a Player from
+// game.h: the one who fired, sank or won.
+typedef struct {
+	uint8_t type;
+	uint8_t player;
+	uint8_t cell;
+	uint8_t detail;
+} Event;
+
+typedef void (*EventHandler)(const Event* event);
+
+typedef struct {
+	uint32_t posted;
+	uint8_t most_queued;
+	// Times the ring was full and was drained by event_post()
+	uint16_t full;
+	// Events posted by handlers to a full ring, which are lost
+	uint16_t dropped;
+} EventStats;
+
+// Empty the ring and forget every handler
+void events_init(void);
+
+// Call handler for each event whose type is in mask. Returns 0 if there
+// are already EVENT_MAX_HANDLERS handlers.
+uint8_t events_subscribe(EventHandler handler, uint8_t mask);
+
+// Queue an event. If the ring is full the queued events are dispatched
+// first, so nothing is lost.
+void event_post(EventType type, uint8_t player, uint8_t cell, uint8_t detail);
+
+// Returns non-zero if there are events waiting
+uint8_t events_pending(void);
+
+// Pass every queued event to its handlers
+void events_dispatch(void);
+
+const EventStats* events_stats(void);
+
+#endif /* EVENTS_H_ */
@@ -0,0 +1,224 @@
+/*
+ * fleet.c
+ *
+ * Random fleet placement - see fleet.h
+ */
+
+#include "fleet.h"
+#include <stdint.h>
+#include <string.h>
+#include <avr/pgmspace.h>
+#include "game.h"
+
+#ifndef FLEET_SHIP_SIZES
+#define FLEET_SHIP_SIZES SHIP_SIZES
+#endif
+
+static const uint8_t ship_sizes[] PROGMEM = FLEET_SHIP_SIZES;
+#define NUM_FLEET_SHIPS (sizeof(ship_sizes) / sizeof(ship_sizes[0]))
+
+static uint32_t random_state = 1;
+static FleetStats stats;
+
+// Cells taken, a bit for each cell of each row and of each column
+static uint8_t rows[GRID_NUM_ROWS];
+static uint8_t columns[GRID_NUM_COLUMNS];
+
+// Where each ship has been put, and which of the places it fits (in the
+// order place_ship() finds them) that is: the first one it was put in,
+// plus the number it has been moved on since. The position is packed
+// into one byte to save RAM.
+typedef struct {
+	uint8_t x : 3;
+	uint8_t y : 3;
+	uint8_t horizontal : 1;
+	uint8_t first;
+	uint8_t moves;
+} Placement;
+
+static Placement placements[NUM_FLEET_SHIPS];
+
+void fleet_seed(uint32_t seed)
+{
+	// xorshift never leaves 0
+	random_state = seed ? seed : 1;
+}
+
+// A random number from 0 to n - 1
+static uint8_t random_below(uint8_t n)
+{
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+	return (uint16_t)(random_state >> 16) % n;
+}
+
+const FleetStats* fleet_stats(void)
+{
+	return &stats;
+}
+
+uint8_t fleet_num_ships(void)
+{
+	return NUM_FLEET_SHIPS;
+}
+
+uint8_t fleet_ship_size(uint8_t i)
+{
+	return pgm_read_byte(&ship_sizes[i]);
+}
+
+static void mark(const Placement* p, uint8_t size)
+{
+	uint8_t ship = (1 << size) - 1;
+	if (p->horizontal)
+	{
+		rows[p->y] ^= ship << p->x;
+		for (uint8_t i = 0; i < size; i++)
+		{
+			columns[p->x + i] ^= 1 << p->y;
+		}
+	} else
+	{
+		columns[p->x] ^= ship << p->y;
+		for (uint8_t i = 0; i < size; i++)
+		{
+			rows[p->y + i] ^= 1 << p->x;
+		}
+	}
+}
+
+// Whether a ship of size ship (a mask of size bits) fits at (x, y)
+static uint8_t fits(uint8_t x, uint8_t y, uint8_t horizontal, uint8_t ship)
+{
+	if (horizontal)
+	{
+		return !(rows[y] & (ship << x));
+	}
+	return !(columns[x] & (ship << y));
+}
+
+// Put ship i in a random free place, or if move, in the next free place
+// after the one it was taken out of. The ships before it are where they
+// were, so the free places are too, and the ship goes round them all
+// once before giving up. Returns 0 if there is nowhere (left) to try.
+static uint8_t place_ship(uint8_t i, uint8_t move)
+{
+	uint8_t size = pgm_read_byte(&ship_sizes[i]);
+	uint8_t ship = (1 << size) - 1;
+	uint8_t count = 0;
+	Placement* p = &placements[i];
+	
+	// Count the places it fits, then take one of them
+	for (uint8_t pass = 0; pass < 2; pass++)
+	{
+		uint8_t chosen = 0;
+		if (pass)
+		{
+			if (!move)
+			{
+				p->first = random_below(count);
+				p->moves = 0;
+			} else if (++p->moves == count)
+			{
+				return 0;
+			}
+			chosen = (p->first + p->moves) % count;
+		}
+		for (uint8_t horizontal = 0; horizontal < 2; horizontal++)
+		{
+			uint8_t max_x = horizontal ? GRID_NUM_COLUMNS - size : GRID_NUM_COLUMNS - 1;
+			uint8_t max_y = horizontal ? GRID_NUM_ROWS - 1 : GRID_NUM_ROWS - size;
+			for (uint8_t y = 0; y <= max_y; y++)
+			{
+				for (uint8_t x = 0; x <= max_x; x++)
+				{
+					if (!fits(x, y, horizontal, ship))
+					{
+						continue;
+					}
+					if (pass == 0)
+					{
+						count++;
+					} else if (chosen-- == 0)
+					{
+						p->x = x;
+						p->y = y;
+						p->horizontal = horizontal;
+						mark(p, size);
+						return 1;
+					}
+				}
+			}
+		}
+		if (count == 0)
+		{
+			return 0;
+		}
+	}
+	return 0;
+}
+
+// Write the ships into grid
+static void write_grid(uint8_t grid[GRID_NUM_ROWS][GRID_NUM_COLUMNS])
+{
+	memset(grid, SEA, GRID_NUM_ROWS * GRID_NUM_COLUMNS);
+	for (uint8_t i = 0; i < NUM_FLEET_SHIPS; i++)
+	{
+		const Placement* p = &placements[i];
+		uint8_t size = pgm_read_byte(&ship_sizes[i]);
+		for (uint8_t j = 0; j < size; j++)
+		{
+			uint8_t cell = (i + 1) | (p->horizontal ? HORIZONTAL : 0);
+			if (j == 0 || j == size - 1)
+			{
+				cell |= SHIP_END;
+			}
+			if (p->horizontal)
+			{
+				grid[p->y][p->x + j] = cell;
+			} else
+			{
+				grid[p->y + j][p->x] = cell;
+			}
+		}
+	}
+}
+
+void fleet_place(uint8_t grid[GRID_NUM_ROWS][GRID_NUM_COLUMNS])
+{
+	while (1)
+	{
+		memset(rows, 0, sizeof(rows));
+		memset(columns, 0, sizeof(columns));
+		uint8_t placed = 0;
+		uint8_t move = 0;
+		uint8_t backtracks = 0;
+		while (placed < NUM_FLEET_SHIPS)
+		{
+			if (place_ship(placed, move))
+			{
+				placed++;
+				move = 0;
+			} else if (placed > 0 && backtracks < FLEET_MAX_BACKTRACKS)
+			{
+				// Take out the ship before, to move it on
+				backtracks++;
+				placed--;
+				mark(&placements[placed], pgm_read_byte(&ship_sizes[placed]));
+				move = 1;
+			} else
+			{
+				break;
+			}
+		}
+		stats.backtracks += backtracks;
+		if (placed == NUM_FLEET_SHIPS)
+		{
+			break;
+		}
+		stats.restarts++;
+	}
+	write_grid(grid);
+	stats.fleets++;
+}
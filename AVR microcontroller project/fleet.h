@@ -0,0 +1,49 @@
+/*
+ * fleet.h
+ *
+ * Places the six ships (sizes SHIP_SIZES in game.h) at random on an
+ * empty grid, with no overlaps, in the encoding initialise_game() uses:
+ * the ship id in each of its cells, HORIZONTAL on every cell of a
+ * horizontal ship and SHIP_END on the cells at each end.
+ *
+ * Ships go down largest first, each in a random one of the places it
+ * fits (found with a bitmask for each row and column). If a ship has
+ * nowhere to go, the ship before it is moved on to the next place it
+ * fits, never back to one it has already been tried in, up to
+ * FLEET_MAX_BACKTRACKS times before starting again.
+ *
+ * The random numbers come from a generator of their own, so the fleets
+ * depend only on the seed. Build with -DFLEET_SEED=n to get the same
+ * fleets every run, or with -DFLEET_SHIP_SIZES={...} to place other
+ * ships (at most seven, in the order given) - make check does, to give
+ * the backtracking some work.
+ */
+
+#ifndef FLEET_H_
+#define FLEET_H_
+
+#include <stdint.h>
+#include "ledmatrix.h"
+
+#define FLEET_MAX_BACKTRACKS 16
+
+typedef struct {
+	uint32_t fleets;
+	uint32_t backtracks;
+	uint32_t restarts;
+} FleetStats;
+
+// Start the random number generator from seed
+void fleet_seed(uint32_t seed);
+
+// Fill grid (indexed [y][x]) with a random fleet
+void fleet_place(uint8_t grid[GRID_NUM_ROWS][GRID_NUM_COLUMNS]);
+
+// Totals since the program started
+const FleetStats* fleet_stats(void);
+
+// The ships placed: ship i has the id i + 1 in the grid
+uint8_t fleet_num_ships(void);
+uint8_t fleet_ship_size(uint8_t i);
+
+#endif /* FLEET_H_ */
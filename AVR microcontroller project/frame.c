@@ -0,0 +1,133 @@
+/*
+ * frame.c
+ *
+ * COBS framing with a CRC-16 - see frame.h
+ */
+
+#include "frame.h"
+#include <stdint.h>
+
+uint16_t frame_crc16(uint16_t crc, uint8_t byte)
+{
+	crc ^= (uint16_t)byte << 8;
+	for (uint8_t i = 0; i < 8; i++)
+	{
+		crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+	}
+	return crc;
+}
+
+static uint16_t crc_of(const uint8_t* data, uint8_t length)
+{
+	uint16_t crc = 0xFFFF;
+	for (uint8_t i = 0; i < length; i++)
+	{
+		crc = frame_crc16(crc, data[i]);
+	}
+	return crc;
+}
+
+uint8_t frame_seal(uint8_t* data, uint8_t length)
+{
+	uint16_t crc = crc_of(data, length);
+	data[length] = crc >> 8;
+	data[length + 1] = crc & 0xFF;
+	return length + 2;
+}
+
+void frame_encode(const uint8_t* data, uint8_t length, void (*put)(uint8_t byte))
+{
+	// Each block is a code (one more than the number of non-zero bytes
+	// that follow it) and those bytes; the zero after them is implied,
+	// except after a full block of 254
+	uint8_t start = 0;
+	for (;;)
+	{
+		uint8_t end = start;
+		while (end < length && data[end] != 0 && end - start < 254)
+		{
+			end++;
+		}
+		put(end - start + 1);
+		for (uint8_t i = start; i < end; i++)
+		{
+			put(data[i]);
+		}
+		if (end == length)
+		{
+			break;
+		}
+		// A block of fewer than 254 ended at a zero, which the next
+		// code stands for; a full block can be followed by any byte
+		start = end - start < 254 ? end + 1 : end;
+	}
+	put(0);
+}
+
+void frame_decoder_init(FrameDecoder* decoder)
+{
+	decoder->length = 0;
+	decoder->code = 0;
+	decoder->remaining = 0;
+	decoder->overflow = 0;
+}
+
+static void append(FrameDecoder* decoder, uint8_t byte)
+{
+	if (decoder->length < sizeof(decoder->data))
+	{
+		decoder->data[decoder->length++] = byte;
+	} else
+	{
+		decoder->overflow = 1;
+	}
+}
+
+int8_t frame_decode_byte(FrameDecoder* decoder, uint8_t byte)
+{
+	if (byte == 0)
+	{
+		int8_t result;
+		if (decoder->code == 0)
+		{
+			// Nothing since the last zero
+			result = 0;
+		} else if (decoder->remaining || decoder->overflow || decoder->length < 3
+				|| crc_of(decoder->data, decoder->length) != 0)
+		{
+			// A CRC over the data and its own CRC comes to zero
+			result = FRAME_BAD;
+		} else
+		{
+			result = decoder->length - 2;
+		}
+		decoder->code = 0;
+		decoder->remaining = 0;
+		decoder->overflow = 0;
+		if (result <= 0)
+		{
+			decoder->length = 0;
+		}
+		return result;
+	}
+	
+	if (decoder->remaining)
+	{
+		append(decoder, byte);
+		decoder->remaining--;
+		return 0;
+	}
+	
+	// A new block. The previous one ended with a zero, unless it was a
+	// full one.
+	if (decoder->code == 0)
+	{
+		decoder->length = 0;
+	} else if (decoder->code != 0xFF)
+	{
+		append(decoder, 0);
+	}
+	decoder->code = byte;
+	decoder->remaining = byte - 1;
+	return 0;
+}
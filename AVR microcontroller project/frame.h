@@ -0,0 +1,50 @@
+/*
+ * frame.h
+ *
+ * Packet framing for the binary serial protocol (remote.h). A packet is
+ * its payload followed by a CRC-16 (CCITT, initial value 0xFFFF, high
+ * byte first), COBS encoded so that it contains no zero bytes, then a
+ * zero byte to end it. A receiver that loses its place only has to wait
+ * for the next zero.
+ *
+ * Plain C with no AVR dependencies, so the host tools share it.
+ */
+
+#ifndef FRAME_H_
+#define FRAME_H_
+
+#include <stdint.h>
+
+// Longest payload, not counting the CRC
+#define FRAME_MAX_PAYLOAD 32
+
+// frame_decode_byte() result for a frame that was damaged or too long
+#define FRAME_BAD -1
+
+typedef struct {
+	uint8_t data[FRAME_MAX_PAYLOAD + 2];
+	uint8_t length;
+	uint8_t code;		// COBS code of the current block, 0 before the first
+	uint8_t remaining;	// bytes left in the block
+	uint8_t overflow;
+} FrameDecoder;
+
+uint16_t frame_crc16(uint16_t crc, uint8_t byte);
+
+// Append the CRC to length bytes of payload. data must have room for two
+// more bytes. Returns the new length.
+uint8_t frame_seal(uint8_t* data, uint8_t length);
+
+// COBS encode length bytes of sealed data and the closing zero, passing
+// each byte to put()
+void frame_encode(const uint8_t* data, uint8_t length, void (*put)(uint8_t byte));
+
+void frame_decoder_init(FrameDecoder* decoder);
+
+// Feed one received byte. Returns the payload length when it completes a
+// frame whose CRC checks (the payload is then in decoder->data), FRAME_BAD
+// when it completes one that doesn't, and 0 otherwise. Empty frames (zero
+// bytes on their own) are ignored.
+int8_t frame_decode_byte(FrameDecoder* decoder, uint8_t byte);
+
+#endif /* FRAME_H_ */
@@ -5,36 +5,35 @@
  *
  * Author: Jarrod Bennett, Cody Burnett
  */ 
-#define F_CPU 8000000UL // WARNING
 #include <avr/io.h> 
 #include "game.h"
+#include "board.h"
+#include "heatmap.h"
+#include "opening_book.h"
+#include "fleet.h"
+#include "events.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdint.h>
 #include "display.h"
 #include "ledmatrix.h"
 #include "terminalio.h"
-#include <util/delay.h> // delete this is for the delay for the buzzer
-#include <string.h> // WARNING
+#include "screen.h"
+#include "bench_marker.h"
+#include "sound.h"
+#include "timer0.h"
 
-uint16_t freq_to_clock_period(uint16_t freq) {
-	// Converts frequency to clock period in cycles for a 1MHz clock
-	return (1000000UL / freq);  
-}
-
-uint16_t duty_cycle_to_pulse_width(float dutycycle, uint16_t clockperiod) {
-	// Converts duty cycle to pulse width in clock cycles
-	return (dutycycle * clockperiod) / 100;  
-}
+Board human_board;
+Board computer_board;
 
-uint8_t human_grid[GRID_NUM_ROWS][GRID_NUM_COLUMNS];
-uint8_t computer_grid[GRID_NUM_ROWS][GRID_NUM_COLUMNS];
+// The human's cells the computer hasn't fired at yet
+static CellPool human_unfired;
 uint8_t cursor_x, cursor_y;
 uint8_t cursor_on;
 
-// The string for the computer's mode
-// Search and Destroy
-extern char mode[20];
+TextId game_mode_text(GameMode mode) {
+	return TEXT_MODE_BASIC + mode;
+}
 
 // Determines if the game is muted/unmuted
 extern uint32_t is_muted;
@@ -48,36 +47,24 @@ void initialise_game(void)
 	ledmatrix_clear();
 	
 	// see "Human Turn" feature for how ships are encoded
-	// fill in the grid with the ships
-	uint8_t initial_human_grid[GRID_NUM_ROWS][GRID_NUM_COLUMNS] =
-		{{SEA,                  SEA,                            SEA,                            SEA,                SEA,                SEA,                            SEA,                            SEA                 },
-		 {SEA,                  CARRIER|HORIZONTAL|SHIP_END,    CARRIER|HORIZONTAL,             CARRIER|HORIZONTAL, CARRIER|HORIZONTAL, CARRIER|HORIZONTAL,             CARRIER|HORIZONTAL|SHIP_END,    SEA                 },
-		 {SEA,                  SEA,                            SEA,                            SEA,                SEA,                SEA,                            SEA,                            SEA                 },
-		 {SEA,                  SEA,                            CORVETTE|SHIP_END,              SEA,                SEA,                SUBMARINE|SHIP_END,             SEA,                            SEA                 },
-		 {DESTROYER|SHIP_END,   SEA,                            CORVETTE|SHIP_END,              SEA,                SEA,                SUBMARINE|SHIP_END,             SEA,                            FRIGATE|SHIP_END    },
-		 {DESTROYER,            SEA,                            SEA,                            SEA,                SEA,                SEA,                            SEA,                            FRIGATE             },
-		 {DESTROYER|SHIP_END,   SEA,                            CRUISER|HORIZONTAL|SHIP_END,    CRUISER|HORIZONTAL, CRUISER|HORIZONTAL, CRUISER|HORIZONTAL|SHIP_END,    SEA,                            FRIGATE|SHIP_END    },
-		 {SEA,                  SEA,                            SEA,                            SEA,                SEA,                SEA,                            SEA,                            SEA                 }};
-	uint8_t initial_computer_grid[GRID_NUM_ROWS][GRID_NUM_COLUMNS] =
-		{{SEA,                  SEA,                            SEA,                            SEA,                SEA,                SEA,                            SEA,                            SEA                 },
-		 {DESTROYER|SHIP_END,   SEA,                            CRUISER|HORIZONTAL|SHIP_END,    CRUISER|HORIZONTAL, CRUISER|HORIZONTAL, CRUISER|HORIZONTAL|SHIP_END,    SEA,                            FRIGATE|SHIP_END    },
-		 {DESTROYER,            SEA,                            SEA,                            SEA,                SEA,                SEA,                            SEA,                            FRIGATE             },
-		 {DESTROYER|SHIP_END,   SEA,                            CORVETTE|SHIP_END,              SEA,                SEA,                SUBMARINE|SHIP_END,             SEA,                            FRIGATE|SHIP_END    },
-		 {SEA,                  SEA,                            CORVETTE|SHIP_END,              SEA,                SEA,                SUBMARINE|SHIP_END,             SEA,                            SEA                 },
-		 {SEA,                  SEA,                            SEA,                            SEA,                SEA,                SEA,                            SEA,                            SEA                 },
-		 {SEA,                  CARRIER|HORIZONTAL|SHIP_END,    CARRIER|HORIZONTAL,             CARRIER|HORIZONTAL, CARRIER|HORIZONTAL, CARRIER|HORIZONTAL,             CARRIER|HORIZONTAL|SHIP_END,    SEA                 },
-		 {SEA,                  SEA,                            SEA,                            SEA,                SEA,                SEA,                            SEA,                            SEA                 }};
+	// place the ships at random
+	uint8_t initial_human_grid[GRID_NUM_ROWS][GRID_NUM_COLUMNS];
+	uint8_t initial_computer_grid[GRID_NUM_ROWS][GRID_NUM_COLUMNS];
+	fleet_place(initial_human_grid);
+	fleet_place(initial_computer_grid);
 	
 	// Initializes the default
-	for (uint8_t i=0; i<GRID_NUM_COLUMNS; i++)
+	board_load(&human_board, initial_human_grid);
+	board_load(&computer_board, initial_computer_grid);
+	cell_pool_fill(&human_unfired);
+	heatmap_init(&human_board);
+	for (uint8_t y=0; y<GRID_NUM_ROWS; y++)
 	{
-		for (uint8_t j=0; j<GRID_NUM_COLUMNS; j++)
+		for (uint8_t x=0; x<GRID_NUM_COLUMNS; x++)
 		{
-			human_grid[j][i] = initial_human_grid[j][i];
-			computer_grid[j][i] = initial_computer_grid[j][i];
-			if (human_grid[j][i] & SHIP_MASK)
+			if (human_board.fleet & BOARD_CELL(x, y))
 			{
-				ledmatrix_draw_pixel_in_human_grid(i, j, COLOUR_ORANGE);
+				ledmatrix_draw_pixel_in_human_grid(x, y, COLOUR_ORANGE);
 			}
 		}
 	}
@@ -87,33 +74,25 @@ void initialise_game(void)
 	cursor_on = 1;
 }
 
-// A bitmask that marks a cell as hit
-#define HIT_MASK 128
-#define MISS_MASK 64
-#define SUNK_MASK 32
-
-const char* ship_names[] = {
-	"Sea", "Carrier", "Cruiser", "Destroyer", "Frigate", "Corvette", "Submarine"
-};
-
 // Handles the flashing of the cursor
 void flash_cursor(void)
 {
+	uint8_t cell = board_cell(&computer_board, cursor_x, cursor_y);
 	cursor_on = 1-cursor_on;
 	if (cursor_on){
-		if (computer_grid[cursor_y][cursor_x] & (HIT_MASK | MISS_MASK)) {
+		if (cell & (HIT_MASK | MISS_MASK)) {
 			// Flash dark yellow if cursor is at a location that cannot be fired at
 			ledmatrix_draw_pixel_in_computer_grid(cursor_x, cursor_y, COLOUR_DARK_YELLOW);
 		} else {
 			ledmatrix_draw_pixel_in_computer_grid(cursor_x, cursor_y, COLOUR_YELLOW);
 		}
 		
-	} else if (computer_grid[cursor_y][cursor_x] & (MISS_MASK)) {
+	} else if (cell & (MISS_MASK)) {
 		// If the cursor is on a location that was fired at and missed
 		ledmatrix_draw_pixel_in_computer_grid(cursor_x, cursor_y, COLOUR_GREEN);
-	} else if (computer_grid[cursor_y][cursor_x] & (SUNK_MASK)) {
+	} else if (cell & (SUNK_MASK)) {
 		ledmatrix_draw_pixel_in_computer_grid(cursor_x, cursor_y, COLOUR_DARK_RED);	
-	} else if (computer_grid[cursor_y][cursor_x] & (HIT_MASK)) {
+	} else if (cell & (HIT_MASK)) {
 		// If the cursor is on a location that was fired at and hit
 		ledmatrix_draw_pixel_in_computer_grid(cursor_x, cursor_y, COLOUR_RED);	
 	} else {
@@ -122,41 +101,25 @@ void flash_cursor(void)
 	}
 }
 
-// moves the position of the cursor by (dx, dy) such that if the cursor
-// started at (cursor_x, cursor_y) then after this function is called,
-// it should end at ( (cursor_x + dx) % WIDTH, (cursor_y + dy) % HEIGHT)
-// the cursor should be displayed after it is moved as well
+// Moves the cursor by (dx, dy), wrapping round the edges of the grid,
+// and shows it at its new place with the flashing cycle restarted
 void move_cursor(int8_t dx, int8_t dy) {
-	
-	//YOUR CODE HERE
-	/*suggestions for implementation:
-	 * 1: remove the display of the cursor at the current location
-	 *		(and replace it with whatever piece is at that location)
-	 * 2: update the positional knowledge of the cursor, this will include
-	 *		variables cursor_x, cursor_y and cursor_visible. Make sure you
-	 *		consider what should happen if the cursor moves off the board.
-	 * 3: display the cursor at the new location
-	 * 4: reset the cursor flashing cycle. See project.c for how the cursor
-	 *		is flashed.
-	 */
-	
-	#define WIDTH 8       
-	#define HEIGHT 8
-	
-	if (computer_grid[cursor_y][cursor_x] & SUNK_MASK) {
+	// Put back whatever is under the cursor
+	uint8_t cell = board_cell(&computer_board, cursor_x, cursor_y);
+	if (cell & SUNK_MASK) {
 		ledmatrix_draw_pixel_in_computer_grid(cursor_x, cursor_y, COLOUR_DARK_RED);
-	} else if (computer_grid[cursor_y][cursor_x] & HIT_MASK) {
+	} else if (cell & HIT_MASK) {
 		ledmatrix_draw_pixel_in_computer_grid(cursor_x, cursor_y, COLOUR_RED);
-	} else if (computer_grid[cursor_y][cursor_x] & MISS_MASK) {
+	} else if (cell & MISS_MASK) {
 		ledmatrix_draw_pixel_in_computer_grid(cursor_x, cursor_y, COLOUR_GREEN);
 	} else {
 		ledmatrix_draw_pixel_in_computer_grid(cursor_x, cursor_y, COLOUR_BLACK);
 	}
 	
-	// Update the position of the cursor	
-	cursor_y = (cursor_y + dy + HEIGHT) % HEIGHT;
-	cursor_x = (cursor_x + dx + WIDTH) % WIDTH;  
-	
+	// Update the position of the cursor. Moves merged in the input queue
+	// can be more than the grid is wide, so take off whole turns first.
+	cursor_y = (cursor_y + dy % GRID_NUM_ROWS + GRID_NUM_ROWS) % GRID_NUM_ROWS;
+	cursor_x = (cursor_x + dx % GRID_NUM_COLUMNS + GRID_NUM_COLUMNS) % GRID_NUM_COLUMNS;
 
 	// Display the cursor at the new location
 	ledmatrix_draw_pixel_in_computer_grid(cursor_x, cursor_y, COLOUR_YELLOW);
@@ -170,26 +133,25 @@ void move_cursor(int8_t dx, int8_t dy) {
 // The number of consecutive invalid moves the user has made
 int invalid_move_count = 0;
 
+// Messages for invalid moves, from TEXT_INVALID_MOVE_1 on
+#define INVALID_MOVE_MESSAGES 3
+
+// The invalid move message line is this wide
+#define MESSAGE_LINE_WIDTH 47
+
 // Message for invalid move
 void invalid_move_message() {
-	const char* messages[] = {
-		"Invalid move, please try again.",
-		"Select a different target!       ",
-		"Seriously? Select a different target!"
-	};
-	
-	// Counts the amount of messages
-	const int message_count = sizeof(messages) / sizeof(messages[0]);
-	
-	// Resets the location of the cursor
-	move_terminal_cursor(0, 20); 
-	
 	// Determines how many times the user has made an invalid move
-	if (invalid_move_count < message_count) {
-		printf("%s\n", messages[invalid_move_count]); 
+	TextId message;
+	if (invalid_move_count < INVALID_MOVE_MESSAGES) {
+		message = TEXT_INVALID_MOVE_1 + invalid_move_count;
 		} else {
-		printf("%s\n", messages[message_count - 1]); 
+		message = TEXT_INVALID_MOVE_1 + INVALID_MOVE_MESSAGES - 1;
 	}
+	
+	// Blanks out the rest of a longer message
+	uint8_t x = screen_write_text(0, 20, message);
+	screen_fill(x, 20, MESSAGE_LINE_WIDTH + 1 - x, ' ');
 	invalid_move_count++;
 }
 
@@ -200,47 +162,7 @@ void reset_invalid_move() {
 
 // Clears the message
 void clear_invalid_move_message() {
-	move_terminal_cursor(0, 20);  
-	printf("                                               \n");
-}
-
-typedef struct {
-	const char* name;
-	int size;
-	int hits;
-	int sunk;
-} Ship;
-
-Ship human_ships[] = {
-	{"Carrier", 6, 0, 0},
-	{"Cruiser", 4, 0, 0},
-	{"Destroyer", 3, 0, 0},
-	{"Frigate", 3, 0, 0},
-	{"Corvette", 2, 0, 0},
-	{"Submarine", 2, 0, 0}
-};
-
-Ship computer_ships[] = {
-	{"Carrier", 6, 0, 0},
-	{"Cruiser", 4, 0, 0},
-	{"Destroyer", 3, 0, 0},
-	{"Frigate", 3, 0, 0},
-	{"Corvette", 2, 0, 0},
-	{"Submarine", 2, 0, 0}
-};
-
-const char* initial_names[] = {
-	"Carrier", "Cruiser", "Destroyer", "Frigate", "Corvette", "Submarine"
-};
-int initial_sizes[] = {6, 4, 3, 3, 2, 2};
-	
-void reset_ships(Ship* ships) {
-	for (int i = 0; i < 6; i++) {
-		ships[i].name = initial_names[i];
-		ships[i].size = initial_sizes[i];
-		ships[i].hits = 0;
-		ships[i].sunk = 0;
-	}
+	screen_fill(0, 20, MESSAGE_LINE_WIDTH, ' ');
 }
 
 static int human_message_line = 0;
@@ -249,54 +171,29 @@ const int message_area_start = 1;
 const int message_area_width = 40;
 
 // Sends a message to the terminal when the ship is sunk
-void sunk_ship_message(const char* player, const char* ship) {
+void sunk_ship_message(Player player, uint8_t ship) {
 
 
-	if (strcmp(player, "human") == 0) {
-		// Message for when the player sinks a computer's ship
-		move_terminal_cursor(0, message_area_start + human_message_line);
-		printf("I Sunk Your %s", ship);
+	if (player == PLAYER_COMPUTER) {
+		// Message for when the computer sinks the player's ship
+		uint8_t y = message_area_start + human_message_line;
+		screen_write_text(screen_write_text(0, y, TEXT_COMPUTER_SANK), y, TEXT_SHIP_CARRIER + ship);
 		human_message_line++;
 		} else {
-		// Message for when the computer sinks the human's ship
-		move_terminal_cursor(message_area_width, message_area_start + computer_message_line);
-		printf("You Sunk My %s", ship);
+		// Message for when the player sinks a computer's ship
+		uint8_t y = message_area_start + computer_message_line;
+		screen_write_text(screen_write_text(message_area_width, y, TEXT_HUMAN_SANK), y,
+				TEXT_SHIP_CARRIER + ship);
 		computer_message_line++;
 	}
 }
 
-// Handles the sinking of ships
-void check_sunk_ships(Ship* ships, uint8_t grid[GRID_NUM_ROWS][GRID_NUM_COLUMNS], const char* player) {
-	for (int i = 0; i < sizeof(human_ships) / sizeof(human_ships[0]); i++) {
-		if (ships[i].sunk == 0 && ships[i].hits == ships[i].size) {
-			// Make the ship status as sunk
-			ships[i].sunk = 1;
-			
-			// Plays a  sound for when the ship is sunk
-			if (!is_muted && (strcmp(player, "computer") == 0)) {
-				play_sound("computer sink");
-				
-			} else if (!is_muted) {
-				play_sound("human sink");
-			}
-			
-			// Prints a message when a ship is sunk
-			sunk_ship_message(player, ships[i].name);
-			for (int y = 0; y < GRID_NUM_ROWS; y++) {
-				for (int x = 0; x < GRID_NUM_COLUMNS; x++) {
-					if ((grid[y][x] & SHIP_MASK) == i + 1) {
-						// Labels the ship as hit and sunk
-						grid[y][x] |= (HIT_MASK | SUNK_MASK);
-						if (strcmp(player, "computer") == 0) {
-							// Makes the computer's ship dark to symbolist it being hit
-							ledmatrix_draw_pixel_in_computer_grid(x, y, COLOUR_DARK_RED);
-						} else {
-							// Makes the player's ship dark to symbolize it being hit
-							ledmatrix_draw_pixel_in_human_grid(x, y, COLOUR_DARK_RED);
-						}
-					}
-				}
-			}
+// Posts an event for each ship on the board the shooter has just sunk
+void check_sunk_ships(Board* board, Player shooter) {
+	uint8_t newly_sunk = board_update_sunk(board);
+	for (uint8_t i = 0; i < NUM_SHIPS; i++) {
+		if (newly_sunk & (1 << i)) {
+			event_post(EVENT_SUNK, shooter, board->cells[i].first, i);
 		} 
 	} 
 }
@@ -310,92 +207,145 @@ int computer_target_y = 7;
 // Computer starts in search mode
 int is_search_mode = 1;
 
-// Checks if the randomly generated coordinate is valid
-// Implemented in search mode in computer_turn()
-static uint8_t is_valid_coordinate(uint8_t x, uint8_t y) {
-	return x < GRID_NUM_COLUMNS && y < GRID_NUM_ROWS;
-}
-
-// Contains the cells that still needs to be fired at by the computer in destroy mode
-static uint8_t cells_to_hit[GRID_NUM_ROWS * GRID_NUM_COLUMNS][2];
-
-static uint8_t cells_to_hit_count = 0;
-
-static const int8_t directions[4][2] = {
-	{1, 0},  // Right
-	{0, 1},  // Down
-	{-1, 0}, // Left
-	{0, -1}  // Up
-};
+// The cells destroy mode fires at: those next to hits on ships that
+// haven't been sunk, which haven't been fired at yet
+static Bitboard frontier;
 
 static uint8_t last_hit_x = 0;
 static uint8_t last_hit_y = 0;
 
-// Adds the adjacent cells that still needs to be hit into the cells_to_hit array
+// Where Probability Hunt is in the opening book
+static uint8_t book_node = 0;
+
+// Search and Destroy's and Probability Hunt's next target, worked out by
+// computer_think() while the human aims. Only the computer's own shots
+// change the human's grid (and the frontier), so it stays good until the
+// next of those lands. NO_TARGET if there is nothing left to fire at.
+#define NO_TARGET 0xFF
+static uint8_t planned_cell;
+static uint8_t plan_ready = 0;
+
+// Adds the adjacent cells that still need to be hit to the frontier
 void add_adjacent_cells_to_hit(uint8_t x, uint8_t y) {
-	for (int i = 0; i < 4; i++) {
-		uint8_t adj_x = x + directions[i][0];
-		uint8_t adj_y = y + directions[i][1];
-		
-		if (is_valid_coordinate(adj_x, adj_y) && !(human_grid[adj_y][adj_x] & (HIT_MASK | MISS_MASK))) {
-			cells_to_hit[cells_to_hit_count][0] = adj_x;
-			cells_to_hit[cells_to_hit_count][1] = adj_y;
-			cells_to_hit_count++;
-		}
+	frontier |= board_neighbours(BOARD_CELL(x, y)) & ~human_board.fired;
+}
+
+// Picks the next destroy mode target from the frontier. Once the last hit
+// is next to another hit the ship's direction is known, so cells along
+// that line are tried first.
+static uint8_t pick_destroy_target(void) {
+	Bitboard candidates = frontier & ~human_board.fired;
+	Bitboard unsunk_hits = human_board.hit & ~human_board.sunk;
+	Bitboard last_hit = BOARD_CELL(last_hit_x, last_hit_y);
+	Bitboard in_line = 0;
+	
+	if (board_neighbours_horizontal(last_hit) & unsunk_hits) {
+		in_line |= board_neighbours_horizontal(unsunk_hits & BOARD_ROW(last_hit_y));
+	}
+	if (board_neighbours_vertical(last_hit) & unsunk_hits) {
+		in_line |= board_neighbours_vertical(unsunk_hits & BOARD_COLUMN(last_hit_x));
+	}
+	if (candidates & in_line) {
+		candidates &= in_line;
+	}
+	return board_select(candidates, rand() % board_count(candidates));
+}
+
+// Search and Destroy's next target: a random cell not yet fired at in
+// search mode, a cell on the frontier in destroy mode
+static uint8_t search_and_destroy_target(void) {
+	if (!(frontier & ~human_board.fired)) {
+		// Nothing left to destroy
+		is_search_mode = 1;
+	}
+	if (!is_search_mode) {
+		return pick_destroy_target();
+	}
+	
+	// Search mode - one random draw from the cells not yet fired at
+	if (human_unfired.count == 0) {
+		return NO_TARGET;
 	}
+	return cell_pool_get(&human_unfired, rand() % human_unfired.count);
 }
 
-// Firing animation
+// Firing animation: the target flashes yellow and red three times, one
+// step every FIRE_ANIMATION_STEP_MS, then the shot is resolved. It runs
+// from update_computer_fire_animation() in the main loop so the game
+// carries on while it plays.
+#define FIRE_ANIMATION_STEPS 6
+#define FIRE_ANIMATION_STEP_MS 50
+
+// The computer's shot being animated, the animation step it is on and
+// when that step started
+static uint8_t shot_x, shot_y;
+static uint8_t animation_step;
+static uint32_t animation_step_time;
+
+// Non-zero to land the computer's shots without the animation
+static uint8_t animation_skipped;
+
+static void resolve_computer_shot(void);
+
+void set_fire_animation(uint8_t on) {
+	animation_skipped = !on;
+}
+
 void computer_fire_animation(uint8_t target_x, uint8_t target_y) {
-	// Example animation: flash the target location a few times
+	shot_x = target_x;
+	shot_y = target_y;
+	animation_step = 0;
+	animation_step_time = get_current_time();
 	animation_running = 1;
-	for (int i = 0; i < 3; i++) {
-		// Flash target location
-		ledmatrix_draw_pixel_in_human_grid(target_x, target_y, COLOUR_YELLOW);
-		_delay_ms(50);
-		// Turn off the flash
-		ledmatrix_draw_pixel_in_human_grid(target_x, target_y, COLOUR_RED);
-		_delay_ms(50);
+	
+	// Flash target location
+	ledmatrix_draw_pixel_in_human_grid(target_x, target_y, COLOUR_YELLOW);
+	
+	if (animation_skipped) {
+		finish_computer_fire_animation();
 	}
-	animation_running = 0;
 }
 
+void update_computer_fire_animation(void) {
+	if (!animation_running) {
+		return;
+	}
+	uint32_t current_time = get_current_time();
+	while (animation_running && current_time - animation_step_time >= FIRE_ANIMATION_STEP_MS) {
+		animation_step_time += FIRE_ANIMATION_STEP_MS;
+		animation_step++;
+		if (animation_step == FIRE_ANIMATION_STEPS) {
+			animation_running = 0;
+			resolve_computer_shot();
+		} else if (animation_step & 1) {
+			// Turn off the flash
+			ledmatrix_draw_pixel_in_human_grid(shot_x, shot_y, COLOUR_RED);
+		} else {
+			ledmatrix_draw_pixel_in_human_grid(shot_x, shot_y, COLOUR_YELLOW);
+		}
+	}
+}
+
+void finish_computer_fire_animation(void) {
+	if (animation_running) {
+		animation_running = 0;
+		resolve_computer_shot();
+	}
+}
+
+// Chooses the computer's target and starts the firing animation. The shot
+// takes effect when the animation finishes.
 void computer_turn() {
+	// A shot still being animated takes effect first (and is part of the
+	// last turn, as far as the benchmark is concerned)
+	finish_computer_fire_animation();
+	
+	BENCH_MARK(BENCH_TURN_START);
+	
 	// Computer turn in basic mode
-	if (strcmp(mode, "Basic Moves       ") == 0) {
-		uint8_t cell_value = human_grid[computer_target_y][computer_target_x];
-		
+	if (game_mode == MODE_BASIC) {
 		 // Play animation
 		 computer_fire_animation(computer_target_x, computer_target_y);
-		 
-		// Colors the grid
-		if (human_grid[computer_target_y][computer_target_x] & SHIP_MASK) {
-			// Plays sound
-			if (!is_muted) {
-				play_sound("human hit");
-			}
-			
-			// Add hits to the ship
-			uint8_t ship_type = cell_value & SHIP_MASK;
-			human_ships[ship_type - 1].hits++;
-		
-			// Marks the target as hit
-			human_grid[computer_target_y][computer_target_x] |= HIT_MASK;
-		
-			// Colors it red since there is a ship
-			ledmatrix_draw_pixel_in_human_grid(computer_target_x, computer_target_y, COLOUR_RED);
-		
-			// Checks if a player's ship is sunk
-			check_sunk_ships(human_ships, human_grid, "human");
-			
-			} else {
-			
-				// Marks the target as missed
-				human_grid[computer_target_y][computer_target_x] |= MISS_MASK;
-			
-				// Colors it green if there is no ship
-				ledmatrix_draw_pixel_in_human_grid(computer_target_x, computer_target_y, COLOUR_GREEN);
-		}
 	
 		// Move to the next target position
 		computer_target_x++;
@@ -404,125 +354,125 @@ void computer_turn() {
 			computer_target_y--;
 		}
 		
-	} else  if (strcmp(mode, "Search and Destroy") == 0) {
-		// Logic for Search and Destroy mode
-		if (is_search_mode) {
-			
-			// Search mode
-			do {
-				 computer_target_x = rand() % GRID_NUM_COLUMNS;
-				 computer_target_y = rand() % GRID_NUM_ROWS;
-				 
-			} while (!is_valid_coordinate(computer_target_x, computer_target_y) || (human_grid[computer_target_y][computer_target_x] & (HIT_MASK | MISS_MASK)));
-			
-			 if (!is_valid_coordinate(computer_target_x, computer_target_y)) {
-				 return;
-			 }
-
-			uint8_t cell_value = human_grid[computer_target_y][computer_target_x];
-			
-			// Play animation
-			computer_fire_animation(computer_target_x, computer_target_y);
-			
-			if (human_grid[computer_target_y][computer_target_x] & SHIP_MASK) {
-				// Plays sound
-				if (!is_muted) {
-					play_sound("human hit");
-				}
-				
-				// Enters destroy mode
-				is_search_mode = 0;
-				
-				// Add hits to the ship
-				uint8_t ship_type = cell_value & SHIP_MASK;
-				human_ships[ship_type - 1].hits++;
-				
-				// Marks the target as hit
-				human_grid[computer_target_y][computer_target_x] |= HIT_MASK;
-				
-				// Colors it red if there is a ship
-				ledmatrix_draw_pixel_in_human_grid(computer_target_x, computer_target_y, COLOUR_RED);
-				
-				// Checks if a player's ship is sunk
-				check_sunk_ships(human_ships, human_grid, "human");
-				
-				// Add adjacent cells to the cells_to_hit array
-				add_adjacent_cells_to_hit(computer_target_x, computer_target_y);
-
-				} else {
-				// Remains in search mode
-				is_search_mode = 1;
-					
-				// Marks the target as a miss
-				human_grid[computer_target_y][computer_target_x] |= MISS_MASK;
-				
-				// Colors it green
-				ledmatrix_draw_pixel_in_human_grid(computer_target_x, computer_target_y, COLOUR_GREEN);
-			}
+	} else  if (game_mode == MODE_SEARCH_AND_DESTROY) {
+		// Logic for Search and Destroy mode, unless it was worked out
+		// while the human was aiming
+		uint8_t cell = plan_ready ? planned_cell : search_and_destroy_target();
+		plan_ready = 0;
+		if (cell == NO_TARGET) {
+			BENCH_MARK(BENCH_TURN_END);
+			return;
+		}
 		
-		} else if (!is_search_mode) {
-			// Destroy mode
-			
-			 // Initialize x and y to default values
-			 uint8_t x = 0, y = 0;
-			 
-			if (cells_to_hit_count > 0) {
-				// Select randomly from cells_to_hit array
-				uint8_t index = rand() % cells_to_hit_count;
-				x = cells_to_hit[index][0];
-				y = cells_to_hit[index][1];
-
-				// Remove the selected cell from the array
-				cells_to_hit_count--;
-				for (int i = index; i < cells_to_hit_count; i++) {
-					cells_to_hit[i][0] = cells_to_hit[i + 1][0];
-					cells_to_hit[i][1] = cells_to_hit[i + 1][1];
-				}
+		// Play animation
+		computer_fire_animation(cell % GRID_NUM_COLUMNS, cell / GRID_NUM_COLUMNS);
+	} else if (game_mode == MODE_PROBABILITY_HUNT) {
+		// Fire where the ships that are left fit in the most ways,
+		// bringing a limited number of rows and columns up to date first
+		if (human_unfired.count == 0) {
+			BENCH_MARK(BENCH_TURN_END);
+			return;
+		}
+		// The first few shots come from the opening book
+		uint8_t cell;
+		if (plan_ready) {
+			// Worked out while the human was aiming
+			cell = planned_cell;
+		} else {
+			heatmap_update(HEATMAP_LINES_PER_TURN);
+			if (opening_book_has(book_node)) {
+				cell = opening_book_shot(book_node);
+			} else {
+				cell = heatmap_best(rand() % (GRID_NUM_ROWS * GRID_NUM_COLUMNS));
 			}
-			
-			 uint8_t cell_value = human_grid[y][x];
-			 
-			// Play animation
-			computer_fire_animation(x, y);
-
-			 if (human_grid[y][x] & SHIP_MASK) {
-				 // Plays sound
-				 if (!is_muted) {
-					 play_sound("human hit");
-				 }
-				 
-				 // Add hits to the ship
-				 uint8_t ship_type = cell_value & SHIP_MASK;
-				 human_ships[ship_type - 1].hits++;
-				 
-				 // Marks the target as hit
-				 human_grid[y][x] |= HIT_MASK;
-				 
-				 // Colors it red if there is a ship
-				 ledmatrix_draw_pixel_in_human_grid(x, y, COLOUR_RED);
-				 
-				 // Checks if a player's ship is sunk
-				 check_sunk_ships(human_ships, human_grid, "human");
-				
-				 // Add adjacent cells to the cells_to_hit array
-				 add_adjacent_cells_to_hit(x, y);
-
-				 // Enter destroy mode
-				 is_search_mode = 0;
-				 last_hit_x = x;
-				 last_hit_y = y;
-				 
-				 } else {
-				 // Miss logic
-				 human_grid[y][x] |= MISS_MASK;
-				 ledmatrix_draw_pixel_in_human_grid(x, y, COLOUR_GREEN);
-
-				 if (cells_to_hit_count == 0) {
-					 is_search_mode = 1;  
-				 }
-			 }			
-		}	
+		}
+		plan_ready = 0;
+		
+		// Play animation
+		computer_fire_animation(cell % GRID_NUM_COLUMNS, cell / GRID_NUM_COLUMNS);
 	}
+	
+	BENCH_MARK(BENCH_TURN_END);
+}
+
+// Basic mode's next target is just the next cell, so there is nothing to
+// work out ahead
+uint8_t computer_thinking(void) {
+	return !plan_ready && !animation_running && game_mode != MODE_BASIC;
+}
+
+void computer_think(void) {
+	if (!computer_thinking()) {
+		return;
+	}
+	
+	// Search and Destroy's target takes one go
+	if (game_mode == MODE_SEARCH_AND_DESTROY) {
+		planned_cell = search_and_destroy_target();
+		plan_ready = 1;
+		return;
+	}
+	
+	// One row or column at a time, then pick the target
+	if (heatmap_update(1)) {
+		return;
+	}
+	if (opening_book_has(book_node)) {
+		planned_cell = opening_book_shot(book_node);
+	} else {
+		planned_cell = heatmap_best(rand() % (GRID_NUM_ROWS * GRID_NUM_COLUMNS));
+	}
+	plan_ready = 1;
+}
+
+// The computer's shot lands once its animation has finished
+static void resolve_computer_shot(void) {
+	BENCH_MARK(BENCH_SHOT_START);
+	
+	uint8_t x = shot_x;
+	uint8_t y = shot_y;
+	uint8_t search_and_destroy = game_mode == MODE_SEARCH_AND_DESTROY;
+	
+	// Marks the target as fired at, and hit if there is a ship
+	Bitboard sunk_before = human_board.sunk;
+	cell_pool_remove(&human_unfired, x, y);
+	frontier &= ~BOARD_CELL(x, y);
+	event_post(EVENT_SHOT_FIRED, PLAYER_COMPUTER, y * GRID_NUM_COLUMNS + x, 0);
+	uint8_t hit = board_fire(&human_board, BOARD_CELL(x, y)) != 0;
+	plan_ready = 0;
+	if (opening_book_has(book_node)) {
+		book_node = opening_book_next(book_node, hit);
+	}
+	if (hit) {
+		event_post(EVENT_HIT, PLAYER_COMPUTER, y * GRID_NUM_COLUMNS + x, 0);
+		
+		// Checks if a player's ship is sunk
+		check_sunk_ships(&human_board, PLAYER_COMPUTER);
+		
+		if (search_and_destroy) {
+			// Add adjacent cells to the frontier and enter destroy
+			// mode. Cells that were only there for ships now sunk are
+			// dropped.
+			add_adjacent_cells_to_hit(x, y);
+			frontier &= board_neighbours(human_board.hit & ~human_board.sunk);
+			is_search_mode = 0;
+			last_hit_x = x;
+			last_hit_y = y;
+		}
+	} else {
+		event_post(EVENT_MISS, PLAYER_COMPUTER, y * GRID_NUM_COLUMNS + x, 0);
+		
+		// Back to searching once there is nothing left to destroy
+		if (search_and_destroy && !frontier) {
+			is_search_mode = 1;
+		}
+	}
+	
+	// The placement counts for the shot's row and column are now out
+	// of date (all of them if a ship was sunk)
+	heatmap_shot(x, y, human_board.sunk & ~sunk_before);
+	
+	BENCH_MARK(BENCH_SHOT_END);
 }
 
 // Returns 1 if the move is valid
@@ -530,7 +480,7 @@ uint8_t move_is_valid() {
 	uint8_t target_x = cursor_x;
 	uint8_t target_y = cursor_y;
 	// Check if cursor on the computer's grid contains a ship	
-	if (computer_grid[target_y][target_x] & (HIT_MASK | MISS_MASK)) {
+	if (board_fired_at(&computer_board, target_x, target_y)) {
 		// The firing location is invalid
 		invalid_move_message();
 		return 0;
@@ -539,452 +489,215 @@ uint8_t move_is_valid() {
 	}
 }
 
-void fire_at_location(int8_t dx, int8_t dy) {
-	uint8_t target_x = cursor_x + dx;
-	uint8_t target_y = cursor_y + dy;
-	uint8_t cell_value = computer_grid[target_y][target_x];
-	
-	if (computer_grid[target_y][target_x] & SHIP_MASK) {
-		// Mark location as hit if it's not already fired upon
-		computer_grid[target_y][target_x] |= HIT_MASK;
-			
-		// Add hits to the ship
-		uint8_t ship_type = cell_value & SHIP_MASK;
-		computer_ships[ship_type - 1].hits++;
-		
-
-		// Plays a  sound for when the ship is hit but not sunk
-		if (!is_muted) {
-			play_sound("computer hit");
-		}	
-			
-		// Check if a computer's ship is sunk
-		check_sunk_ships(computer_ships, computer_grid, "computer");
-			
-		clear_invalid_move_message();
-		reset_invalid_move();
-
-	} else {
-		// Mark location as miss
-		computer_grid[target_y][target_x] |= MISS_MASK;
-		
-		clear_invalid_move_message();
-		reset_invalid_move();
-	}
-}
-
-// Logic for playing the sound effect
-void play_sound(const char *event) {
-
-	if (strcmp(event, "computer hit") == 0) {
-		// Sound effect for when the human hits the computer's ship
-		// Single tone 
-		
-		// First beep
-		uint16_t freq = 200; // Hz
-		float dutycycle = 50; // 50%
-		uint16_t clockperiod = freq_to_clock_period(freq);
-		uint16_t pulsewidth = duty_cycle_to_pulse_width(dutycycle, clockperiod);
-		
-		sound_on(freq, dutycycle, clockperiod, pulsewidth);
-		_delay_ms(50);		
-		sound_off();
-		
-				
-	} else if (strcmp(event, "human hit") == 0) {
-		// Sound effect for when the computer hits the humans ship
-		// Single tone
-		// More "corrupted"-sounding than human hit
-		
-		uint16_t baseFreq = 100; // Hz
-		float baseDutyCycle = 50; // 50%
-		uint16_t duration = 200; // ms
-
-		uint16_t clockperiod = freq_to_clock_period(baseFreq);
-		uint16_t pulsewidth = duty_cycle_to_pulse_width(baseDutyCycle, clockperiod);
-		for (uint16_t i = 0; i < duration; ++i) {
-			// Introduce more variation for a corrupted effect
-			uint16_t freq = baseFreq + (rand() % (baseFreq / 5)) - (baseFreq / 10);
-			float dutycycle = baseDutyCycle + ((rand() % 20) - 10) / 100.0;
-
-			clockperiod = freq_to_clock_period(freq);
-			pulsewidth = duty_cycle_to_pulse_width(dutycycle, clockperiod);
-
-			sound_on(freq, dutycycle, clockperiod, pulsewidth);
-		}
-		
-		sound_off();
-		
-	} else if (strcmp(event, "computer sink") == 0) {
-		// Sound effect for when the human sinks the computer's ship
-		// Series of tones
-		// Fancier tone than "hit"
-		
-		uint16_t freq = 200; // Hz
-		float dutycycle = 50; // 50%
-		uint16_t clockperiod = freq_to_clock_period(freq);
-		uint16_t pulsewidth = duty_cycle_to_pulse_width(dutycycle, clockperiod);
-		
-		sound_on(freq, dutycycle, clockperiod, pulsewidth);
-		_delay_ms(100);
-		
-		freq = 300; // Hz
-		dutycycle = 50; // 50%
-		clockperiod = freq_to_clock_period(freq);
-		pulsewidth = duty_cycle_to_pulse_width(dutycycle, clockperiod);
-		
-		sound_on(freq, dutycycle, clockperiod, pulsewidth);
-		_delay_ms(100);
-		
-		sound_off();
-		
-	} else if (strcmp(event, "human sink") == 0) {
-		// Sound effect for when the computer sinks the humans ship
-		// Series of tones
-		// Fancier tone than "hit"
-		
-		// First beep
-		uint16_t baseFreq = 400; // Hz
-		float baseDutyCycle = 50; // 50%
-		uint16_t duration = 200; // ms
-
-		uint16_t clockperiod = freq_to_clock_period(baseFreq);
-		uint16_t pulsewidth = duty_cycle_to_pulse_width(baseDutyCycle, clockperiod);
-		
-		for (uint16_t i = 0; i < duration; ++i) {
-			uint16_t freq = baseFreq + (rand() % (baseFreq / 10)) - (baseFreq / 20);
-			float dutycycle = baseDutyCycle + ((rand() % 10) - 5) / 100;
-
-			clockperiod = freq_to_clock_period(freq);
-			pulsewidth = duty_cycle_to_pulse_width(dutycycle, clockperiod);
-
-			sound_on(freq, dutycycle, clockperiod, pulsewidth);
-		}
-		
-		// Second higher pitched beep
-		baseFreq = 600; // Hz
-		baseDutyCycle = 50; // 50%
-		duration = 200; // ms
-
-		clockperiod = freq_to_clock_period(baseFreq);
-		pulsewidth = duty_cycle_to_pulse_width(baseDutyCycle, clockperiod);
-		for (uint16_t i = 0; i < duration; ++i) {
-			uint16_t freq = baseFreq + (rand() % (baseFreq / 10)) - (baseFreq / 20);
-			float dutycycle = baseDutyCycle + ((rand() % 10) - 5) / 100;
-
-			clockperiod = freq_to_clock_period(freq);
-			pulsewidth = duty_cycle_to_pulse_width(dutycycle, clockperiod);
-
-			sound_on(freq, dutycycle, clockperiod, pulsewidth);
-		}
-		
-		sound_off();
-		
-	} else if (strcmp(event, "human wins") == 0) {
-		// Sound effect for when the human wins
-		// Series of tones
-		// Fancier than "sink"
-			uint16_t freq = 800; // Hz
-			float dutycycle = 50; // 50%
-			uint16_t clockperiod = freq_to_clock_period(freq);
-			uint16_t pulsewidth = duty_cycle_to_pulse_width(dutycycle, clockperiod);
-			
-			sound_on(freq, dutycycle, clockperiod, pulsewidth);
-			_delay_ms(250);
-			sound_off();
-			
-			_delay_ms(50);
-			sound_on(freq, dutycycle, clockperiod, pulsewidth);
-			_delay_ms(100);
-			sound_off();
-			
-			_delay_ms(50);
-			sound_on(freq, dutycycle, clockperiod, pulsewidth);
-			_delay_ms(100);
-			sound_off();
-			
-			_delay_ms(50);
-			sound_on(freq, dutycycle, clockperiod, pulsewidth);
-			_delay_ms(800);
-			
-			sound_off();
-		
-	} else if (strcmp(event, "computer wins") == 0) {
-		// Sound effect for when the computer wins
-		// Series of tones
-		// Fancier than "sink"
-		// First beep
-		uint16_t baseFreq = 500; // Hz
-		float baseDutyCycle = 50; // 50%
-		uint16_t duration = 300; // ms
-
-		uint16_t clockperiod = freq_to_clock_period(baseFreq);
-		uint16_t pulsewidth = duty_cycle_to_pulse_width(baseDutyCycle, clockperiod);
-		
-		for (uint16_t i = 0; i < duration; ++i) {
-			uint16_t freq = baseFreq + (rand() % (baseFreq / 10)) - (baseFreq / 20);
-			float dutycycle = baseDutyCycle + ((rand() % 10) - 5) / 100;
-
-			clockperiod = freq_to_clock_period(freq);
-			pulsewidth = duty_cycle_to_pulse_width(dutycycle, clockperiod);
-
-			sound_on(freq, dutycycle, clockperiod, pulsewidth);
-		}
-		
-		
-		// Second lower pitched beep
-		baseFreq = 400; // Hz
-		baseDutyCycle = 50; // 50%
-		duration = 300; // ms
-
-		clockperiod = freq_to_clock_period(baseFreq);
-		pulsewidth = duty_cycle_to_pulse_width(baseDutyCycle, clockperiod);
-		
-		for (uint16_t i = 0; i < duration; ++i) {
-			uint16_t freq = baseFreq + (rand() % (baseFreq / 10)) - (baseFreq / 20);
-			float dutycycle = baseDutyCycle + ((rand() % 10) - 5) / 100;
-
-			clockperiod = freq_to_clock_period(freq);
-			pulsewidth = duty_cycle_to_pulse_width(dutycycle, clockperiod);
-
-			sound_on(freq, dutycycle, clockperiod, pulsewidth);
-		}
-		
-		// Third even lower pitched beep
-		baseFreq = 300; // Hz
-		baseDutyCycle = 50; // 50%
-		duration = 300; // ms
-
-		clockperiod = freq_to_clock_period(baseFreq);
-		pulsewidth = duty_cycle_to_pulse_width(baseDutyCycle, clockperiod);
-		for (uint16_t i = 0; i < duration; ++i) {
-			uint16_t freq = baseFreq + (rand() % (baseFreq / 10)) - (baseFreq / 20);
-			float dutycycle = baseDutyCycle + ((rand() % 10) - 5) / 100;
-
-			clockperiod = freq_to_clock_period(freq);
-			pulsewidth = duty_cycle_to_pulse_width(dutycycle, clockperiod);
-
-			sound_on(freq, dutycycle, clockperiod, pulsewidth);
-		}
-		
-		// Fourth even lower pitched beep
-		baseFreq = 200; // Hz
-		baseDutyCycle = 50; // 50%
-		duration = 300; // ms
-
-		clockperiod = freq_to_clock_period(baseFreq);
-		pulsewidth = duty_cycle_to_pulse_width(baseDutyCycle, clockperiod);
-		for (uint16_t i = 0; i < duration; ++i) {
-			uint16_t freq = baseFreq + (rand() % (baseFreq / 10)) - (baseFreq / 20);
-			float dutycycle = baseDutyCycle + ((rand() % 10) - 5) / 100;
-
-			clockperiod = freq_to_clock_period(freq);
-			pulsewidth = duty_cycle_to_pulse_width(dutycycle, clockperiod);
-
-			sound_on(freq, dutycycle, clockperiod, pulsewidth);
-		}
-		
-		// Fifth lowest pitched beep
-		baseFreq = 100; // Hz
-		baseDutyCycle = 50; // 50%
-		duration = 300; // ms
-
-		clockperiod = freq_to_clock_period(baseFreq);
-		pulsewidth = duty_cycle_to_pulse_width(baseDutyCycle, clockperiod);
-		for (uint16_t i = 0; i < duration; ++i) {
-			uint16_t freq = baseFreq + (rand() % (baseFreq / 10)) - (baseFreq / 20);
-			float dutycycle = baseDutyCycle + ((rand() % 10) - 5) / 100;
-
-			clockperiod = freq_to_clock_period(freq);
-			pulsewidth = duty_cycle_to_pulse_width(dutycycle, clockperiod);
-
-			sound_on(freq, dutycycle, clockperiod, pulsewidth);
+// Fires at every cell in targets, posting a hit or miss for each one not
+// already fired at
+static void fire_at_cells(Bitboard targets) {
+	Bitboard fresh = targets & ~computer_board.fired;
+	event_post(EVENT_SHOT_FIRED, PLAYER_HUMAN, cursor_y * GRID_NUM_COLUMNS + cursor_x, 0);
+	Bitboard hits = board_fire(&computer_board, targets);
+	for (uint8_t y = 0; y < GRID_NUM_ROWS; y++) {
+		if (!(fresh & BOARD_ROW(y))) {
+			continue;
+		}
+		for (uint8_t x = 0; x < GRID_NUM_COLUMNS; x++) {
+			if (fresh & BOARD_CELL(x, y)) {
+				event_post(hits & BOARD_CELL(x, y) ? EVENT_HIT : EVENT_MISS, PLAYER_HUMAN,
+						y * GRID_NUM_COLUMNS + x, 0);
+			}
 		}
-		
-		sound_off();
 	}
-
-}
-
-// The sound itself in its on state
-void sound_on(uint16_t freq, float dutycycle, uint16_t clockperiod, uint16_t pulsewidth) {
-		
-	OCR1A = clockperiod - 1;
-	OCR1B = (pulsewidth > 0) ? (pulsewidth - 1) : 0;
-
-	// Set up Timer/Counter 1 for Fast PWM, counting from 0 to the value in OCR1A
-	// before resetting to 0. Count at 1MHz (CLK/8).
-	TCCR1A = (1 << COM1B1) | (1 << WGM11) | (1 << WGM10);
-	TCCR1B = (1 << WGM13) | (1 << WGM12) | (0 << CS12) | (1 << CS11) | (0 << CS10);
-		
+	if (hits) {
+		// Check if a computer's ship is sunk
+		check_sunk_ships(&computer_board, PLAYER_HUMAN);
+	}
 	
+	reset_invalid_move();
 }
 
-// Turns off the sound
-void sound_off() {
-	// Turn off the PWM
-	TCCR1A &= ~(1 << COM1B1);
+void fire_at_location(int8_t dx, int8_t dy) {
+	fire_at_cells(BOARD_CELL(cursor_x + dx, cursor_y + dy));
 }
 
 // Fires at a location and its surrounding cells
 void fire_around_location() {
-	for (int8_t dy = -1; dy <= 1; dy++) {
-		for (int8_t dx = -1; dx <= 1; dx++) {
-
-			int target_x = cursor_x + dx;
-			int target_y = cursor_y + dy;
-
-			// Ensures the target is within the grid
-			if (target_x < 0 || target_x >= GRID_NUM_COLUMNS || target_y < 0 || target_y >= GRID_NUM_ROWS) {
-				continue;
-			}
-
-			//uint8_t cell_value = computer_grid[target_y][target_x];
-			
-			// Fires at the location
-			fire_at_location(dx, dy);
-
-			if (computer_grid[target_y][target_x] & SUNK_MASK) {
-				ledmatrix_draw_pixel_in_computer_grid(target_x, target_y, COLOUR_DARK_RED);
-				} else if (computer_grid[target_y][target_x] & HIT_MASK) {
-				ledmatrix_draw_pixel_in_computer_grid(target_x, target_y, COLOUR_RED);
-				} else if (computer_grid[target_y][target_x] & MISS_MASK) {
-				ledmatrix_draw_pixel_in_computer_grid(target_x, target_y, COLOUR_GREEN);
-				} 
-		}
-	}
+	fire_at_cells(board_area(cursor_x, cursor_y));
 }
 
 // Fires at a location and its entire row
 void fire_in_row() {
-	int target_y = cursor_y;
-	
-	// Fire at every location in the current row
-	for (int8_t x = 0; x < GRID_NUM_ROWS; x++)
-	{
-		int target_x = x;
-		fire_at_location(-cursor_x + x, 0);
-		if (computer_grid[target_y][target_x] & SUNK_MASK) {
-			ledmatrix_draw_pixel_in_computer_grid(target_x, target_y, COLOUR_DARK_RED);
-			} else if (computer_grid[target_y][target_x] & HIT_MASK) {
-			ledmatrix_draw_pixel_in_computer_grid(target_x, target_y, COLOUR_RED);
-			} else if (computer_grid[target_y][target_x] & MISS_MASK) {
-			ledmatrix_draw_pixel_in_computer_grid(target_x, target_y, COLOUR_GREEN);
-		}
-	}
+	fire_at_cells(BOARD_ROW(cursor_y));
 }
 
 void fire_in_column() {
-	int target_x = cursor_x;
-		
-	// Fire at every location in the current row
-	for (int8_t y = 0; y < GRID_NUM_COLUMNS; y++)
-	{
-		int target_y = y;
-		fire_at_location(0, -cursor_y + y);
-		if (computer_grid[target_y][target_x] & SUNK_MASK) {
-			ledmatrix_draw_pixel_in_computer_grid(target_x, target_y, COLOUR_DARK_RED);
-			} else if (computer_grid[target_y][target_x] & HIT_MASK) {
-			ledmatrix_draw_pixel_in_computer_grid(target_x, target_y, COLOUR_RED);
-			} else if (computer_grid[target_y][target_x] & MISS_MASK) {
-			ledmatrix_draw_pixel_in_computer_grid(target_x, target_y, COLOUR_GREEN);
-		}
-	}
+	fire_at_cells(BOARD_COLUMN(cursor_x));
+}
+
+// The LED matrix grid showing a player's board
+static void draw_pixel_in_grid(Player owner, uint8_t x, uint8_t y, PixelColour colour) {
+	if (owner == PLAYER_COMPUTER) {
+		ledmatrix_draw_pixel_in_computer_grid(x, y, colour);
+	} else {
+		ledmatrix_draw_pixel_in_human_grid(x, y, colour);
+	}
 }
 
 // Lights are all the unlit LEDs when game is over
-void game_over_board(Ship* ships, uint8_t grid[GRID_NUM_ROWS][GRID_NUM_COLUMNS], const char* player) {
-	for (int i = 0; i < sizeof(human_ships) / sizeof(human_ships[0]); i++) {
-		for (int y = 0; y < GRID_NUM_ROWS; y++) {
-			for (int x = 0; x < GRID_NUM_COLUMNS; x++) {
-				uint8_t cell_value = grid[y][x];
-				
-				// Colors every location that has not been fired at
-				if (!(cell_value & (HIT_MASK | MISS_MASK | SUNK_MASK))) {
-					if (cell_value & (SHIP_MASK)) {
-						if (strcmp(player, "computer") == 0) {
-							ledmatrix_draw_pixel_in_computer_grid(x, y, COLOUR_DARK_ORANGE);
-							} else {
-							ledmatrix_draw_pixel_in_human_grid(x, y, COLOUR_DARK_ORANGE);
-						}
-					} else {
-						if (strcmp(player, "computer") == 0) {
-							ledmatrix_draw_pixel_in_computer_grid(x, y, COLOUR_DARK_GREEN);
-							} else {
-							ledmatrix_draw_pixel_in_human_grid(x, y, COLOUR_DARK_GREEN);
-						}
-					}
-					
+void game_over_board(const Board* board, Player owner) {
+	for (uint8_t y = 0; y < GRID_NUM_ROWS; y++) {
+		for (uint8_t x = 0; x < GRID_NUM_COLUMNS; x++) {
+			Bitboard cell = BOARD_CELL(x, y);
+			
+			// Colors every location that has not been fired at
+			if (!(board->fired & cell)) {
+				if (board->fleet & cell) {
+					draw_pixel_in_grid(owner, x, y, COLOUR_DARK_ORANGE);
+				} else {
+					draw_pixel_in_grid(owner, x, y, COLOUR_DARK_GREEN);
 				}
-           
 			}
-			
 		}
 	}
-	
 }
 
 // Returns 1 if the game is over, 0 otherwise.
 uint8_t is_game_over(void)
 {	
-	int computer_ships_sunk = 0;
+	Player winner;
+	if (board_all_sunk(&computer_board)) {
+		// All the computer's ships are sunk
+		winner = PLAYER_HUMAN;
+	} else if (board_all_sunk(&human_board)) {
+		// All the player's ships are sunk
+		winner = PLAYER_COMPUTER;
+	} else {
+		return 0;
+	}
 	
-	// Checks how many ships the computer has alive
-	 for (int i = 0; i < 6; i++) {
-		 // Checks if all ships are sunk
-		 if (computer_ships[i].sunk == 1) {
-			 computer_ships_sunk ++;
-		 }
-	 }
-	 
-	 if (computer_ships_sunk == 6) {
-		 game_over_board(human_ships, human_grid, "human");
-		 game_over_board(computer_ships, computer_grid, "computer");
-		 move_terminal_cursor(10,13);
-		 printf("The player is the winner!");
-		 reset_game();
-		 if (!is_muted) {
-			 play_sound("human wins");
-		 }
-		 return 1;
-	 }
-	 
-	 int player_ships_sunk = 0;
-	 
-	 // Checks how many ships the player has alive
-	 for (int i = 0; i < 6; i++) {
-		 // Checks if all ships are sunk
-		 if (human_ships[i].sunk == 1) {
-			 player_ships_sunk ++;
-		 }
-	 }
-	 
-	  if (player_ships_sunk == 6) {
-		  game_over_board(human_ships, human_grid, "human");
-		  game_over_board(computer_ships, computer_grid, "computer");
-		  move_terminal_cursor(10,13);
-		  printf("The computer is the winner!");
-		  reset_game();
-		  // Plays sound
-		  if (!is_muted) {
-			  play_sound("computer wins");
-		  }
-		  return 1;
-	  }
-	 
+	// Show the final boards before the game is reset
+	event_post(EVENT_GAME_OVER, winner, 0, 0);
+	events_dispatch();
+	BENCH_MARK(BENCH_COMMIT_START);
+	ledmatrix_commit();
+	screen_flush();
+	BENCH_MARK(BENCH_COMMIT_END);
+	reset_game();
+	return 1;
+}
+
+// The opponent's board: the one a player fires at
+static Player target_of(Player shooter) {
+	return shooter == PLAYER_HUMAN ? PLAYER_COMPUTER : PLAYER_HUMAN;
+}
+
+// LED matrix consumer. The cell under the cursor is left for the cursor
+// to draw.
+static void draw_event(const Event* event) {
+	uint8_t x = event->cell % GRID_NUM_COLUMNS;
+	uint8_t y = event->cell / GRID_NUM_COLUMNS;
+	Player owner = target_of(event->player);
 	
-	// Detect if the game is over i.e. if a player has won.
-	return 0;
+	switch (event->type) {
+		case EVENT_HIT:
+		case EVENT_MISS:
+			if (owner == PLAYER_COMPUTER && x == cursor_x && y == cursor_y) {
+				break;
+			}
+			// Red if there is a ship, green if not
+			draw_pixel_in_grid(owner, x, y, event->type == EVENT_HIT ? COLOUR_RED : COLOUR_GREEN);
+			break;
+		case EVENT_SUNK: {
+			// Makes the ship dark to symbolize it being sunk
+			const Board* board = owner == PLAYER_COMPUTER ? &computer_board : &human_board;
+			for (uint8_t n = 0; n < board->cells[event->detail].size; n++) {
+				uint8_t cell = board_ship_cell(board, event->detail, n);
+				draw_pixel_in_grid(owner, cell % GRID_NUM_COLUMNS, cell / GRID_NUM_COLUMNS,
+						COLOUR_DARK_RED);
+			}
+			break;
+		}
+		case EVENT_GAME_OVER:
+			game_over_board(&human_board, PLAYER_HUMAN);
+			game_over_board(&computer_board, PLAYER_COMPUTER);
+			break;
+	}
+}
+
+// Buzzer consumer. Only the first hit of a shot (the cheats fire at
+// several cells at once) gets a sound.
+static void sound_event(const Event* event) {
+	static uint8_t shot_has_hit;
+	uint8_t by_human = event->player == PLAYER_HUMAN;
+	
+	if (event->type == EVENT_SHOT_FIRED) {
+		shot_has_hit = 0;
+		return;
+	}
+	if (is_muted) {
+		return;
+	}
+	switch (event->type) {
+		case EVENT_HIT:
+			if (!shot_has_hit) {
+				shot_has_hit = 1;
+				sound_play(by_human ? SOUND_COMPUTER_HIT : SOUND_HUMAN_HIT);
+			}
+			break;
+		case EVENT_SUNK:
+			sound_play(by_human ? SOUND_COMPUTER_SINK : SOUND_HUMAN_SINK);
+			break;
+		case EVENT_GAME_OVER:
+			sound_play(by_human ? SOUND_HUMAN_WINS : SOUND_COMPUTER_WINS);
+			break;
+	}
+}
+
+// Serial terminal consumer
+static void terminal_event(const Event* event) {
+	switch (event->type) {
+		case EVENT_SHOT_FIRED:
+			if (event->player == PLAYER_HUMAN) {
+				clear_invalid_move_message();
+			}
+			break;
+		case EVENT_SUNK:
+			// Prints a message when a ship is sunk
+			sunk_ship_message(event->player, event->detail);
+			break;
+		case EVENT_GAME_OVER:
+			if (event->player == PLAYER_HUMAN) {
+				screen_write_text(10, 13, TEXT_HUMAN_WINS);
+			} else {
+				screen_write_text(10, 13, TEXT_COMPUTER_WINS);
+			}
+			break;
+	}
+}
+
+void init_game_events(void) {
+	events_subscribe(draw_event, EVENT_MASK(EVENT_HIT) | EVENT_MASK(EVENT_MISS) |
+			EVENT_MASK(EVENT_SUNK) | EVENT_MASK(EVENT_GAME_OVER));
+	events_subscribe(sound_event, EVENT_MASK(EVENT_SHOT_FIRED) | EVENT_MASK(EVENT_HIT) |
+			EVENT_MASK(EVENT_SUNK) | EVENT_MASK(EVENT_GAME_OVER));
+	events_subscribe(terminal_event, EVENT_MASK(EVENT_SHOT_FIRED) | EVENT_MASK(EVENT_SUNK) |
+			EVENT_MASK(EVENT_GAME_OVER));
 }
 
 // resets the game to its initial state
 void reset_game() {
-	reset_ships(human_ships);
-	reset_ships(computer_ships);
+	// The boards are set up again by initialise_game()
 	
 	computer_target_x = 0;
 	computer_target_y = 7;
 	
+	// Search and Destroy starts the next game searching
+	frontier = 0;
+	is_search_mode = 1;
+	book_node = 0;
+	plan_ready = 0;
+	
+	// Drop a computer shot that is still being animated
+	animation_running = 0;
+	
 	human_message_line = 0;
 	computer_message_line = 0;
 	
@@ -1012,26 +725,29 @@ void reset_game() {
 	**/
 }
 
-// reveals all the computer's ships
-void reveal_computer_ships() {
-	for (uint8_t y = 0; y < GRID_NUM_ROWS; y++) {
-		for (uint8_t x = 0; x < GRID_NUM_COLUMNS; x++) {
-			uint8_t cell = computer_grid[y][x];
-			if ((cell & SHIP_MASK) && !(cell & (HIT_MASK | MISS_MASK | SUNK_MASK))) {
-				ledmatrix_draw_pixel_in_computer_grid(x, y, COLOUR_ORANGE);
+// Draws the cells of the computer's ships that haven't been fired at
+static void draw_unfired_computer_ships(PixelColour colour) {
+	for (uint8_t i = 0; i < NUM_SHIPS; i++) {
+		if (!(computer_board.afloat & (1 << i))) {
+			continue;
+		}
+		for (uint8_t n = 0; n < computer_board.cells[i].size; n++) {
+			uint8_t cell = board_ship_cell(&computer_board, i, n);
+			uint8_t x = cell % GRID_NUM_COLUMNS;
+			uint8_t y = cell / GRID_NUM_COLUMNS;
+			if (!board_fired_at(&computer_board, x, y)) {
+				ledmatrix_draw_pixel_in_computer_grid(x, y, colour);
 			}
 		}
 	}
 }
 
+// reveals all the computer's ships
+void reveal_computer_ships() {
+	draw_unfired_computer_ships(COLOUR_ORANGE);
+}
+
 // Hides the location of the computer's ships
 void hide_computer_ships() {
-	for (uint8_t y = 0; y < GRID_NUM_ROWS; y++) {
-		for (uint8_t x = 0; x < GRID_NUM_COLUMNS; x++) {
-			uint8_t cell = computer_grid[y][x];
-			if ((cell & SHIP_MASK) && !(cell & (HIT_MASK | MISS_MASK | SUNK_MASK))) {
-				ledmatrix_draw_pixel_in_computer_grid(x, y, COLOUR_BLACK);
-			}
-		}
-	}
-}
\ No newline at end of file
+	draw_unfired_computer_ships(COLOUR_BLACK);
+}
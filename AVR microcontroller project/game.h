@@ -13,10 +13,34 @@
 #define GAME_H_
 
 #include <stdint.h>
+#include "text.h"
+
+// The computer's modes, in the order the start screen steps through them
+typedef enum {
+	MODE_BASIC,
+	MODE_SEARCH_AND_DESTROY,
+	MODE_PROBABILITY_HUNT,
+	NUM_GAME_MODES
+} GameMode;
+
+typedef enum {
+	PLAYER_HUMAN,
+	PLAYER_COMPUTER
+} Player;
+
+// The computer's mode, set on the start screen
+extern GameMode game_mode;
+
+// The mode's name (text.h), padded to the same width for every mode
+TextId game_mode_text(GameMode mode);
 
 // Initialize the game by resetting the grid and beat
 void initialise_game(void);
 
+// Subscribe the game's display, sound and terminal handlers to the event
+// bus (events.h). Call once, after events_init().
+void init_game_events(void);
+
 // flash the cursor
 void flash_cursor(void);
 
@@ -25,14 +49,31 @@ void move_cursor(int8_t dx, int8_t dy);
 void invalid_move_message(void);
 void reset_invalid_move(void);
 void clear_invalid_move_message(void);
-void sunk_ship_message(const char* player, const char* ship);
+// ship is the sunk ship's index, from 0 for the carrier
+void sunk_ship_message(Player player, uint8_t ship);
 void add_adjacent_cells_to_hit(uint8_t x, uint8_t y);
 void computer_fire_animation(uint8_t target_x, uint8_t target_y);
+
+// Step the computer's firing animation - call this from the main loop.
+// The computer's shot takes effect when the animation finishes.
+void update_computer_fire_animation(void);
+
+// End the firing animation now and let the shot take effect
+void finish_computer_fire_animation(void);
+
+// Turn the firing animation off (0) to land the computer's shots as soon
+// as they are chosen, or back on
+void set_fire_animation(uint8_t on);
+
 void computer_turn(void);
+
+// Work out the computer's next shot ahead of time, a small piece per call,
+// so computer_turn() has less to do when the human fires. Run it when
+// computer_thinking() returns non-zero, which it does until the shot is
+// ready.
+uint8_t computer_thinking(void);
+void computer_think(void);
 void fire_at_location(int8_t dx, int8_t dy);
-void play_sound(const char *event);
-void sound_on(uint16_t freq, float dutycycle, uint16_t clockperiod, uint16_t pulsewidth);
-void sound_off();
 void fire_around_location();
 void fire_in_row();
 void fire_in_column();
@@ -51,6 +92,10 @@ uint8_t is_game_over(void);
 #define CORVETTE 5
 #define SUBMARINE 6
 #define SHIP_MASK 7
+
+// Length of each ship, CARRIER first. The opening book in
+// opening_book_table.h is generated from these.
+#define SHIP_SIZES {6, 4, 3, 3, 2, 2}
 #define SHIP_END 8
 #define HORIZONTAL 16
 
@@ -0,0 +1,228 @@
+/*
+ * heatmap.c
+ *
+ * Placement counts for Probability Hunt - see heatmap.h
+ */
+
+#include "heatmap.h"
+#include <stdint.h>
+#include <string.h>
+#include "ledmatrix.h"
+
+static const Board* board;
+
+// Placements across each cell, horizontal and vertical, indexed [y][x].
+// One plane rather than one for each direction, to save RAM: a line's
+// old counts are taken off by counting it again as it was, from what is
+// kept in counted[].
+static uint16_t heat[GRID_NUM_ROWS][GRID_NUM_COLUMNS];
+
+// What each line's counts in heat[] were worked out from: rows 0 to 7
+// then columns 0 to 7
+typedef struct {
+	uint8_t blocked;
+	uint8_t hits;
+	uint8_t afloat;
+} LineState;
+
+static LineState counted[GRID_NUM_ROWS + GRID_NUM_COLUMNS];
+
+// A bit for each row and column whose counts are out of date, and for
+// those to recount first
+static uint8_t dirty_rows;
+static uint8_t dirty_columns;
+static uint8_t urgent_rows;
+static uint8_t urgent_columns;
+
+// Count the placements along one line of the ships in line.afloat.
+// blocked and hits have a bit for each cell of the line.
+static void count_line(LineState line, uint16_t heat[8])
+{
+	memset(heat, 0, 8 * sizeof(heat[0]));
+	for (uint8_t s = 0; s < NUM_SHIPS; s++)
+	{
+		if (!(line.afloat & (1 << s)))
+		{
+			continue;
+		}
+		uint8_t size = board->cells[s].size;
+		uint8_t ship = (1 << size) - 1;
+		for (uint8_t start = 0; start + size <= 8; start++)
+		{
+			uint8_t cells = ship << start;
+			if (cells & line.blocked)
+			{
+				continue;
+			}
+			uint16_t weight = 1;
+			for (uint8_t covered = cells & line.hits; covered; covered &= covered - 1)
+			{
+				weight += HEATMAP_HIT_WEIGHT;
+			}
+			for (uint8_t i = start; i < start + size; i++)
+			{
+				heat[i] += weight;
+			}
+		}
+	}
+}
+
+// Cells no ship left can cover, and hits on ships still afloat
+static Bitboard blocked_cells(void)
+{
+	return (board->fired & ~board->hit) | board->sunk;
+}
+
+// Recount line (rows 0 to 7, then columns) from its state now, and swap
+// its new counts into heat[] for the old
+static void recount(uint8_t line, uint8_t blocked, uint8_t hits)
+{
+	LineState now = {blocked, hits, board->afloat};
+	LineState was = counted[line];
+	if (now.blocked == was.blocked && now.hits == was.hits && now.afloat == was.afloat)
+	{
+		return;
+	}
+	uint16_t old_heat[8];
+	uint16_t new_heat[8];
+	count_line(was, old_heat);
+	count_line(now, new_heat);
+	counted[line] = now;
+	for (uint8_t i = 0; i < 8; i++)
+	{
+		uint16_t* cell = line < GRID_NUM_ROWS ? &heat[line][i] : &heat[i][line - GRID_NUM_ROWS];
+		*cell += new_heat[i] - old_heat[i];
+	}
+}
+
+static void count_row(uint8_t y)
+{
+	uint8_t shift = y * GRID_NUM_COLUMNS;
+	recount(y, blocked_cells() >> shift, (board->hit & ~board->sunk) >> shift);
+}
+
+static void count_column(uint8_t x)
+{
+	Bitboard blocked = blocked_cells() >> x;
+	Bitboard hits = (board->hit & ~board->sunk) >> x;
+	uint8_t column_blocked = 0;
+	uint8_t column_hits = 0;
+	for (uint8_t y = 0; y < GRID_NUM_ROWS; y++)
+	{
+		column_blocked |= (blocked & 1) << y;
+		column_hits |= (hits & 1) << y;
+		blocked >>= GRID_NUM_COLUMNS;
+		hits >>= GRID_NUM_COLUMNS;
+	}
+	recount(GRID_NUM_ROWS + x, column_blocked, column_hits);
+}
+
+void heatmap_init(const Board* new_board)
+{
+	board = new_board;
+	// Nothing counted yet: no ships afloat means no placements to take off
+	memset(heat, 0, sizeof(heat));
+	memset(counted, 0, sizeof(counted));
+	dirty_rows = 0xFF;
+	dirty_columns = 0xFF;
+	urgent_rows = 0;
+	urgent_columns = 0;
+	heatmap_update(GRID_NUM_ROWS + GRID_NUM_COLUMNS);
+}
+
+void heatmap_shot(uint8_t x, uint8_t y, Bitboard sunk)
+{
+	urgent_rows |= 1 << y;
+	urgent_columns |= 1 << x;
+	if (sunk)
+	{
+		dirty_rows = 0xFF;
+		dirty_columns = 0xFF;
+		for (uint8_t row = 0; row < GRID_NUM_ROWS; row++)
+		{
+			uint8_t cells = sunk >> (row * GRID_NUM_COLUMNS);
+			if (cells)
+			{
+				urgent_rows |= 1 << row;
+				urgent_columns |= cells;
+			}
+		}
+	}
+	dirty_rows |= urgent_rows;
+	dirty_columns |= urgent_columns;
+}
+
+// Recount up to max_lines of the rows and columns given. Returns the
+// number of lines left.
+static uint8_t count_lines(uint8_t rows, uint8_t columns, uint8_t max_lines)
+{
+	for (uint8_t i = 0; i < 8 && max_lines; i++)
+	{
+		if ((rows & (1 << i)) && max_lines)
+		{
+			count_row(i);
+			dirty_rows &= ~(1 << i);
+			max_lines--;
+		}
+		if ((columns & (1 << i)) && max_lines)
+		{
+			count_column(i);
+			dirty_columns &= ~(1 << i);
+			max_lines--;
+		}
+	}
+	return max_lines;
+}
+
+uint8_t heatmap_update(uint8_t max_lines)
+{
+	max_lines = count_lines(urgent_rows & dirty_rows, urgent_columns & dirty_columns, max_lines);
+	urgent_rows &= dirty_rows;
+	urgent_columns &= dirty_columns;
+	count_lines(dirty_rows, dirty_columns, max_lines);
+	
+	uint8_t left = 0;
+	for (uint8_t i = 0; i < 8; i++)
+	{
+		left += ((dirty_rows >> i) & 1) + ((dirty_columns >> i) & 1);
+	}
+	return left;
+}
+
+uint16_t heatmap_value(uint8_t x, uint8_t y)
+{
+	return heat[y][x];
+}
+
+uint8_t heatmap_best(uint8_t start)
+{
+	// The cells fired at in each row, to save shifting a Bitboard by
+	// each cell's number
+	uint8_t fired[GRID_NUM_ROWS];
+	Bitboard cells = board->fired;
+	for (uint8_t y = 0; y < GRID_NUM_ROWS; y++)
+	{
+		fired[y] = cells;
+		cells >>= GRID_NUM_COLUMNS;
+	}
+	
+	uint8_t best = start;
+	int32_t best_value = -1;
+	for (uint8_t i = 0; i < GRID_NUM_ROWS * GRID_NUM_COLUMNS; i++)
+	{
+		uint8_t cell = (start + i) % (GRID_NUM_ROWS * GRID_NUM_COLUMNS);
+		uint8_t x = cell % GRID_NUM_COLUMNS;
+		uint8_t y = cell / GRID_NUM_COLUMNS;
+		if (fired[y] & (1 << x))
+		{
+			continue;
+		}
+		uint16_t value = heatmap_value(x, y);
+		if ((int32_t)value > best_value)
+		{
+			best = cell;
+			best_value = value;
+		}
+	}
+	return best;
+}
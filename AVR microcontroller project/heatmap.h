@@ -0,0 +1,55 @@
+/*
+ * heatmap.h
+ *
+ * Placement counts for the computer's "Probability Hunt" mode. For every
+ * cell of the human's grid we keep how many ways the ships that haven't
+ * been sunk (sizes 6, 4, 3, 3, 2, 2 to start with) could lie across it,
+ * given the shots fired so far: a placement can't cover a miss or a sunk
+ * ship, and one that covers hits not yet sunk counts HEATMAP_HIT_WEIGHT
+ * more for each, so the computer closes in on a ship once it has hit it.
+ *
+ * Horizontal placements only depend on their row and vertical ones on
+ * their column, so each row and column is counted on its own and a shot
+ * only makes its own row and column out of date (a sinking makes all of
+ * them out of date, as the ships left change). Lines are recounted by
+ * heatmap_update() with a limit on how many are done at a time. Each line
+ * is at most 6 ships in 7 positions, counted twice (as it was, to take
+ * its old counts off, and as it is), so the limit is a hard bound on the
+ * work done in a turn. The shot's own row and column and those of a ship
+ * it sank go first, as the hits counted there have changed; the other
+ * lines only lose the sunk ship and are left a turn or two behind.
+ */
+
+#ifndef HEATMAP_H_
+#define HEATMAP_H_
+
+#include <stdint.h>
+#include "board.h"
+
+// Extra weight of a placement for each hit it covers
+#define HEATMAP_HIT_WEIGHT 16
+
+// Lines recounted in a computer turn. A shot needs 2; a sinking needs all
+// 16, spread over the following turns.
+#define HEATMAP_LINES_PER_TURN 6
+
+// Count every line of board from scratch. board is used by the other
+// functions until heatmap_init() is called again.
+void heatmap_init(const Board* board);
+
+// Note a shot at (x, y) that has been applied to the board. sunk is the
+// cells of any ship it sank.
+void heatmap_shot(uint8_t x, uint8_t y, Bitboard sunk);
+
+// Recount up to max_lines out of date lines. Returns the number still
+// out of date.
+uint8_t heatmap_update(uint8_t max_lines);
+
+// The cell (y * 8 + x) not yet fired at with the highest count. Ties go to
+// the first found going round the grid from cell start.
+uint8_t heatmap_best(uint8_t start);
+
+// The count for a cell
+uint16_t heatmap_value(uint8_t x, uint8_t y);
+
+#endif /* HEATMAP_H_ */
@@ -0,0 +1,151 @@
+/*
+ * fleet_bench.c
+ *
+ * Host benchmark for the random fleet placement in fleet.c. Places fleets
+ * from a fixed seed and reports fleets per second of host time, how often
+ * the placement had to backtrack or start again, and how evenly the
+ * ships cover the grid. Exits non-zero if a fleet is missing a ship or
+ * has two overlapping.
+ *
+ * Usage: fleet_bench [-b] [-n fleets] [-s seed] [-v]
+ *   -b  also fail unless the placement backtracked, and started again
+ *       for fewer than 1% of the fleets (for make check, which builds it
+ *       with a ship list that often leaves the last ships no room)
+ *   -v  print the first fleet
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hal.h"
+#include "fleet.h"
+#include "game.h"
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void print_grid(uint8_t grid[GRID_NUM_ROWS][GRID_NUM_COLUMNS])
+{
+	// Top row (y = 7) first, as on the LED matrix
+	for (int8_t y = GRID_NUM_ROWS - 1; y >= 0; y--)
+	{
+		for (uint8_t x = 0; x < GRID_NUM_COLUMNS; x++)
+		{
+			uint8_t cell = grid[y][x];
+			putchar((cell & SHIP_MASK) ? '0' + (cell & SHIP_MASK) : '.');
+			putchar((cell & SHIP_END) ? '*' : (cell & HORIZONTAL) ? '-' : ' ');
+		}
+		putchar('\n');
+	}
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long fleets = 1000000;
+	unsigned long seed = 1;
+	int verbose = 0;
+	int backtracking = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "bn:s:v")) != -1)
+	{
+		switch (opt)
+		{
+			case 'b':
+				backtracking = 1;
+				break;
+			case 'n':
+				fleets = strtoul(optarg, NULL, 0);
+				break;
+			case 's':
+				seed = strtoul(optarg, NULL, 0);
+				break;
+			case 'v':
+				verbose = 1;
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-b] [-n fleets] [-s seed] [-v]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	uint64_t occupied[GRID_NUM_ROWS][GRID_NUM_COLUMNS] = {{0}};
+	unsigned long bad = 0;
+	uint8_t grid[GRID_NUM_ROWS][GRID_NUM_COLUMNS];
+	uint64_t place_ns = 0;
+
+	fleet_seed(seed);
+	for (unsigned long n = 0; n < fleets; n++)
+	{
+		uint64_t start = now_ns();
+		fleet_place(grid);
+		place_ns += now_ns() - start;
+
+		if (verbose && n == 0)
+		{
+			print_grid(grid);
+		}
+
+		// Every ship should be there at its full size
+		unsigned cells[SHIP_MASK] = {0};
+		for (uint8_t y = 0; y < GRID_NUM_ROWS; y++)
+		{
+			for (uint8_t x = 0; x < GRID_NUM_COLUMNS; x++)
+			{
+				uint8_t ship = grid[y][x] & SHIP_MASK;
+				if (ship)
+				{
+					occupied[y][x]++;
+					if (ship <= fleet_num_ships())
+					{
+						cells[ship - 1]++;
+					}
+				}
+			}
+		}
+		for (uint8_t i = 0; i < fleet_num_ships(); i++)
+		{
+			if (cells[i] != fleet_ship_size(i))
+			{
+				bad++;
+				break;
+			}
+		}
+	}
+
+	const FleetStats *stats = fleet_stats();
+	uint64_t least = UINT64_MAX, most = 0;
+	for (uint8_t y = 0; y < GRID_NUM_ROWS; y++)
+	{
+		for (uint8_t x = 0; x < GRID_NUM_COLUMNS; x++)
+		{
+			least = occupied[y][x] < least ? occupied[y][x] : least;
+			most = occupied[y][x] > most ? occupied[y][x] : most;
+		}
+	}
+	printf("%lu fleets in %.3f s host time: %.0f fleets/s\n", fleets, place_ns / 1e9,
+			place_ns ? fleets / (place_ns / 1e9) : 0.0);
+	printf("%.4f backtracks and %.6f restarts per fleet\n",
+			fleets ? (double)stats->backtracks / fleets : 0.0,
+			fleets ? (double)stats->restarts / fleets : 0.0);
+	printf("cells with a ship: %.1f%% to %.1f%% of fleets\n",
+			fleets ? 100.0 * least / fleets : 0.0, fleets ? 100.0 * most / fleets : 0.0);
+	if (bad)
+	{
+		printf("%lu fleets with a ship missing or overlapping\n", bad);
+		return 1;
+	}
+	if (backtracking && (stats->backtracks == 0 || stats->restarts * 100 >= fleets))
+	{
+		printf("backtracking FAILED: it should be needed, and should rarely have to start again\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,382 @@
+/*
+ * game_bench.c
+ *
+ * Host benchmark for the game logic. Plays complete games against the
+ * computer with the firmware built for the host (see hal.h): the human
+ * side fires at the computer's grid in a random order, the computer
+ * answers with computer_turn() after every shot and its firing animation
+ * is played out in modelled time, as play_game() does. Before each shot
+ * the computer is left to think about its reply, as it would while the
+ * human aims. The game's events are dispatched before each matrix commit,
+ * as the scheduler does. Reports host time per call and the SPI/UART
+ * traffic per turn.
+ *
+ * The SPI stream is decoded by the LED matrix model (matrix_model.h), which
+ * reports the bytes and bus time taken by each matrix command and by each
+ * kind of game event, and can show what the player sees after every turn.
+ *
+ * Both fleets are placed at random; -s seeds them and the human's shots.
+ *
+ * Usage: game_bench [-g games] [-m basic|search|prob] [-s seed] [-a] [-k spi_hz]
+ *                   [-v] [-p png_dir] [-f frame_file]
+ *   -a  leave sound on (sounds play from the timer 1 interrupt as modelled
+ *       time passes)
+ *   -k  SPI clock for transfer times (default F_CPU/128, as ledmatrix.c)
+ *   -v  draw the LED matrix in the terminal after every turn
+ *   -p  write the LED matrix to png_dir/frameNNNNNN.png after every turn
+ *   -f  write the LED matrix after every turn as a line of hex, so the
+ *       frames two builds show can be compared with diff
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hal.h"
+#include "events.h"
+#include "serialio.h"
+#include "fleet.h"
+#include "game.h"
+#include "ledmatrix.h"
+#include "matrix_model.h"
+#include "screen.h"
+#include "spi.h"
+
+// Firmware globals and functions that aren't in a header
+extern uint8_t cursor_x, cursor_y;
+extern uint32_t is_muted;
+extern uint8_t animation_running;
+void initialise_hardware(void);
+uint8_t move_is_valid(void);
+
+typedef struct {
+	const char *name;
+	uint64_t calls;
+	uint64_t total_ns;
+	uint64_t worst_ns;
+} CallStats;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void record(CallStats *stats, uint64_t start)
+{
+	uint64_t elapsed = now_ns() - start;
+	stats->calls++;
+	stats->total_ns += elapsed;
+	if (elapsed > stats->worst_ns)
+	{
+		stats->worst_ns = elapsed;
+	}
+}
+
+static void print_stats(const CallStats *stats)
+{
+	printf("%-20s %10llu calls %10.1f ns/call %10llu ns worst\n", stats->name,
+			(unsigned long long)stats->calls,
+			stats->calls ? (double)stats->total_ns / stats->calls : 0.0,
+			(unsigned long long)stats->worst_ns);
+}
+
+// SPI traffic caused by one kind of game event
+typedef struct {
+	const char *name;
+	uint64_t count;
+	uint64_t total_bytes;
+	uint32_t worst_bytes;
+} BurstStats;
+
+// Add the bytes sent since the SPI byte count was start
+static void record_burst(BurstStats *stats, uint32_t start)
+{
+	uint32_t bytes = hal_spi_byte_count() - start;
+	stats->count++;
+	stats->total_bytes += bytes;
+	if (bytes > stats->worst_bytes)
+	{
+		stats->worst_bytes = bytes;
+	}
+}
+
+static void print_burst(const BurstStats *stats, uint32_t spi_hz)
+{
+	double average = stats->count ? (double)stats->total_bytes / stats->count : 0.0;
+	printf("  %-14s %10llu events %8.1f bytes (%6.2f ms) avg %6u bytes (%6.2f ms) worst\n",
+			stats->name, (unsigned long long)stats->count, average,
+			average * 8 * 1000 / spi_hz, stats->worst_bytes,
+			matrix_model_transfer_ms(stats->worst_bytes, spi_hz));
+}
+
+// What the player sees after a turn
+static void show_frame(uint64_t frame, int view, const char *png_dir, FILE *frame_file)
+{
+	if (view)
+	{
+		printf("frame %llu\n", (unsigned long long)frame);
+		matrix_model_print(stdout);
+	}
+	if (png_dir)
+	{
+		char path[4096];
+		snprintf(path, sizeof(path), "%s/frame%06llu.png", png_dir, (unsigned long long)frame);
+		if (matrix_model_write_png(path, 16) != 0)
+		{
+			fprintf(stderr, "can't write %s\n", path);
+			exit(1);
+		}
+	}
+	if (frame_file)
+	{
+		for (uint8_t y = 0; y < MATRIX_NUM_ROWS; y++)
+		{
+			for (uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++)
+			{
+				fprintf(frame_file, "%02x", matrix_model_pixel(x, y));
+			}
+		}
+		fputc('\n', frame_file);
+	}
+}
+
+// Random order for the human's 64 shots
+static void shuffle_shots(uint8_t shots[GRID_NUM_ROWS * GRID_NUM_COLUMNS])
+{
+	for (uint8_t i = 0; i < GRID_NUM_ROWS * GRID_NUM_COLUMNS; i++)
+	{
+		shots[i] = i;
+	}
+	for (uint8_t i = GRID_NUM_ROWS * GRID_NUM_COLUMNS - 1; i > 0; i--)
+	{
+		uint8_t j = rand() % (i + 1);
+		uint8_t t = shots[i];
+		shots[i] = shots[j];
+		shots[j] = t;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long games = 1000;
+	unsigned int seed = 1;
+	int sound = 0;
+	int view = 0;
+	uint32_t spi_hz = HAL_F_CPU / 128;
+	const char *png_dir = NULL;
+	FILE *frame_file = NULL;
+	const char *mode_name = "basic";
+	int opt;
+
+	while ((opt = getopt(argc, argv, "g:m:s:ak:vp:f:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'g':
+				games = strtoul(optarg, NULL, 0);
+				break;
+			case 'm':
+				mode_name = optarg;
+				break;
+			case 's':
+				seed = strtoul(optarg, NULL, 0);
+				break;
+			case 'a':
+				sound = 1;
+				break;
+			case 'k':
+				spi_hz = strtoul(optarg, NULL, 0);
+				break;
+			case 'v':
+				view = 1;
+				break;
+			case 'p':
+				png_dir = optarg;
+				break;
+			case 'f':
+				frame_file = fopen(optarg, "w");
+				if (!frame_file)
+				{
+					fprintf(stderr, "can't write %s\n", optarg);
+					return 1;
+				}
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-g games] [-m basic|search|prob] [-s seed] [-a] [-k spi_hz]"
+						" [-v] [-p png_dir] [-f frame_file]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (spi_hz == 0)
+	{
+		fprintf(stderr, "SPI clock must be non-zero\n");
+		return 1;
+	}
+
+	hal_reset();
+	matrix_model_reset();
+	hal_set_spi_sink(matrix_model_byte);
+	initialise_hardware();
+	srand(seed);
+	fleet_seed(seed);
+
+	if (strcmp(mode_name, "search") == 0)
+	{
+		game_mode = MODE_SEARCH_AND_DESTROY;
+	} else if (strcmp(mode_name, "prob") == 0)
+	{
+		game_mode = MODE_PROBABILITY_HUNT;
+	} else if (strcmp(mode_name, "basic") == 0)
+	{
+		game_mode = MODE_BASIC;
+	} else
+	{
+		fprintf(stderr, "unknown mode '%s'\n", mode_name);
+		return 1;
+	}
+	is_muted = !sound;
+
+	CallStats fire_stats = {"fire_at_location"};
+	CallStats turn_stats = {"computer_turn"};
+	CallStats animation_stats = {"fire animation step"};
+	CallStats think_stats = {"computer_think"};
+	CallStats dispatch_stats = {"events_dispatch"};
+	CallStats over_stats = {"is_game_over"};
+	CallStats commit_stats = {"ledmatrix_commit"};
+	CallStats flush_stats = {"screen_flush"};
+	BurstStats new_game_burst = {"new game"};
+	BurstStats turn_burst = {"turn"};
+	BurstStats game_over_burst = {"game over"};
+	uint64_t turns = 0;
+	uint64_t split_commands = 0;
+	uint64_t start_ms = hal_time_ms();
+	uint64_t start = now_ns();
+
+	for (unsigned long game = 0; game < games; game++)
+	{
+		uint8_t shots[GRID_NUM_ROWS * GRID_NUM_COLUMNS];
+		shuffle_shots(shots);
+		uint32_t burst_start = hal_spi_byte_count();
+		initialise_game();
+		ledmatrix_commit();
+		screen_flush();
+		record_burst(&new_game_burst, burst_start);
+
+		uint64_t call_start = now_ns();
+		uint8_t over = is_game_over();
+		record(&over_stats, call_start);
+
+		for (uint8_t shot = 0; !over && shot < GRID_NUM_ROWS * GRID_NUM_COLUMNS; shot++)
+		{
+			cursor_x = shots[shot] % GRID_NUM_COLUMNS;
+			cursor_y = shots[shot] / GRID_NUM_COLUMNS;
+			if (!move_is_valid())
+			{
+				continue;
+			}
+
+			while (computer_thinking())
+			{
+				call_start = now_ns();
+				computer_think();
+				record(&think_stats, call_start);
+			}
+
+			burst_start = hal_spi_byte_count();
+			call_start = now_ns();
+			fire_at_location(0, 0);
+			record(&fire_stats, call_start);
+
+			call_start = now_ns();
+			computer_turn();
+			record(&turn_stats, call_start);
+			turns++;
+
+			call_start = now_ns();
+			events_dispatch();
+			record(&dispatch_stats, call_start);
+
+			// Let the firing animation play out, as the main loop would
+			while (animation_running)
+			{
+				hal_advance_time_ms(1);
+				call_start = now_ns();
+				update_computer_fire_animation();
+				record(&animation_stats, call_start);
+				call_start = now_ns();
+				events_dispatch();
+				record(&dispatch_stats, call_start);
+				ledmatrix_commit();
+			}
+
+			// A turn that ends the game also sends the game over display
+			call_start = now_ns();
+			over = is_game_over();
+			record(&over_stats, call_start);
+
+			// play_game() sends each iteration's drawing at the end of it
+			call_start = now_ns();
+			ledmatrix_commit();
+			record(&commit_stats, call_start);
+			call_start = now_ns();
+			screen_flush();
+			record(&flush_stats, call_start);
+			record_burst(over ? &game_over_burst : &turn_burst, burst_start);
+
+			// Every command should be complete once the drawing is sent
+			spi_flush();
+			if (matrix_model_busy())
+			{
+				split_commands++;
+			}
+			show_frame(turns, view, png_dir, frame_file);
+		}
+	}
+
+	uint64_t elapsed = now_ns() - start;
+	printf("%lu games, %llu turns in %.3f s host time (%.1f s modelled)\n", games,
+			(unsigned long long)turns, elapsed / 1e9, (hal_time_ms() - start_ms) / 1e3);
+	print_stats(&fire_stats);
+	print_stats(&turn_stats);
+	print_stats(&animation_stats);
+	print_stats(&think_stats);
+	print_stats(&dispatch_stats);
+	print_stats(&over_stats);
+	print_stats(&commit_stats);
+	print_stats(&flush_stats);
+	if (turns)
+	{
+		printf("SPI bytes per turn  %10.1f (%.1f saved by ledmatrix_commit)\n",
+				(double)hal_spi_byte_count() / turns, (double)ledmatrix_bytes_saved() / turns);
+		printf("UART bytes per turn %10.1f (%.1f saved by screen_flush)\n",
+				(double)hal_uart_tx_byte_count() / turns, (double)screen_bytes_saved() / turns);
+	}
+	printf("Events %llu posted, at most %u queued, queue full %u times\n",
+			(unsigned long long)events_stats()->posted, events_stats()->most_queued,
+			events_stats()->full);
+	SerialStats serial = serial_stats();
+	printf("Serial %u output stalls, %u output bytes dropped, %u input overruns\n",
+			serial.tx_stalls, serial.tx_dropped, serial.rx_overruns);
+	matrix_model_print_stats(stdout, spi_hz);
+	printf("SPI bursts:\n");
+	print_burst(&new_game_burst, spi_hz);
+	print_burst(&turn_burst, spi_hz);
+	print_burst(&game_over_burst, spi_hz);
+	if (matrix_model_stats(MATRIX_CMD_UNKNOWN)->count || split_commands)
+	{
+		printf("LED matrix stream errors: %lu unknown commands, %llu turns ended mid-command\n",
+				(unsigned long)matrix_model_stats(MATRIX_CMD_UNKNOWN)->count,
+				(unsigned long long)split_commands);
+		return 1;
+	}
+	if (frame_file)
+	{
+		fclose(frame_file);
+	}
+	return 0;
+}
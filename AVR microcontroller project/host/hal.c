@@ -0,0 +1,615 @@
+/*
+ * hal.c
+ *
+ * Register-level model of the parts of the ATmega324A that the firmware
+ * uses. See hal.h for how the model behaves and host/include/avr/io.h for
+ * how the firmware's register accesses end up here.
+ */
+
+#define HAL_INTERNAL
+#include <avr/io.h>
+#include <string.h>
+#include "hal.h"
+
+// The data space the firmware's registers live in
+uint8_t hal_mem[HAL_MEM_SIZE] __attribute__((aligned(2)));
+
+// SPDR0/UDR0 hold LATCH_EMPTY plus the last received byte until the
+// firmware writes a byte to them (any value from -128 to 255)
+#define LATCH_EMPTY 0x10000L
+volatile int32_t hal_spdr0_latch = LATCH_EMPTY | 0xFF;
+volatile int32_t hal_udr0_latch = LATCH_EMPTY;
+
+// Interrupt flag registers can only be cleared by the firmware. We keep
+// the model's view of them here and undo any bits the firmware sets.
+#define NUM_FLAG_REGISTERS 4
+static const uint8_t flag_register[NUM_FLAG_REGISTERS] = {0x35, 0x36, 0x37, 0x3B};
+static uint8_t flag_model[NUM_FLAG_REGISTERS];
+
+static uint64_t cycles;
+static uint8_t servicing;
+static uint32_t isr_count;
+static void (*idle_hook)(void);
+
+// Cycles counted since each timer's last compare match
+static uint64_t timer_elapsed[3];
+
+static void (*spi_sink)(uint8_t byte);
+static uint32_t spi_byte_count;
+
+static void (*uart_tx_sink)(uint8_t byte);
+static uint32_t uart_tx_byte_count;
+static uint8_t uart_rx_data;
+
+#define RX_FIFO_SIZE 4096
+static uint8_t rx_fifo[RX_FIFO_SIZE];
+static uint16_t rx_head;
+static uint16_t rx_tail;
+static uint64_t rx_next_cycle;
+
+static uint16_t adc_input[8];
+// Cycles into the current free running conversion, and the channel it
+// is converting (ADMUX when it started)
+static uint64_t adc_elapsed;
+static uint8_t adc_channel;
+
+// Vectors the firmware doesn't use
+#define WEAK_ISR(name) void name(void) __attribute__((weak)); void name(void) { }
+WEAK_ISR(hal_isr_pcint1)
+WEAK_ISR(hal_isr_timer2_compa)
+WEAK_ISR(hal_isr_timer1_compa)
+WEAK_ISR(hal_isr_timer0_compa)
+WEAK_ISR(hal_isr_spi_stc)
+WEAK_ISR(hal_isr_usart0_rx)
+WEAK_ISR(hal_isr_usart0_udre)
+WEAK_ISR(hal_isr_adc)
+
+static void set_flag(uint8_t index, uint8_t bit)
+{
+	flag_model[index] |= _BV(bit);
+	hal_mem[flag_register[index]] = flag_model[index];
+}
+
+static void clear_flag(uint8_t index, uint8_t bit)
+{
+	flag_model[index] &= ~_BV(bit);
+	hal_mem[flag_register[index]] = flag_model[index];
+}
+
+#define FLAG_TIFR0 0
+#define FLAG_TIFR1 1
+#define FLAG_TIFR2 2
+#define FLAG_PCIFR 3
+
+void hal_reset(void)
+{
+	memset(hal_mem, 0, sizeof(hal_mem));
+	memset(flag_model, 0, sizeof(flag_model));
+	memset(timer_elapsed, 0, sizeof(timer_elapsed));
+	memset(adc_input, 0, sizeof(adc_input));
+	adc_elapsed = 0;
+	adc_channel = 0;
+	hal_spdr0_latch = LATCH_EMPTY | 0xFF;
+	hal_udr0_latch = LATCH_EMPTY;
+	cycles = 0;
+	servicing = 0;
+	isr_count = 0;
+	spi_byte_count = 0;
+	uart_tx_byte_count = 0;
+	uart_rx_data = 0;
+	rx_head = rx_tail = 0;
+	rx_next_cycle = 0;
+	UCSR0A = _BV(UDRE0);
+}
+
+/////////////////////////////// peripherals ///////////////////////////////
+
+// Pick up a byte the firmware has written to SPDR0 and complete the
+// transfer.
+static void spi_capture(void)
+{
+	if (hal_spdr0_latch >= LATCH_EMPTY)
+	{
+		return;
+	}
+	uint8_t byte = (uint8_t)hal_spdr0_latch;
+	hal_spdr0_latch = LATCH_EMPTY | 0xFF;
+	spi_byte_count++;
+	SPSR0 |= _BV(SPIF0);
+	if (spi_sink)
+	{
+		spi_sink(byte);
+	}
+}
+
+// Pick up a byte the firmware has written to UDR0. The transmitter is
+// always ready for another byte.
+static void uart_capture(void)
+{
+	if (hal_udr0_latch < LATCH_EMPTY)
+	{
+		uint8_t byte = (uint8_t)hal_udr0_latch;
+		hal_udr0_latch = LATCH_EMPTY | uart_rx_data;
+		uart_tx_byte_count++;
+		UCSR0A |= _BV(TXC0);
+		if (uart_tx_sink)
+		{
+			uart_tx_sink(byte);
+		}
+	}
+	UCSR0A |= _BV(UDRE0);
+}
+
+static uint64_t uart_byte_cycles(void)
+{
+	uint16_t ubrr = UBRR0 & 0x0FFF;
+	uint8_t divider = (UCSR0A & _BV(U2X0)) ? 8 : 16;
+	// start bit, 8 data bits, stop bit
+	return 10ULL * divider * (ubrr + 1);
+}
+
+// Move the next queued input byte into UDR0 if it has had time to arrive
+static void uart_receive(void)
+{
+	if (rx_head == rx_tail || !(UCSR0B & _BV(RXEN0)) || cycles < rx_next_cycle)
+	{
+		return;
+	}
+	uint8_t byte = rx_fifo[rx_tail];
+	rx_tail = (rx_tail + 1) % RX_FIFO_SIZE;
+	rx_next_cycle = cycles + uart_byte_cycles();
+	if (UCSR0A & _BV(RXC0))
+	{
+		// The previous byte was never read
+		UCSR0A |= _BV(DOR0);
+		return;
+	}
+	uart_capture();
+	uart_rx_data = byte;
+	hal_udr0_latch = LATCH_EMPTY | byte;
+	UCSR0A |= _BV(RXC0);
+}
+
+// In free running mode (auto trigger with ADTS = 0) conversions follow
+// one another every 13 ADC clocks once the first has been started
+static uint8_t adc_free_running(void)
+{
+	return (ADCSRA & _BV(ADEN)) && (ADCSRA & _BV(ADSC)) && (ADCSRA & _BV(ADATE))
+			&& (ADCSRB & 0x07) == 0;
+}
+
+// Cycles per free running conversion, 0 if the ADC isn't free running
+static uint32_t adc_period(void)
+{
+	if (!adc_free_running())
+	{
+		return 0;
+	}
+	uint8_t prescale = 1 << (ADCSRA & 0x07);
+	return 13UL * (prescale < 2 ? 2 : prescale);
+}
+
+// A single conversion started by setting ADSC completes straight away
+static void adc_convert(void)
+{
+	if (adc_free_running())
+	{
+		return;
+	}
+	adc_channel = ADMUX & 0x07;
+	if ((ADCSRA & _BV(ADEN)) && (ADCSRA & _BV(ADSC)))
+	{
+		ADC = adc_input[ADMUX & 0x07];
+		ADCSRA = (ADCSRA & ~_BV(ADSC)) | _BV(ADIF);
+	}
+}
+
+// CPU cycles per count for each timer, 0 if it is stopped
+static uint16_t timer_prescale(uint8_t timer)
+{
+	static const uint16_t timer01_prescale[8] = {0, 1, 8, 64, 256, 1024, 0, 0};
+	static const uint16_t timer2_prescale[8] = {0, 1, 8, 32, 64, 128, 256, 1024};
+
+	switch (timer)
+	{
+		case 0:
+			return timer01_prescale[TCCR0B & 0x07];
+		case 1:
+			return timer01_prescale[TCCR1B & 0x07];
+		default:
+			return timer2_prescale[TCCR2B & 0x07];
+	}
+}
+
+// Cycles between compare matches for each timer, 0 if it is stopped
+static uint32_t timer_period(uint8_t timer)
+{
+	uint16_t prescale = timer_prescale(timer);
+	uint32_t top;
+
+	switch (timer)
+	{
+		case 0:
+			top = (TCCR0A & _BV(WGM01)) ? OCR0A : 0xFF;
+			return prescale * (top + 1);
+		case 1:
+		{
+			uint8_t mode = ((TCCR1B >> WGM12) & 0x03) << 2 | (TCCR1A & 0x03);
+			switch (mode)
+			{
+				case 4: case 9: case 11: case 15:
+					top = OCR1A;
+					break;
+				case 8: case 10: case 12: case 14:
+					top = ICR1;
+					break;
+				case 1: case 5:
+					top = 0xFF;
+					break;
+				case 2: case 6:
+					top = 0x1FF;
+					break;
+				case 3: case 7:
+					top = 0x3FF;
+					break;
+				default:
+					top = 0xFFFF;
+					break;
+			}
+			// Phase correct modes count up and back down again
+			if ((mode >= 1 && mode <= 3) || (mode >= 8 && mode <= 11))
+			{
+				return prescale * top * 2;
+			}
+			return prescale * (top + 1);
+		}
+		default:
+			top = (TCCR2A & _BV(WGM21)) ? OCR2A : 0xFF;
+			return prescale * (top + 1);
+	}
+}
+
+static void call_isr(void (*isr)(void))
+{
+	// The I bit is cleared while an interrupt handler runs
+	SREG &= ~_BV(SREG_I);
+	isr();
+	SREG |= _BV(SREG_I);
+	isr_count++;
+	spi_capture();
+	uart_capture();
+}
+
+void hal_service(void)
+{
+	if (servicing)
+	{
+		return;
+	}
+	servicing = 1;
+
+	for (uint8_t i = 0; i < NUM_FLAG_REGISTERS; i++)
+	{
+		hal_mem[flag_register[i]] = flag_model[i];
+	}
+	spi_capture();
+	uart_capture();
+	adc_convert();
+
+	// Deliver pending interrupts in vector priority order. Each handler
+	// should clear its cause; the limit stops a handler that doesn't from
+	// hanging the model.
+	for (uint16_t limit = 0; limit < 4096 && (SREG & _BV(SREG_I)); limit++)
+	{
+		if ((flag_model[FLAG_PCIFR] & _BV(PCIF1)) && (PCICR & _BV(PCIE1)))
+		{
+			clear_flag(FLAG_PCIFR, PCIF1);
+			call_isr(hal_isr_pcint1);
+		} else if ((flag_model[FLAG_TIFR2] & _BV(OCF2A)) && (TIMSK2 & _BV(OCIE2A)))
+		{
+			clear_flag(FLAG_TIFR2, OCF2A);
+			call_isr(hal_isr_timer2_compa);
+		} else if ((flag_model[FLAG_TIFR1] & _BV(OCF1A)) && (TIMSK1 & _BV(OCIE1A)))
+		{
+			clear_flag(FLAG_TIFR1, OCF1A);
+			call_isr(hal_isr_timer1_compa);
+		} else if ((flag_model[FLAG_TIFR0] & _BV(OCF0A)) && (TIMSK0 & _BV(OCIE0A)))
+		{
+			clear_flag(FLAG_TIFR0, OCF0A);
+			call_isr(hal_isr_timer0_compa);
+		} else if ((SPSR0 & _BV(SPIF0)) && (SPCR0 & _BV(SPIE0)))
+		{
+			SPSR0 &= ~_BV(SPIF0);
+			call_isr(hal_isr_spi_stc);
+		} else if ((UCSR0A & _BV(RXC0)) && (UCSR0B & _BV(RXCIE0)))
+		{
+			call_isr(hal_isr_usart0_rx);
+		} else if ((UCSR0A & _BV(UDRE0)) && (UCSR0B & _BV(UDRIE0)))
+		{
+			call_isr(hal_isr_usart0_udre);
+		} else if ((ADCSRA & _BV(ADIF)) && (ADCSRA & _BV(ADIE)))
+		{
+			ADCSRA &= ~_BV(ADIF);
+			call_isr(hal_isr_adc);
+		} else
+		{
+			break;
+		}
+	}
+	servicing = 0;
+}
+
+/////////////////////////////// register hooks ////////////////////////////
+
+volatile uint8_t *hal_sfr8(uint16_t addr)
+{
+	hal_service();
+	return &hal_mem[addr];
+}
+
+volatile uint16_t *hal_sfr16(uint16_t addr)
+{
+	hal_service();
+	return (volatile uint16_t *)&hal_mem[addr];
+}
+
+volatile int32_t *hal_spdr0(void)
+{
+	hal_service();
+	// Accessing the data register completes the SPIF clearing sequence
+	SPSR0 &= ~_BV(SPIF0);
+	return &hal_spdr0_latch;
+}
+
+volatile int32_t *hal_udr0(void)
+{
+	hal_service();
+	UCSR0A &= ~(_BV(RXC0) | _BV(DOR0));
+	return &hal_udr0_latch;
+}
+
+void hal_cli(void)
+{
+	SREG &= ~_BV(SREG_I);
+}
+
+void hal_sei(void)
+{
+	SREG |= _BV(SREG_I);
+	hal_service();
+}
+
+/////////////////////////////// time //////////////////////////////////////
+
+uint64_t hal_cycles(void)
+{
+	return cycles;
+}
+
+uint32_t hal_time_ms(void)
+{
+	return (uint32_t)(cycles / (HAL_F_CPU / 1000));
+}
+
+// Cycles until the next timer compare match or serial input byte, at
+// most limit
+static uint64_t cycles_to_next_event(uint64_t limit, uint32_t period[3])
+{
+	uint64_t step = limit;
+	for (uint8_t timer = 0; timer < 3; timer++)
+	{
+		period[timer] = timer_period(timer);
+		if (!period[timer])
+		{
+			continue;
+		}
+		if (timer_elapsed[timer] >= period[timer])
+		{
+			// The period was shortened under us
+			timer_elapsed[timer] = 0;
+		}
+		if (period[timer] - timer_elapsed[timer] < step)
+		{
+			step = period[timer] - timer_elapsed[timer];
+		}
+	}
+	if (rx_head != rx_tail && rx_next_cycle > cycles && rx_next_cycle - cycles < step)
+	{
+		step = rx_next_cycle - cycles;
+	}
+	uint32_t adc = adc_period();
+	if (adc)
+	{
+		if (adc_elapsed >= adc)
+		{
+			adc_elapsed = 0;
+		}
+		if (adc - adc_elapsed < step)
+		{
+			step = adc - adc_elapsed;
+		}
+	}
+	return step;
+}
+
+void hal_advance_cycles(uint64_t count)
+{
+	uint64_t end = cycles + count;
+	for (;;)
+	{
+		uart_receive();
+		hal_service();
+		if (cycles >= end)
+		{
+			break;
+		}
+
+		// Step to the next thing that happens
+		uint32_t period[3];
+		uint64_t step = cycles_to_next_event(end - cycles, period);
+		uint32_t adc = adc_period();
+
+		cycles += step;
+		if (adc)
+		{
+			adc_elapsed += step;
+			if (adc_elapsed >= adc)
+			{
+				// The next conversion starts straight away on the
+				// channel selected now
+				adc_elapsed -= adc;
+				ADC = adc_input[adc_channel];
+				adc_channel = ADMUX & 0x07;
+				ADCSRA |= _BV(ADIF);
+			}
+		} else
+		{
+			adc_elapsed = 0;
+		}
+		for (uint8_t timer = 0; timer < 3; timer++)
+		{
+			if (!period[timer])
+			{
+				continue;
+			}
+			timer_elapsed[timer] += step;
+			if (timer_elapsed[timer] >= period[timer])
+			{
+				timer_elapsed[timer] -= period[timer];
+				set_flag(timer, timer == 0 ? OCF0A : timer == 1 ? OCF1A : OCF2A);
+			}
+		}
+		// The counters as the firmware would read them
+		if (period[0])
+		{
+			TCNT0 = timer_elapsed[0] / timer_prescale(0);
+		}
+		if (period[1])
+		{
+			TCNT1 = timer_elapsed[1] / timer_prescale(1);
+		}
+		if (period[2])
+		{
+			TCNT2 = timer_elapsed[2] / timer_prescale(2);
+		}
+	}
+}
+
+void hal_advance_time_us(uint32_t us)
+{
+	hal_advance_cycles((uint64_t)us * (HAL_F_CPU / 1000000));
+}
+
+void hal_advance_time_ms(uint32_t ms)
+{
+	hal_advance_cycles((uint64_t)ms * (HAL_F_CPU / 1000));
+}
+
+void hal_set_time_ms(uint32_t ms)
+{
+	uint64_t target = (uint64_t)ms * (HAL_F_CPU / 1000);
+	if (target > cycles)
+	{
+		hal_advance_cycles(target - cycles);
+	}
+}
+
+void hal_delay_us(uint32_t us)
+{
+	hal_advance_time_us(us);
+}
+
+void hal_sleep_cpu(void)
+{
+	if (!(SMCR & _BV(SE)))
+	{
+		return;
+	}
+	if (idle_hook)
+	{
+		idle_hook();
+	}
+
+	// Sleep until an interrupt handler has run. An interrupt can't wake
+	// the CPU with interrupts disabled; if nothing happens for a second
+	// we give up rather than hang.
+	uint32_t handled = isr_count;
+	uint64_t slept = 0;
+	while (isr_count == handled && (SREG & _BV(SREG_I)) && slept < HAL_F_CPU)
+	{
+		uint32_t period[3];
+		uint64_t step = cycles_to_next_event(HAL_F_CPU - slept, period);
+		hal_advance_cycles(step);
+		slept += step;
+	}
+}
+
+void hal_set_idle_hook(void (*hook)(void))
+{
+	idle_hook = hook;
+}
+
+/////////////////////////////// inputs and outputs ////////////////////////
+
+void hal_set_spi_sink(void (*sink)(uint8_t byte))
+{
+	spi_sink = sink;
+}
+
+uint32_t hal_spi_byte_count(void)
+{
+	return spi_byte_count;
+}
+
+void hal_set_uart_tx_sink(void (*sink)(uint8_t byte))
+{
+	uart_tx_sink = sink;
+}
+
+uint32_t hal_uart_tx_byte_count(void)
+{
+	return uart_tx_byte_count;
+}
+
+void hal_uart_rx_push_byte(uint8_t byte)
+{
+	uint16_t next = (rx_head + 1) % RX_FIFO_SIZE;
+	if (next == rx_tail)
+	{
+		// Nobody is reading - drop it like a real line would
+		return;
+	}
+	rx_fifo[rx_head] = byte;
+	rx_head = next;
+	uart_receive();
+	hal_service();
+}
+
+void hal_uart_rx_push_string(const char *s)
+{
+	while (*s)
+	{
+		hal_uart_rx_push_byte((uint8_t)*s++);
+	}
+}
+
+uint16_t hal_uart_rx_pending(void)
+{
+	return (rx_head - rx_tail + RX_FIFO_SIZE) % RX_FIFO_SIZE;
+}
+
+void hal_set_pinb(uint8_t value)
+{
+	uint8_t changed = PINB ^ value;
+	PINB = value;
+	if ((changed & PCMSK1) && (PCICR & _BV(PCIE1)))
+	{
+		set_flag(FLAG_PCIFR, PCIF1);
+	}
+	hal_service();
+}
+
+void hal_adc_set_input(uint8_t channel, uint16_t value)
+{
+	adc_input[channel & 0x07] = value & 0x3FF;
+}
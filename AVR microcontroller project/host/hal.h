@@ -0,0 +1,74 @@
+/*
+ * hal.h
+ *
+ * Control side of the host build's hardware model. The firmware sources
+ * are compiled against the shim headers in host/include and talk to the
+ * modelled registers exactly as they would on the ATmega324A. Host tools
+ * (benchmarks, test drivers) include this header to drive the model:
+ * advance the clock, feed serial input, press buttons, move the joystick
+ * and watch the bytes the firmware sends over SPI and the UART.
+ *
+ * Peripherals are modelled as infinitely fast - an SPI or UART byte is
+ * "sent" as soon as the model next gets control - except where the
+ * firmware depends on time passing: the timer compare interrupts fire
+ * and serial input arrives at the rates the registers are set up for.
+ * The clock only moves when a tool advances it, the firmware calls
+ * _delay_ms()/_delay_us() or the firmware sleeps (sleep_cpu() moves the
+ * clock on to the next interrupt).
+ */
+
+#ifndef HAL_H_
+#define HAL_H_
+
+#include <stdint.h>
+
+// Modelled CPU clock (matches F_CPU in the firmware)
+#define HAL_F_CPU 8000000UL
+
+// Put every register, the clock and all counters back to their reset
+// values. Sinks installed below are kept.
+void hal_reset(void);
+
+// Give the peripheral models a chance to run and deliver any pending
+// interrupts (if interrupts are enabled). The firmware does this itself
+// on every register access; tools only need it after changing inputs.
+void hal_service(void);
+
+// Modelled time. The clock is measured in CPU cycles since hal_reset().
+uint64_t hal_cycles(void);
+uint32_t hal_time_ms(void);
+void hal_advance_cycles(uint64_t cycles);
+void hal_advance_time_us(uint32_t us);
+void hal_advance_time_ms(uint32_t ms);
+
+// Move the clock forward to the given number of milliseconds since reset
+// (get_current_time() will return this once timer 0 has been set up).
+// The clock never runs backwards - earlier times are ignored.
+void hal_set_time_ms(uint32_t ms);
+
+// SPI output. The sink (if any) sees every byte the firmware transmits.
+void hal_set_spi_sink(void (*sink)(uint8_t byte));
+uint32_t hal_spi_byte_count(void);
+
+// UART output. The sink (if any) sees every byte written to UDR0.
+void hal_set_uart_tx_sink(void (*sink)(uint8_t byte));
+uint32_t hal_uart_tx_byte_count(void);
+
+// UART input. Bytes are queued here and arrive in UDR0 one at a time at
+// the configured baud rate as the clock advances.
+void hal_uart_rx_push_byte(uint8_t byte);
+void hal_uart_rx_push_string(const char *s);
+uint16_t hal_uart_rx_pending(void);
+
+// Called each time the firmware goes to sleep, before the clock moves on
+// to the next interrupt. Lets a tool feed input to a firmware main loop.
+void hal_set_idle_hook(void (*hook)(void));
+
+// Set the level of the port B input pins (push buttons are on B0 to B3).
+// Pin change interrupts fire for any enabled pin that changes.
+void hal_set_pinb(uint8_t value);
+
+// Set the voltage seen on an ADC channel (0 to 1023).
+void hal_adc_set_input(uint8_t channel, uint16_t value);
+
+#endif /* HAL_H_ */
@@ -0,0 +1,114 @@
+/*
+ * hal_stdio.c
+ *
+ * avr-libc style stdio for the host build (see host/include/stdio.h).
+ * Formatting is done by the C library; the characters are then handed
+ * to the stream's put function one at a time, as avr-libc does.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+FILE *hal_iob[3];
+
+int hal_vfprintf(FILE *stream, const char *fmt, va_list ap)
+{
+	char small[256];
+	char *buf = small;
+	va_list copy;
+
+	if (!stream || !stream->put)
+	{
+		return EOF;
+	}
+
+	va_copy(copy, ap);
+	int len = vsnprintf(small, sizeof(small), fmt, ap);
+	if (len >= (int)sizeof(small))
+	{
+		buf = malloc(len + 1);
+		if (!buf)
+		{
+			va_end(copy);
+			return EOF;
+		}
+		vsnprintf(buf, len + 1, fmt, copy);
+	}
+	va_end(copy);
+
+	for (int i = 0; i < len; i++)
+	{
+		stream->put(buf[i], stream);
+	}
+	if (buf != small)
+	{
+		free(buf);
+	}
+	return len;
+}
+
+int hal_fprintf(FILE *stream, const char *fmt, ...)
+{
+	va_list ap;
+	va_start(ap, fmt);
+	int len = hal_vfprintf(stream, fmt, ap);
+	va_end(ap);
+	return len;
+}
+
+int hal_printf(const char *fmt, ...)
+{
+	va_list ap;
+	va_start(ap, fmt);
+	int len = hal_vfprintf(stdout, fmt, ap);
+	va_end(ap);
+	return len;
+}
+
+int hal_fputc(int c, FILE *stream)
+{
+	if (!stream || !stream->put || !(stream->flags & _FDEV_SETUP_WRITE))
+	{
+		return EOF;
+	}
+	if (stream->put((char)c, stream) != 0)
+	{
+		return EOF;
+	}
+	return (unsigned char)c;
+}
+
+int hal_fputs(const char *s, FILE *stream)
+{
+	while (*s)
+	{
+		if (hal_fputc(*s++, stream) == EOF)
+		{
+			return EOF;
+		}
+	}
+	return 0;
+}
+
+int hal_puts(const char *s)
+{
+	if (hal_fputs(s, stdout) == EOF)
+	{
+		return EOF;
+	}
+	return hal_fputc('\n', stdout) == EOF ? EOF : 0;
+}
+
+int hal_fgetc(FILE *stream)
+{
+	if (!stream || !stream->get || !(stream->flags & _FDEV_SETUP_READ))
+	{
+		return EOF;
+	}
+	int c = stream->get(stream);
+	if (c < 0)
+	{
+		return EOF;
+	}
+	return c & 0xFF;
+}
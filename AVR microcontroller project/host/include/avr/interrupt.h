@@ -0,0 +1,26 @@
+/*
+ * avr/interrupt.h (host shim)
+ *
+ * ISR(vector) defines an ordinary function that the peripheral models in
+ * host/hal.c call when the interrupt fires. cli() and sei() clear and set
+ * the modelled I bit in SREG; sei() also lets any interrupt that became
+ * pending while interrupts were off run straight away.
+ */
+
+#ifndef HOST_AVR_INTERRUPT_H_
+#define HOST_AVR_INTERRUPT_H_
+
+#include <avr/io.h>
+
+void hal_cli(void);
+void hal_sei(void);
+
+#define cli() hal_cli()
+#define sei() hal_sei()
+
+#define ISR_BLOCK
+#define ISR_NOBLOCK
+#define ISR_NAKED
+#define ISR(vector, ...) void vector(void)
+
+#endif /* HOST_AVR_INTERRUPT_H_ */
@@ -0,0 +1,313 @@
+/*
+ * avr/io.h (host shim)
+ *
+ * Stand-in for avr-libc's <avr/io.h> used by the host build. Every
+ * ATmega324A register the firmware touches is mapped onto a modelled
+ * data space owned by host/hal.c. Each register access goes through a
+ * small hook so that the peripheral models (SPI, USART0, timers, ADC,
+ * pin change interrupts) get a chance to run - much like a real
+ * peripheral that works in parallel with the CPU.
+ *
+ * SPDR0 and UDR0 are special: a write to them has a side effect (a byte
+ * is transmitted) so they are backed by a latch that lets the model tell
+ * a write from a read.
+ */
+
+#ifndef HOST_AVR_IO_H_
+#define HOST_AVR_IO_H_
+
+#include <stdint.h>
+
+#define HAL_MEM_SIZE 0x100
+
+extern uint8_t hal_mem[HAL_MEM_SIZE];
+extern volatile int32_t hal_spdr0_latch;
+extern volatile int32_t hal_udr0_latch;
+
+volatile uint8_t *hal_sfr8(uint16_t addr);
+volatile uint16_t *hal_sfr16(uint16_t addr);
+volatile int32_t *hal_spdr0(void);
+volatile int32_t *hal_udr0(void);
+
+#ifdef HAL_INTERNAL
+// Inside the model itself registers are plain memory - no hooks
+#define _SFR_MEM8(addr) (*(volatile uint8_t *)&hal_mem[(addr)])
+#define _SFR_MEM16(addr) (*(volatile uint16_t *)&hal_mem[(addr)])
+#define SPDR0 hal_spdr0_latch
+#define UDR0 hal_udr0_latch
+#else
+#define _SFR_MEM8(addr) (*hal_sfr8(addr))
+#define _SFR_MEM16(addr) (*hal_sfr16(addr))
+#define SPDR0 (*hal_spdr0())
+#define UDR0 (*hal_udr0())
+#endif
+
+#define _BV(bit) (1 << (bit))
+#define bit_is_set(sfr, bit) ((sfr) & _BV(bit))
+#define bit_is_clear(sfr, bit) (!((sfr) & _BV(bit)))
+#define loop_until_bit_is_set(sfr, bit) do { } while (bit_is_clear(sfr, bit))
+#define loop_until_bit_is_clear(sfr, bit) do { } while (bit_is_set(sfr, bit))
+
+/* Ports */
+#define PINA _SFR_MEM8(0x20)
+#define DDRA _SFR_MEM8(0x21)
+#define PORTA _SFR_MEM8(0x22)
+#define PINB _SFR_MEM8(0x23)
+#define DDRB _SFR_MEM8(0x24)
+#define PORTB _SFR_MEM8(0x25)
+#define PINC _SFR_MEM8(0x26)
+#define DDRC _SFR_MEM8(0x27)
+#define PORTC _SFR_MEM8(0x28)
+#define PIND _SFR_MEM8(0x29)
+#define DDRD _SFR_MEM8(0x2A)
+#define PORTD _SFR_MEM8(0x2B)
+
+#define PINB0 0
+#define PINB1 1
+#define PINB2 2
+#define PINB3 3
+#define PINB4 4
+#define PINB5 5
+#define PINB6 6
+#define PINB7 7
+#define DDB0 0
+#define DDB1 1
+#define DDB2 2
+#define DDB3 3
+#define DDB4 4
+#define DDB5 5
+#define DDB6 6
+#define DDB7 7
+#define PORTB0 0
+#define PORTB1 1
+#define PORTB2 2
+#define PORTB3 3
+#define PORTB4 4
+#define PORTB5 5
+#define PORTB6 6
+#define PORTB7 7
+#define DDD4 4
+#define PORTD4 4
+
+/* Interrupt flag registers */
+#define TIFR0 _SFR_MEM8(0x35)
+#define TOV0 0
+#define OCF0A 1
+#define OCF0B 2
+#define TIFR1 _SFR_MEM8(0x36)
+#define TOV1 0
+#define OCF1A 1
+#define OCF1B 2
+#define ICF1 5
+#define TIFR2 _SFR_MEM8(0x37)
+#define TOV2 0
+#define OCF2A 1
+#define OCF2B 2
+#define PCIFR _SFR_MEM8(0x3B)
+#define PCIF0 0
+#define PCIF1 1
+#define PCIF2 2
+#define PCIF3 3
+
+#define GPIOR0 _SFR_MEM8(0x3E)
+#define GPIOR1 _SFR_MEM8(0x4A)
+#define GPIOR2 _SFR_MEM8(0x4B)
+
+/* Timer/Counter 0 */
+#define TCCR0A _SFR_MEM8(0x44)
+#define WGM00 0
+#define WGM01 1
+#define COM0B0 4
+#define COM0B1 5
+#define COM0A0 6
+#define COM0A1 7
+#define TCCR0B _SFR_MEM8(0x45)
+#define CS00 0
+#define CS01 1
+#define CS02 2
+#define WGM02 3
+#define TCNT0 _SFR_MEM8(0x46)
+#define OCR0A _SFR_MEM8(0x47)
+#define OCR0B _SFR_MEM8(0x48)
+
+/* SPI */
+#define SPCR0 _SFR_MEM8(0x4C)
+#define SPR00 0
+#define SPR10 1
+#define CPHA0 2
+#define CPOL0 3
+#define MSTR0 4
+#define DORD0 5
+#define SPE0 6
+#define SPIE0 7
+#define SPSR0 _SFR_MEM8(0x4D)
+#define SPI2X0 0
+#define WCOL0 6
+#define SPIF0 7
+
+/* Sleep mode, status and control */
+#define SMCR _SFR_MEM8(0x53)
+#define SE 0
+#define SM0 1
+#define SM1 2
+#define SM2 3
+#define MCUSR _SFR_MEM8(0x54)
+#define MCUCR _SFR_MEM8(0x55)
+#define SREG _SFR_MEM8(0x5F)
+#define SREG_I 7
+
+/* Interrupt masks */
+#define PCICR _SFR_MEM8(0x68)
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+#define PCIE3 3
+#define PCMSK0 _SFR_MEM8(0x6B)
+#define PCMSK1 _SFR_MEM8(0x6C)
+#define PCINT8 0
+#define PCINT9 1
+#define PCINT10 2
+#define PCINT11 3
+#define PCINT12 4
+#define PCINT13 5
+#define PCINT14 6
+#define PCINT15 7
+#define PCMSK2 _SFR_MEM8(0x6D)
+#define TIMSK0 _SFR_MEM8(0x6E)
+#define TOIE0 0
+#define OCIE0A 1
+#define OCIE0B 2
+#define TIMSK1 _SFR_MEM8(0x6F)
+#define TOIE1 0
+#define OCIE1A 1
+#define OCIE1B 2
+#define ICIE1 5
+#define TIMSK2 _SFR_MEM8(0x70)
+#define TOIE2 0
+#define OCIE2A 1
+#define OCIE2B 2
+#define PCMSK3 _SFR_MEM8(0x73)
+
+/* ADC */
+#define ADC _SFR_MEM16(0x78)
+#define ADCW ADC
+#define ADCL _SFR_MEM8(0x78)
+#define ADCH _SFR_MEM8(0x79)
+#define ADCSRA _SFR_MEM8(0x7A)
+#define ADPS0 0
+#define ADPS1 1
+#define ADPS2 2
+#define ADIE 3
+#define ADIF 4
+#define ADATE 5
+#define ADSC 6
+#define ADEN 7
+#define ADCSRB _SFR_MEM8(0x7B)
+#define ADTS0 0
+#define ADTS1 1
+#define ADTS2 2
+#define ADMUX _SFR_MEM8(0x7C)
+#define MUX0 0
+#define MUX1 1
+#define MUX2 2
+#define MUX3 3
+#define MUX4 4
+#define ADLAR 5
+#define REFS0 6
+#define REFS1 7
+#define DIDR0 _SFR_MEM8(0x7E)
+
+/* Timer/Counter 1 */
+#define TCCR1A _SFR_MEM8(0x80)
+#define WGM10 0
+#define WGM11 1
+#define COM1B0 4
+#define COM1B1 5
+#define COM1A0 6
+#define COM1A1 7
+#define TCCR1B _SFR_MEM8(0x81)
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define WGM12 3
+#define WGM13 4
+#define ICES1 6
+#define ICNC1 7
+#define TCCR1C _SFR_MEM8(0x82)
+#define TCNT1 _SFR_MEM16(0x84)
+#define ICR1 _SFR_MEM16(0x86)
+#define OCR1A _SFR_MEM16(0x88)
+#define OCR1B _SFR_MEM16(0x8A)
+
+/* Timer/Counter 2 */
+#define TCCR2A _SFR_MEM8(0xB0)
+#define WGM20 0
+#define WGM21 1
+#define COM2B0 4
+#define COM2B1 5
+#define COM2A0 6
+#define COM2A1 7
+#define TCCR2B _SFR_MEM8(0xB1)
+#define CS20 0
+#define CS21 1
+#define CS22 2
+#define WGM22 3
+#define TCNT2 _SFR_MEM8(0xB2)
+#define OCR2A _SFR_MEM8(0xB3)
+#define OCR2B _SFR_MEM8(0xB4)
+
+/* USART0 */
+#define UCSR0A _SFR_MEM8(0xC0)
+#define MPCM0 0
+#define U2X0 1
+#define UPE0 2
+#define DOR0 3
+#define FE0 4
+#define UDRE0 5
+#define TXC0 6
+#define RXC0 7
+#define UCSR0B _SFR_MEM8(0xC1)
+#define TXB80 0
+#define RXB80 1
+#define UCSZ02 2
+#define TXEN0 3
+#define RXEN0 4
+#define UDRIE0 5
+#define TXCIE0 6
+#define RXCIE0 7
+#define UCSR0C _SFR_MEM8(0xC2)
+#define UCPOL0 0
+#define UCSZ00 1
+#define UCSZ01 2
+#define USBS0 3
+#define UPM00 4
+#define UPM01 5
+#define UMSEL00 6
+#define UMSEL01 7
+#define UBRR0 _SFR_MEM16(0xC4)
+#define UBRR0L _SFR_MEM8(0xC4)
+#define UBRR0H _SFR_MEM8(0xC5)
+
+/* Interrupt vectors. ISR(vector) defines a function of this name which
+ * the model calls when the interrupt fires. Vectors the firmware does
+ * not define fall back to empty (weak) handlers in hal.c.
+ */
+#define PCINT1_vect hal_isr_pcint1
+#define TIMER2_COMPA_vect hal_isr_timer2_compa
+#define TIMER1_COMPA_vect hal_isr_timer1_compa
+#define TIMER0_COMPA_vect hal_isr_timer0_compa
+#define SPI_STC_vect hal_isr_spi_stc
+#define USART0_RX_vect hal_isr_usart0_rx
+#define USART0_UDRE_vect hal_isr_usart0_udre
+#define ADC_vect hal_isr_adc
+
+void hal_isr_pcint1(void);
+void hal_isr_timer2_compa(void);
+void hal_isr_timer1_compa(void);
+void hal_isr_timer0_compa(void);
+void hal_isr_spi_stc(void);
+void hal_isr_usart0_rx(void);
+void hal_isr_usart0_udre(void);
+void hal_isr_adc(void);
+
+#endif /* HOST_AVR_IO_H_ */
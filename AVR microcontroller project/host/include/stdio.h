@@ -0,0 +1,86 @@
+/*
+ * stdio.h (host shim)
+ *
+ * avr-libc style standard IO for the host build. Streams are user
+ * supplied put/get functions (see FDEV_SETUP_STREAM) exactly as on the
+ * AVR, so serialio.c can install its UART stream as stdin/stdout
+ * unchanged. The stream functions are renamed so they never collide with
+ * the C library's own printf() and friends, which the host tools use for
+ * their real output.
+ */
+
+#ifndef HOST_STDIO_H_
+#define HOST_STDIO_H_
+
+#include <stdarg.h>
+#include <stddef.h>
+
+struct __file {
+	char *buf;
+	unsigned char unget;
+	unsigned char flags;
+	int size;
+	int len;
+	int (*put)(char, struct __file *);
+	int (*get)(struct __file *);
+	void *udata;
+};
+
+typedef struct __file FILE;
+
+#define EOF (-1)
+
+#define _FDEV_SETUP_READ 0x01
+#define _FDEV_SETUP_WRITE 0x02
+#define _FDEV_SETUP_RW (_FDEV_SETUP_READ | _FDEV_SETUP_WRITE)
+#define _FDEV_ERR (-1)
+#define _FDEV_EOF (-2)
+
+#define FDEV_SETUP_STREAM(p, g, f) \
+	{ .put = (p), .get = (g), .flags = (f), .udata = 0 }
+#define fdev_setup_stream(stream, p, g, f) \
+	do { (stream)->put = (p); (stream)->get = (g); (stream)->flags = (f); \
+		(stream)->udata = 0; } while (0)
+#define fdev_set_udata(stream, u) do { (stream)->udata = (u); } while (0)
+#define fdev_get_udata(stream) ((stream)->udata)
+
+extern FILE *hal_iob[3];
+#define stdin (hal_iob[0])
+#define stdout (hal_iob[1])
+#define stderr (hal_iob[2])
+
+int hal_vfprintf(FILE *stream, const char *fmt, va_list ap);
+int hal_fprintf(FILE *stream, const char *fmt, ...);
+int hal_printf(const char *fmt, ...);
+int hal_fputc(int c, FILE *stream);
+int hal_fputs(const char *s, FILE *stream);
+int hal_puts(const char *s);
+int hal_fgetc(FILE *stream);
+
+#define vfprintf hal_vfprintf
+#define vfprintf_P hal_vfprintf
+#define fprintf hal_fprintf
+#define fprintf_P hal_fprintf
+#define printf hal_printf
+#define printf_P hal_printf
+#define vprintf(fmt, ap) hal_vfprintf(stdout, (fmt), (ap))
+#define fputc hal_fputc
+#define putc hal_fputc
+#define putchar(c) hal_fputc((c), stdout)
+#define fputs hal_fputs
+#define fputs_P hal_fputs
+#define puts hal_puts
+#define puts_P hal_puts
+#define fgetc hal_fgetc
+#define getc hal_fgetc
+#define getchar() hal_fgetc(stdin)
+
+// String formatting has no device behind it so the C library does it
+int sprintf(char *s, const char *fmt, ...);
+int snprintf(char *s, size_t n, const char *fmt, ...);
+int vsnprintf(char *s, size_t n, const char *fmt, va_list ap);
+#define sprintf_P sprintf
+#define snprintf_P snprintf
+#define vsnprintf_P vsnprintf
+
+#endif /* HOST_STDIO_H_ */
@@ -0,0 +1,19 @@
+/*
+ * util/delay.h (host shim)
+ *
+ * Busy-wait delays advance the modelled clock instead of burning host
+ * time. Timer interrupts that fall within the delay are delivered as the
+ * clock passes them, as they would be on the board.
+ */
+
+#ifndef HOST_UTIL_DELAY_H_
+#define HOST_UTIL_DELAY_H_
+
+#include <stdint.h>
+
+void hal_delay_us(uint32_t us);
+
+#define _delay_us(us) hal_delay_us((uint32_t)(us))
+#define _delay_ms(ms) hal_delay_us((uint32_t)(ms) * 1000UL)
+
+#endif /* HOST_UTIL_DELAY_H_ */
@@ -0,0 +1,106 @@
+/*
+ * input_check.c
+ *
+ * Host check for the input queue. Runs the firmware's own play_game()
+ * (see hal.h) and, each time it goes idle, posts a burst of remote moves
+ * for it to handle. The moves of a burst are merged in the input queue
+ * into one move that can be many times the width of the grid. Checks
+ * that the cursor stays on the board and ends up where the moves,
+ * wrapping round the grid, should have taken it. Exits non-zero if not.
+ *
+ * Usage: input_check
+ */
+
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hal.h"
+#include "game.h"
+#include "input.h"
+#include "remote_protocol.h"
+
+// Firmware globals and functions that aren't in a header
+extern uint32_t is_muted;
+extern uint8_t cursor_x, cursor_y;
+void initialise_hardware(void);
+void new_game(void);
+void play_game(void);
+
+// Each burst is this many moves of dx, dy
+typedef struct {
+	uint8_t count;
+	int8_t dx, dy;
+} Burst;
+
+static const Burst bursts[] = {
+	{1, -1, 0},
+	{2, -REMOTE_MAX_MOVE, -REMOTE_MAX_MOVE},
+	{10, -REMOTE_MAX_MOVE, REMOTE_MAX_MOVE},
+	{10, REMOTE_MAX_MOVE, -REMOTE_MAX_MOVE},
+	{9, -REMOTE_MAX_MOVE, -5},
+	{16, 3, -REMOTE_MAX_MOVE},
+	{5, -6, 6},
+};
+#define NUM_BURSTS (sizeof(bursts) / sizeof(bursts[0]))
+
+static size_t next_burst;
+static int expected_x, expected_y;
+static int failures;
+static jmp_buf done;
+
+static int wrap(int position)
+{
+	return (position % 8 + 8) % 8;
+}
+
+// Check where the last burst left the cursor, then post the next
+static void idle(void)
+{
+	if (cursor_x != expected_x || cursor_y != expected_y)
+	{
+		printf("after burst %zu the cursor is at %u, %u, not %d, %d\n", next_burst,
+				cursor_x, cursor_y, expected_x, expected_y);
+		failures++;
+	}
+	if (next_burst == NUM_BURSTS)
+	{
+		longjmp(done, 1);
+	}
+	const Burst *burst = &bursts[next_burst++];
+	for (uint8_t i = 0; i < burst->count; i++)
+	{
+		if (!input_post_move(burst->dx, burst->dy, INPUT_FROM_REMOTE, hal_time_ms()))
+		{
+			printf("burst %zu didn't fit in the input queue\n", next_burst);
+			failures++;
+		}
+		expected_x = wrap(expected_x + burst->dx);
+		expected_y = wrap(expected_y + burst->dy);
+	}
+}
+
+int main(void)
+{
+	hal_reset();
+	hal_adc_set_input(0, 512);
+	hal_adc_set_input(1, 512);
+	initialise_hardware();
+	is_muted = 1;
+
+	new_game();
+	expected_x = cursor_x;
+	expected_y = cursor_y;
+	hal_set_idle_hook(idle);
+	if (!setjmp(done))
+	{
+		play_game();
+	}
+	hal_set_idle_hook(NULL);
+
+	InputStats stats = input_stats();
+	printf("%zu bursts of remote moves, %u merged: %s\n", NUM_BURSTS, stats.coalesced,
+			failures ? "FAILED" : "cursor stayed on the board");
+	return failures != 0;
+}
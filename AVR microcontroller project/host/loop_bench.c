@@ -0,0 +1,162 @@
+/*
+ * loop_bench.c
+ *
+ * Host benchmark for the main loop. Runs the firmware's own play_game()
+ * (see hal.h) with the joystick centred, typing keys into the serial
+ * port whenever the firmware goes idle: fire at every cell row by row,
+ * as simavr_bench does. Reports how often each task ran and missed its
+ * deadline, how long input events waited to be handled and how often the
+ * firmware went idle. Firmware code takes no modelled time on the host,
+ * so the scheduler's task runtimes aren't shown; they only mean
+ * something on the board or under simavr.
+ *
+ * Usage: loop_bench [-g games] [-m basic|search|prob] [-i interval_ms] [-k keys]
+ *   -i  modelled time between keys (default 400ms, long enough for the
+ *       computer's firing animation to finish between shots)
+ *   -k  keys to type, repeated as needed
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hal.h"
+#include "scheduler.h"
+#include "game.h"
+#include "input.h"
+
+// Firmware globals and functions that aren't in a header
+extern uint32_t is_muted;
+extern TaskId input_task, flash_task, animation_task, reveal_task, display_task;
+extern TaskId think_task, events_task;
+void initialise_hardware(void);
+void new_game(void);
+void play_game(void);
+
+static const char *keys;
+static size_t key_length;
+static size_t next_key;
+static uint32_t key_interval_ms;
+static uint32_t last_key_ms;
+static uint64_t keys_typed;
+static uint64_t idle_count;
+
+// Type the next key if it is time to
+static void feed_keys(void)
+{
+	idle_count++;
+	if (hal_uart_rx_pending() || hal_time_ms() - last_key_ms < key_interval_ms)
+	{
+		return;
+	}
+	hal_uart_rx_push_byte(keys[next_key]);
+	next_key = (next_key + 1) % key_length;
+	last_key_ms = hal_time_ms();
+	keys_typed++;
+}
+
+static void print_task(const char *name, TaskId id)
+{
+	const TaskStats *stats = scheduler_task_stats(id);
+	if (!stats)
+	{
+		return;
+	}
+	printf("%-20s %10lu runs %8u deadline misses\n", name,
+			(unsigned long)stats->runs, stats->deadline_misses);
+}
+
+int main(int argc, char **argv)
+{
+	static char default_keys[8 * (8 * 2 + 1) + 1];
+	unsigned long games = 10;
+	const char *mode_name = "basic";
+	int opt;
+
+	key_interval_ms = 400;
+	while ((opt = getopt(argc, argv, "g:m:i:k:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'g':
+				games = strtoul(optarg, NULL, 0);
+				break;
+			case 'm':
+				mode_name = optarg;
+				break;
+			case 'i':
+				key_interval_ms = strtoul(optarg, NULL, 0);
+				break;
+			case 'k':
+				keys = optarg;
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-g games] [-m basic|search|prob] [-i interval_ms] [-k keys]\n",
+						argv[0]);
+				return 1;
+		}
+	}
+	if (!keys || !*keys)
+	{
+		// Fire at every cell, moving right along each row and up to the
+		// next
+		char *k = default_keys;
+		for (int row = 0; row < 8; row++)
+		{
+			for (int col = 0; col < 8; col++)
+			{
+				*k++ = 'f';
+				*k++ = 'd';
+			}
+			*k++ = 'w';
+		}
+		*k = '\0';
+		keys = default_keys;
+	}
+	key_length = strlen(keys);
+
+	hal_reset();
+	hal_adc_set_input(0, 512);
+	hal_adc_set_input(1, 512);
+	hal_set_idle_hook(feed_keys);
+	initialise_hardware();
+
+	if (strcmp(mode_name, "search") == 0)
+	{
+		game_mode = MODE_SEARCH_AND_DESTROY;
+	} else if (strcmp(mode_name, "prob") == 0)
+	{
+		game_mode = MODE_PROBABILITY_HUNT;
+	} else if (strcmp(mode_name, "basic") != 0)
+	{
+		fprintf(stderr, "unknown mode '%s'\n", mode_name);
+		return 1;
+	}
+	is_muted = 1;
+
+	uint32_t start_ms = hal_time_ms();
+	for (unsigned long game = 0; game < games; game++)
+	{
+		new_game();
+		play_game();
+	}
+
+	printf("%lu games in %.1f s modelled, %llu keys typed, %llu sleeps\n", games,
+			(hal_time_ms() - start_ms) / 1e3, (unsigned long long)keys_typed,
+			(unsigned long long)idle_count);
+	print_task("input", input_task);
+	print_task("cursor flash", flash_task);
+	print_task("fire animation", animation_task);
+	print_task("reveal timeout", reveal_task);
+	print_task("game events", events_task);
+	print_task("display", display_task);
+	print_task("computer thinking", think_task);
+
+	InputStats input = input_stats();
+	printf("Input: %u events, worst latency %u ms, %u queued at most, %u moves coalesced, "
+			"%u dropped\n", input.events, input.worst_latency_ms, input.most_queued,
+			input.coalesced, input.dropped);
+	return 0;
+}
@@ -0,0 +1,234 @@
+/*
+ * make_opening_book.c
+ *
+ * Generates opening_book_table.h: the computer's first shots in
+ * Probability Hunt mode, worked out on the host since the ships (sizes
+ * SHIP_SIZES in game.h) are the same every game.
+ *
+ * Every placement of the fleet can't be enumerated in reasonable time
+ * (there are around 10^11), so a large fixed-seed sample of random fleets
+ * stands in for them. The book is a decision tree: each node is the cell
+ * hit by the most sampled fleets that agree with the hits and misses on
+ * the way to it, and has a child for a miss and a child for a hit. It is
+ * stored as an implicit binary tree (node n's children are 2n + 1 for a
+ * miss and 2n + 2 for a hit), so there are no links, with the cell numbers
+ * packed into 6 bits each. The output is the same every run, so make only
+ * changes the file when the ship sizes or this generator do.
+ *
+ * Usage: make_opening_book [-d depth] [-n samples] [-s seed] output.h
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "game.h"
+#include "ledmatrix.h"
+
+#define NUM_CELLS (GRID_NUM_ROWS * GRID_NUM_COLUMNS)
+#define MAX_DEPTH 8
+
+static const uint8_t ship_sizes[] = SHIP_SIZES;
+#define NUM_SHIPS (sizeof(ship_sizes) / sizeof(ship_sizes[0]))
+
+static uint64_t *fleets;
+static uint8_t cells[(1 << MAX_DEPTH) - 1];
+static unsigned depth = 7;
+
+// Small, fixed PRNG so the tables don't depend on the host's rand()
+static uint64_t rng_state;
+
+static uint32_t rng_next(void)
+{
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 7;
+	rng_state ^= rng_state << 17;
+	return rng_state >> 32;
+}
+
+// A random fleet, largest ships placed first, each where it doesn't
+// overlap the ships already placed
+static uint64_t random_fleet(void)
+{
+	uint64_t fleet = 0;
+	for (unsigned i = 0; i < NUM_SHIPS; i++)
+	{
+		unsigned size = ship_sizes[i];
+		uint64_t ship;
+		do
+		{
+			ship = 0;
+			if (rng_next() & 1)
+			{
+				unsigned x = rng_next() % (GRID_NUM_COLUMNS - size + 1);
+				unsigned y = rng_next() % GRID_NUM_ROWS;
+				for (unsigned j = 0; j < size; j++)
+				{
+					ship |= 1ULL << (y * GRID_NUM_COLUMNS + x + j);
+				}
+			} else
+			{
+				unsigned x = rng_next() % GRID_NUM_COLUMNS;
+				unsigned y = rng_next() % (GRID_NUM_ROWS - size + 1);
+				for (unsigned j = 0; j < size; j++)
+				{
+					ship |= 1ULL << ((y + j) * GRID_NUM_COLUMNS + x);
+				}
+			}
+		} while (ship & fleet);
+		fleet |= ship;
+	}
+	return fleet;
+}
+
+// Fill in the subtree at node for the count fleets starting at first,
+// which agree with the shots fired so far. Fleets are reordered so that
+// those the node's shot misses come before those it hits. fallback is
+// used for the cell order if no sampled fleet is left.
+static void build(unsigned node, unsigned level, uint64_t fired, uint64_t *first, size_t count,
+		const uint32_t *fallback)
+{
+	uint32_t hits[NUM_CELLS] = {0};
+	for (size_t i = 0; i < count; i++)
+	{
+		for (uint64_t cells_left = first[i]; cells_left; cells_left &= cells_left - 1)
+		{
+			hits[__builtin_ctzll(cells_left)]++;
+		}
+	}
+	const uint32_t *score = count ? hits : fallback;
+	int best = -1;
+	for (unsigned cell = 0; cell < NUM_CELLS; cell++)
+	{
+		if (!(fired & (1ULL << cell)) && (best < 0 || score[cell] > score[best]))
+		{
+			best = cell;
+		}
+	}
+	cells[node] = best;
+	if (level + 1 == depth)
+	{
+		return;
+	}
+
+	// Misses first, then hits
+	uint64_t shot = 1ULL << best;
+	size_t misses = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		if (!(first[i] & shot))
+		{
+			uint64_t t = first[misses];
+			first[misses++] = first[i];
+			first[i] = t;
+		}
+	}
+	build(2 * node + 1, level + 1, fired | shot, first, misses, fallback);
+	build(2 * node + 2, level + 1, fired | shot, first + misses, count - misses, fallback);
+}
+
+int main(int argc, char **argv)
+{
+	size_t samples = 200000;
+	unsigned long seed = 1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "d:n:s:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'd':
+				depth = strtoul(optarg, NULL, 0);
+				break;
+			case 'n':
+				samples = strtoul(optarg, NULL, 0);
+				break;
+			case 's':
+				seed = strtoul(optarg, NULL, 0);
+				break;
+			default:
+				optind = argc;
+				break;
+		}
+	}
+	if (optind != argc - 1 || depth < 1 || depth > MAX_DEPTH || samples == 0)
+	{
+		fprintf(stderr, "usage: %s [-d depth (1-%d)] [-n samples] [-s seed] output.h\n", argv[0],
+				MAX_DEPTH);
+		return 1;
+	}
+
+	fleets = malloc(samples * sizeof(fleets[0]));
+	if (!fleets)
+	{
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	rng_state = 0x9E3779B97F4A7C15ULL ^ seed;
+	uint32_t occupied[NUM_CELLS] = {0};
+	for (size_t i = 0; i < samples; i++)
+	{
+		fleets[i] = random_fleet();
+		for (unsigned cell = 0; cell < NUM_CELLS; cell++)
+		{
+			occupied[cell] += (fleets[i] >> cell) & 1;
+		}
+	}
+	build(0, 0, 0, fleets, samples, occupied);
+
+	// Replay the book against every sampled fleet
+	uint64_t total_hits = 0;
+	for (size_t i = 0; i < samples; i++)
+	{
+		unsigned node = 0;
+		for (unsigned level = 0; level < depth; level++)
+		{
+			unsigned hit = (fleets[i] >> cells[node]) & 1;
+			total_hits += hit;
+			node = 2 * node + 1 + hit;
+		}
+	}
+
+	// Pack the cells, 6 bits each, low bits first. There is a spare byte
+	// on the end so the decoder can always read two.
+	unsigned nodes = (1 << depth) - 1;
+	unsigned bytes = (nodes * 6 + 7) / 8 + 1;
+	uint8_t packed[((1 << MAX_DEPTH) - 1) * 6 / 8 + 2] = {0};
+	for (unsigned node = 0; node < nodes; node++)
+	{
+		unsigned bit = node * 6;
+		unsigned value = cells[node] << (bit % 8);
+		packed[bit / 8] |= value;
+		packed[bit / 8 + 1] |= value >> 8;
+	}
+
+	FILE *out = fopen(argv[optind], "wb");
+	if (!out)
+	{
+		fprintf(stderr, "can't write %s\n", argv[optind]);
+		return 1;
+	}
+	fprintf(out, "/*\r\n * opening_book_table.h\r\n *\r\n"
+			" * Generated by host/make_opening_book.c from SHIP_SIZES in game.h -\r\n"
+			" * don't edit. %zu sampled fleets, seed %lu. On average %.2f of the\r\n"
+			" * book's %u shots hit (%.2f for random shots).\r\n */\r\n\r\n",
+			samples, seed, (double)total_hits / samples, depth,
+			depth * (double)__builtin_popcountll(fleets[0]) / NUM_CELLS);
+	fprintf(out, "#define OPENING_BOOK_DEPTH %u\r\n\r\n", depth);
+	fprintf(out, "static const uint8_t opening_book_table[%u] PROGMEM = {", bytes);
+	for (unsigned i = 0; i < bytes; i++)
+	{
+		fprintf(out, "%s0x%02X%s", i % 12 ? " " : "\r\n\t", packed[i], i + 1 < bytes ? "," : "");
+	}
+	fprintf(out, "\r\n};\r\n");
+	if (fclose(out) != 0)
+	{
+		fprintf(stderr, "can't write %s\n", argv[optind]);
+		return 1;
+	}
+	printf("%u shots, %.2f hits on average\n", depth, (double)total_hits / samples);
+	free(fleets);
+	return 0;
+}
@@ -0,0 +1,310 @@
+/*
+ * make_text_tables.c
+ *
+ * Compresses the terminal text in text_assets.txt for flash. Writes
+ * text_ids.h, with a TextId for each text, and text_table.h, with the
+ * compressed texts, for text.c.
+ *
+ * The texts are byte pair encoded: the most common pair of adjacent
+ * symbols is replaced by a new symbol (128 upwards - the texts are
+ * ASCII), again and again while that saves space. A symbol is expanded
+ * by following its pair down to the characters, so the decoder needs no
+ * buffer, only a small stack for the right halves still to come; pairs
+ * that would need more than TEXT_STACK_SIZE entries aren't made. The
+ * output is the same every run, so make only changes the files when the
+ * texts or this generator do.
+ *
+ * Usage: make_text_tables text_assets.txt text_ids.h text_table.h
+ */
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_TEXTS 128
+#define MAX_LENGTH 255
+#define FIRST_PAIR 128
+#define MAX_PAIRS 128
+#define TEXT_STACK_SIZE 8
+
+typedef struct {
+	char name[48];
+	uint16_t symbols[MAX_LENGTH];
+	unsigned length;
+	unsigned decoded_length;
+} Text;
+
+static Text texts[MAX_TEXTS];
+static unsigned num_texts;
+static uint16_t pairs[MAX_PAIRS][2];
+static unsigned depth[FIRST_PAIR + MAX_PAIRS];
+static unsigned num_pairs;
+
+static int fail(const char *path, unsigned line, const char *message)
+{
+	fprintf(stderr, "%s:%u: %s\n", path, line, message);
+	return 1;
+}
+
+// One "NAME "text"" line. Returns non-zero on a bad line.
+static int parse_line(char *line, const char *path, unsigned number)
+{
+	char *p = line;
+	while (isspace((unsigned char)*p))
+	{
+		p++;
+	}
+	if (*p == '\0' || *p == '#')
+	{
+		return 0;
+	}
+	if (num_texts == MAX_TEXTS)
+	{
+		return fail(path, number, "too many texts");
+	}
+	Text *text = &texts[num_texts];
+	size_t name_length = 0;
+	while (isalnum((unsigned char)*p) || *p == '_')
+	{
+		if (name_length + 1 >= sizeof(text->name))
+		{
+			return fail(path, number, "name too long");
+		}
+		text->name[name_length++] = *p++;
+	}
+	while (*p == ' ' || *p == '\t')
+	{
+		p++;
+	}
+	if (name_length == 0 || *p++ != '"')
+	{
+		return fail(path, number, "expected a name and a quoted string");
+	}
+	while (*p != '"')
+	{
+		unsigned char c = *p++;
+		if (c == '\\')
+		{
+			c = *p++;
+			if (c != '\\' && c != '"')
+			{
+				return fail(path, number, "only \\\\ and \\\" escapes are allowed");
+			}
+		} else if (c == '\0' || c == '\r' || c == '\n')
+		{
+			return fail(path, number, "unterminated string");
+		}
+		if (c < ' ' || c >= FIRST_PAIR)
+		{
+			return fail(path, number, "texts must be printable ASCII");
+		}
+		if (text->length == MAX_LENGTH)
+		{
+			return fail(path, number, "text too long");
+		}
+		text->symbols[text->length++] = c;
+	}
+	text->decoded_length = text->length;
+	num_texts++;
+	return 0;
+}
+
+// Count each pair of adjacent symbols. A run like "aaa" counts its
+// pair once per replacement it would allow.
+static void count_pairs(uint32_t *counts)
+{
+	memset(counts, 0, sizeof(uint32_t) * (FIRST_PAIR + MAX_PAIRS) * (FIRST_PAIR + MAX_PAIRS));
+	for (unsigned t = 0; t < num_texts; t++)
+	{
+		const Text *text = &texts[t];
+		for (unsigned i = 0; i + 1 < text->length; i++)
+		{
+			uint16_t a = text->symbols[i];
+			uint16_t b = text->symbols[i + 1];
+			counts[a * (FIRST_PAIR + MAX_PAIRS) + b]++;
+			if (a == b && i + 2 < text->length && text->symbols[i + 2] == a)
+			{
+				// Skip the overlapping pair
+				i++;
+			}
+		}
+	}
+}
+
+static void replace_pair(uint16_t a, uint16_t b, uint16_t symbol)
+{
+	for (unsigned t = 0; t < num_texts; t++)
+	{
+		Text *text = &texts[t];
+		unsigned out = 0;
+		for (unsigned i = 0; i < text->length; i++)
+		{
+			if (i + 1 < text->length && text->symbols[i] == a && text->symbols[i + 1] == b)
+			{
+				text->symbols[out++] = symbol;
+				i++;
+			} else
+			{
+				text->symbols[out++] = text->symbols[i];
+			}
+		}
+		text->length = out;
+	}
+}
+
+static void compress(void)
+{
+	static uint32_t counts[(FIRST_PAIR + MAX_PAIRS) * (FIRST_PAIR + MAX_PAIRS)];
+	while (num_pairs < MAX_PAIRS)
+	{
+		count_pairs(counts);
+		unsigned best = 0;
+		for (unsigned i = 1; i < (FIRST_PAIR + num_pairs) * (FIRST_PAIR + MAX_PAIRS); i++)
+		{
+			unsigned a = i / (FIRST_PAIR + MAX_PAIRS);
+			unsigned b = i % (FIRST_PAIR + MAX_PAIRS);
+			unsigned d = 1 + (depth[a] > depth[b] ? depth[a] : depth[b]);
+			if (counts[i] > counts[best] && d <= TEXT_STACK_SIZE)
+			{
+				best = i;
+			}
+		}
+		// Each replacement saves a byte; the pair costs two
+		if (counts[best] < 3)
+		{
+			break;
+		}
+		uint16_t a = best / (FIRST_PAIR + MAX_PAIRS);
+		uint16_t b = best % (FIRST_PAIR + MAX_PAIRS);
+		uint16_t symbol = FIRST_PAIR + num_pairs;
+		pairs[num_pairs][0] = a;
+		pairs[num_pairs][1] = b;
+		depth[symbol] = 1 + (depth[a] > depth[b] ? depth[a] : depth[b]);
+		num_pairs++;
+		replace_pair(a, b, symbol);
+	}
+}
+
+static FILE *open_output(const char *path, const char *name, const char *about)
+{
+	FILE *out = fopen(path, "wb");
+	if (!out)
+	{
+		fprintf(stderr, "can't write %s\n", path);
+		exit(1);
+	}
+	fprintf(out, "/*\r\n * %s\r\n *\r\n * Generated by host/make_text_tables.c from text_assets.txt -\r\n"
+			" * don't edit. %s\r\n */\r\n\r\n", name, about);
+	return out;
+}
+
+static void close_output(FILE *out, const char *path)
+{
+	if (fclose(out) != 0)
+	{
+		fprintf(stderr, "can't write %s\n", path);
+		exit(1);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	if (argc != 4)
+	{
+		fprintf(stderr, "usage: %s text_assets.txt text_ids.h text_table.h\n", argv[0]);
+		return 1;
+	}
+
+	FILE *in = fopen(argv[1], "rb");
+	if (!in)
+	{
+		fprintf(stderr, "can't read %s\n", argv[1]);
+		return 1;
+	}
+	char line[1024];
+	unsigned number = 0;
+	while (fgets(line, sizeof(line), in))
+	{
+		if (parse_line(line, argv[1], ++number) != 0)
+		{
+			return 1;
+		}
+	}
+	fclose(in);
+
+	unsigned original = 0;
+	for (unsigned t = 0; t < num_texts; t++)
+	{
+		original += texts[t].length;
+	}
+	compress();
+	unsigned compressed = 0;
+	for (unsigned t = 0; t < num_texts; t++)
+	{
+		compressed += texts[t].length;
+	}
+
+	FILE *out = open_output(argv[2], "text_ids.h", "The texts, in the order given.");
+	fprintf(out, "#ifndef TEXT_IDS_H_\r\n#define TEXT_IDS_H_\r\n\r\n");
+	fprintf(out, "// Deepest nesting of pairs, which sets the decoder's stack size\r\n");
+	fprintf(out, "#define TEXT_STACK_SIZE %u\r\n\r\n", TEXT_STACK_SIZE);
+	fprintf(out, "typedef enum {\r\n");
+	for (unsigned t = 0; t < num_texts; t++)
+	{
+		fprintf(out, "\tTEXT_%s,\r\n", texts[t].name);
+	}
+	fprintf(out, "\tNUM_TEXTS\r\n} TextId;\r\n\r\n#endif /* TEXT_IDS_H_ */\r\n");
+	close_output(out, argv[2]);
+
+	char about[160];
+	snprintf(about, sizeof(about), "%u bytes of text in %u bytes,\r\n"
+			" * plus %u bytes of pairs.", original, compressed, num_pairs * 2);
+	out = open_output(argv[3], "text_table.h", about);
+	fprintf(out, "#define TEXT_FIRST_PAIR %u\r\n\r\n", FIRST_PAIR);
+	fprintf(out, "// The two symbols each symbol from TEXT_FIRST_PAIR up stands for\r\n");
+	fprintf(out, "static const uint8_t text_pairs[%u][2] PROGMEM = {", num_pairs ? num_pairs : 1);
+	for (unsigned i = 0; i < num_pairs; i++)
+	{
+		fprintf(out, "%s{%u, %u}%s", i % 8 ? " " : "\r\n\t", pairs[i][0], pairs[i][1],
+				i + 1 < num_pairs ? "," : "");
+	}
+	fprintf(out, "\r\n};\r\n\r\n");
+	fprintf(out, "// Where each text's symbols start; the last entry is the end\r\n");
+	fprintf(out, "static const uint16_t text_starts[NUM_TEXTS + 1] PROGMEM = {");
+	unsigned start = 0;
+	for (unsigned t = 0; t <= num_texts; t++)
+	{
+		fprintf(out, "%s%u%s", t % 12 ? " " : "\r\n\t", start, t < num_texts ? "," : "");
+		if (t < num_texts)
+		{
+			start += texts[t].length;
+		}
+	}
+	fprintf(out, "\r\n};\r\n\r\n");
+	fprintf(out, "// Length of each text once decoded\r\n");
+	fprintf(out, "static const uint8_t text_lengths[NUM_TEXTS] PROGMEM = {");
+	for (unsigned t = 0; t < num_texts; t++)
+	{
+		fprintf(out, "%s%u%s", t % 12 ? " " : "\r\n\t", texts[t].decoded_length,
+				t + 1 < num_texts ? "," : "");
+	}
+	fprintf(out, "\r\n};\r\n\r\n");
+	fprintf(out, "static const uint8_t text_symbols[%u] PROGMEM = {", compressed ? compressed : 1);
+	unsigned n = 0;
+	for (unsigned t = 0; t < num_texts; t++)
+	{
+		for (unsigned i = 0; i < texts[t].length; i++, n++)
+		{
+			fprintf(out, "%s%u%s", n % 16 ? " " : "\r\n\t", texts[t].symbols[i],
+					n + 1 < compressed ? "," : "");
+		}
+	}
+	fprintf(out, "\r\n};\r\n");
+	close_output(out, argv[3]);
+
+	printf("%u texts, %u bytes compressed to %u plus %u bytes of pairs\n", num_texts, original,
+			compressed, num_pairs * 2);
+	return 0;
+}
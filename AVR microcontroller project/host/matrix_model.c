@@ -0,0 +1,351 @@
+/*
+ * matrix_model.c
+ *
+ * LED matrix board model for host tools - see matrix_model.h. The
+ * commands are those in ledmatrix.c (see the LED matrix Reference):
+ *   0x00 UPDATE_ALL     128 colours, bottom row first, left to right
+ *   0x01 UPDATE_PIXEL   (y << 4 | x), colour
+ *   0x02 UPDATE_ROW     y, 16 colours left to right
+ *   0x03 UPDATE_COL     x, 8 colours bottom to top
+ *   0x04 SHIFT_DISPLAY  direction (0x01 right, 0x02 left, 0x04 down, 0x08 up)
+ *   0x0F CLEAR_SCREEN
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "matrix_model.h"
+
+static const char *command_names[MATRIX_NUM_CMDS] = {
+	"update all", "update pixel", "update row", "update column",
+	"shift display", "clear screen", "unknown"
+};
+
+static MatrixData pixels;
+static MatrixCommandStats stats[MATRIX_NUM_CMDS];
+
+// Command being received: the bytes still to come and how many of its
+// data bytes have arrived
+static MatrixCommand command;
+static uint8_t bytes_to_come;
+static uint8_t received;
+static uint8_t address;
+
+void matrix_model_reset(void)
+{
+	memset(pixels, COLOUR_BLACK, sizeof(pixels));
+	memset(stats, 0, sizeof(stats));
+	bytes_to_come = 0;
+}
+
+static void shift(int8_t dx, int8_t dy)
+{
+	MatrixData from;
+	memcpy(from, pixels, sizeof(from));
+	for (int8_t x = 0; x < MATRIX_NUM_COLUMNS; x++)
+	{
+		for (int8_t y = 0; y < MATRIX_NUM_ROWS; y++)
+		{
+			int8_t from_x = x - dx;
+			int8_t from_y = y - dy;
+			if (from_x >= 0 && from_x < MATRIX_NUM_COLUMNS && from_y >= 0 && from_y < MATRIX_NUM_ROWS)
+			{
+				pixels[x][y] = from[from_x][from_y];
+			} else
+			{
+				pixels[x][y] = COLOUR_BLACK;
+			}
+		}
+	}
+}
+
+static void start_command(uint8_t byte)
+{
+	received = 0;
+	switch (byte)
+	{
+		case 0x00:
+			command = MATRIX_CMD_UPDATE_ALL;
+			bytes_to_come = MATRIX_NUM_COLUMNS * MATRIX_NUM_ROWS;
+			break;
+		case 0x01:
+			command = MATRIX_CMD_UPDATE_PIXEL;
+			bytes_to_come = 2;
+			break;
+		case 0x02:
+			command = MATRIX_CMD_UPDATE_ROW;
+			bytes_to_come = 1 + MATRIX_NUM_COLUMNS;
+			break;
+		case 0x03:
+			command = MATRIX_CMD_UPDATE_COL;
+			bytes_to_come = 1 + MATRIX_NUM_ROWS;
+			break;
+		case 0x04:
+			command = MATRIX_CMD_SHIFT_DISPLAY;
+			bytes_to_come = 1;
+			break;
+		case 0x0F:
+			command = MATRIX_CMD_CLEAR_SCREEN;
+			bytes_to_come = 0;
+			memset(pixels, COLOUR_BLACK, sizeof(pixels));
+			break;
+		default:
+			command = MATRIX_CMD_UNKNOWN;
+			bytes_to_come = 0;
+			break;
+	}
+	stats[command].count++;
+}
+
+static void command_data(uint8_t byte)
+{
+	switch (command)
+	{
+		case MATRIX_CMD_UPDATE_ALL:
+			pixels[received % MATRIX_NUM_COLUMNS][received / MATRIX_NUM_COLUMNS] = byte;
+			break;
+		case MATRIX_CMD_UPDATE_PIXEL:
+			if (received == 0)
+			{
+				address = byte;
+			} else
+			{
+				pixels[address & 0x0F][(address >> 4) & 0x07] = byte;
+			}
+			break;
+		case MATRIX_CMD_UPDATE_ROW:
+			if (received == 0)
+			{
+				address = byte & 0x07;
+			} else
+			{
+				pixels[received - 1][address] = byte;
+			}
+			break;
+		case MATRIX_CMD_UPDATE_COL:
+			if (received == 0)
+			{
+				address = byte & 0x0F;
+			} else
+			{
+				pixels[address][received - 1] = byte;
+			}
+			break;
+		case MATRIX_CMD_SHIFT_DISPLAY:
+			shift((byte & 0x01 ? 1 : 0) - (byte & 0x02 ? 1 : 0),
+					(byte & 0x08 ? 1 : 0) - (byte & 0x04 ? 1 : 0));
+			break;
+		default:
+			break;
+	}
+	received++;
+}
+
+void matrix_model_byte(uint8_t byte)
+{
+	if (bytes_to_come == 0)
+	{
+		start_command(byte);
+	} else
+	{
+		bytes_to_come--;
+		command_data(byte);
+	}
+	stats[command].bytes++;
+}
+
+PixelColour matrix_model_pixel(uint8_t x, uint8_t y)
+{
+	if (x >= MATRIX_NUM_COLUMNS || y >= MATRIX_NUM_ROWS)
+	{
+		return COLOUR_BLACK;
+	}
+	return pixels[x][y];
+}
+
+uint8_t matrix_model_busy(void)
+{
+	return bytes_to_come != 0;
+}
+
+const MatrixCommandStats *matrix_model_stats(MatrixCommand command)
+{
+	return &stats[command];
+}
+
+const char *matrix_model_command_name(MatrixCommand command)
+{
+	return command_names[command];
+}
+
+double matrix_model_transfer_ms(uint32_t bytes, uint32_t spi_hz)
+{
+	return bytes * 8 * 1000.0 / spi_hz;
+}
+
+void matrix_model_print_stats(FILE *out, uint32_t spi_hz)
+{
+	uint32_t total = 0;
+	fprintf(out, "LED matrix commands at %lu Hz SPI clock:\n", (unsigned long)spi_hz);
+	for (MatrixCommand c = 0; c < MATRIX_NUM_CMDS; c++)
+	{
+		if (stats[c].count == 0)
+		{
+			continue;
+		}
+		fprintf(out, "  %-14s %10lu commands %10lu bytes %10.1f ms\n", command_names[c],
+				(unsigned long)stats[c].count, (unsigned long)stats[c].bytes,
+				matrix_model_transfer_ms(stats[c].bytes, spi_hz));
+		total += stats[c].bytes;
+	}
+	fprintf(out, "  %-14s %30lu bytes %10.1f ms\n", "total", (unsigned long)total,
+			matrix_model_transfer_ms(total, spi_hz));
+}
+
+// 4 bit red and green levels to 8 bit RGB
+static void pixel_rgb(PixelColour pixel, uint8_t rgb[3])
+{
+	rgb[0] = (pixel & 0x0F) * 17;
+	rgb[1] = (pixel >> 4) * 17;
+	rgb[2] = 0;
+}
+
+void matrix_model_print(FILE *out)
+{
+	for (int8_t y = MATRIX_NUM_ROWS - 1; y >= 0; y--)
+	{
+		for (uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++)
+		{
+			uint8_t rgb[3];
+			pixel_rgb(pixels[x][y], rgb);
+			if (x == GRID_NUM_COLUMNS)
+			{
+				fputs("\x1b[0m ", out);
+			}
+			fprintf(out, "\x1b[48;2;%u;%u;%um  ", rgb[0], rgb[1], rgb[2]);
+		}
+		fputs("\x1b[0m\n", out);
+	}
+}
+
+/////////////////////////////// PNG output ///////////////////////////////
+// Written without compression (stored deflate blocks) so no zlib is needed
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t length)
+{
+	crc = ~crc;
+	while (length--)
+	{
+		crc ^= *data++;
+		for (uint8_t bit = 0; bit < 8; bit++)
+		{
+			crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+		}
+	}
+	return ~crc;
+}
+
+static void put_be32(uint8_t *p, uint32_t value)
+{
+	p[0] = value >> 24;
+	p[1] = value >> 16;
+	p[2] = value >> 8;
+	p[3] = value;
+}
+
+static void write_chunk(FILE *file, const char *type, const uint8_t *data, uint32_t length)
+{
+	uint8_t word[4];
+	put_be32(word, length);
+	fwrite(word, 1, 4, file);
+	fwrite(type, 1, 4, file);
+	fwrite(data, 1, length, file);
+	uint32_t crc = crc32_update(0, (const uint8_t *)type, 4);
+	put_be32(word, crc32_update(crc, data, length));
+	fwrite(word, 1, 4, file);
+}
+
+int matrix_model_write_png(const char *path, uint8_t scale)
+{
+	static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+	uint32_t width = MATRIX_NUM_COLUMNS * scale;
+	uint32_t height = MATRIX_NUM_ROWS * scale;
+	uint32_t stride = 1 + width * 3;
+	uint32_t raw_length = stride * height;
+	uint32_t blocks = (raw_length + 0xFFFF - 1) / 0xFFFF;
+
+	if (scale == 0)
+	{
+		return -1;
+	}
+
+	// Filter type 0 (none) then RGB for each line, top row first
+	uint8_t *raw = malloc(raw_length);
+	uint8_t *idat = malloc(2 + blocks * 5 + raw_length + 4);
+	if (!raw || !idat)
+	{
+		free(raw);
+		free(idat);
+		return -1;
+	}
+	for (uint32_t line = 0; line < height; line++)
+	{
+		uint8_t *p = raw + line * stride;
+		uint8_t y = MATRIX_NUM_ROWS - 1 - line / scale;
+		*p++ = 0;
+		for (uint32_t column = 0; column < width; column++)
+		{
+			pixel_rgb(pixels[column / scale][y], p);
+			p += 3;
+		}
+	}
+
+	// zlib stream of stored blocks
+	uint8_t *p = idat;
+	*p++ = 0x78;
+	*p++ = 0x01;
+	for (uint32_t offset = 0; offset < raw_length; offset += 0xFFFF)
+	{
+		uint32_t length = raw_length - offset < 0xFFFF ? raw_length - offset : 0xFFFF;
+		*p++ = offset + length == raw_length;
+		*p++ = length;
+		*p++ = length >> 8;
+		*p++ = ~length;
+		*p++ = ~length >> 8;
+		memcpy(p, raw + offset, length);
+		p += length;
+	}
+	uint32_t a = 1, b = 0;
+	for (uint32_t i = 0; i < raw_length; i++)
+	{
+		a = (a + raw[i]) % 65521;
+		b = (b + a) % 65521;
+	}
+	put_be32(p, b << 16 | a);
+	p += 4;
+
+	uint8_t header[13];
+	put_be32(header, width);
+	put_be32(header + 4, height);
+	header[8] = 8;	// bits per sample
+	header[9] = 2;	// RGB
+	header[10] = header[11] = header[12] = 0;
+
+	int result = -1;
+	FILE *file = fopen(path, "wb");
+	if (file)
+	{
+		fwrite(signature, 1, sizeof(signature), file);
+		write_chunk(file, "IHDR", header, sizeof(header));
+		write_chunk(file, "IDAT", idat, p - idat);
+		write_chunk(file, "IEND", NULL, 0);
+		result = ferror(file) ? -1 : 0;
+		if (fclose(file) != 0)
+		{
+			result = -1;
+		}
+	}
+	free(raw);
+	free(idat);
+	return result;
+}
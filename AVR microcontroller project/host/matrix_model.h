@@ -0,0 +1,67 @@
+/*
+ * matrix_model.h
+ *
+ * Model of the LED matrix board for host tools. It decodes the SPI
+ * command stream ledmatrix.c sends (install matrix_model_byte() with
+ * hal_set_spi_sink()) into the 16x8 pixels the player would see, keeps
+ * byte counts for each command and can draw the matrix in a terminal or
+ * write it to a PNG file.
+ */
+
+#ifndef MATRIX_MODEL_H_
+#define MATRIX_MODEL_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "ledmatrix.h"
+
+// Commands the matrix understands, in the order used for the statistics
+typedef enum {
+	MATRIX_CMD_UPDATE_ALL,
+	MATRIX_CMD_UPDATE_PIXEL,
+	MATRIX_CMD_UPDATE_ROW,
+	MATRIX_CMD_UPDATE_COL,
+	MATRIX_CMD_SHIFT_DISPLAY,
+	MATRIX_CMD_CLEAR_SCREEN,
+	MATRIX_CMD_UNKNOWN,
+	MATRIX_NUM_CMDS
+} MatrixCommand;
+
+typedef struct {
+	uint32_t count;
+	uint32_t bytes;
+} MatrixCommandStats;
+
+// Blank the matrix, forget any partly received command and zero the
+// statistics.
+void matrix_model_reset(void);
+
+// Feed one byte of the SPI stream
+void matrix_model_byte(uint8_t byte);
+
+// Current state of the matrix. x and y are as in ledmatrix.h.
+PixelColour matrix_model_pixel(uint8_t x, uint8_t y);
+
+// Non-zero while a command has been started but not all of its bytes
+// have arrived
+uint8_t matrix_model_busy(void);
+
+// Statistics for each command, and its name for reports
+const MatrixCommandStats *matrix_model_stats(MatrixCommand command);
+const char *matrix_model_command_name(MatrixCommand command);
+
+// Time the given number of bytes take on the SPI bus at spi_hz
+double matrix_model_transfer_ms(uint32_t bytes, uint32_t spi_hz);
+
+// Print the per-command statistics, with transfer times at spi_hz
+void matrix_model_print_stats(FILE *out, uint32_t spi_hz);
+
+// Draw the matrix with ANSI colours, top row (y = 7) first
+void matrix_model_print(FILE *out);
+
+// Write the matrix to a PNG file, each pixel drawn as a scale x scale
+// square. Returns 0 on success.
+int matrix_model_write_png(const char *path, uint8_t scale);
+
+#endif /* MATRIX_MODEL_H_ */
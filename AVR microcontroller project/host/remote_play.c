@@ -0,0 +1,498 @@
+/*
+ * remote_play.c
+ *
+ * Plays games against the firmware through its binary serial protocol
+ * (remote_protocol.h), for automated testing and load runs. The device
+ * is the board's serial port, uart_pty's pty or simavr's UART pty. A
+ * REMOTE_CMD_HELLO switches the firmware into binary mode (and
+ * REMOTE_CMD_TEXT back to the terminal at the end). The human side
+ * fires at every cell in a random order, moving the cursor with
+ * REMOTE_CMD_MOVE and waiting for the computer's reply to land before
+ * firing again, and a new game is started when one ends. The computer's
+ * firing animation is turned off (REMOTE_CMD_ANIMATION) unless -a is
+ * given, so turns aren't held up by it. Every command is acknowledged,
+ * and is sent again if it is lost or damaged.
+ *
+ * Reports the turns played per minute of real time, the time the
+ * firmware took over each turn, the commands sent again and the
+ * firmware's own serial statistics.
+ *
+ * Usage: remote_play [-a] [-g games] [-m basic|search|prob] [-s seed] [-v] device
+ *   -a  keep the computer's firing animation
+ *   -v  print every packet received
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "events.h"
+#include "frame.h"
+#include "game.h"
+#include "remote_protocol.h"
+
+#define ACK_TIMEOUT_MS 500
+#define TURN_TIMEOUT_MS 5000
+#define MAX_RESENDS 5
+
+static int fd = -1;
+static int verbose;
+static FrameDecoder decoder;
+static uint8_t next_seq;
+
+// What has arrived
+static int hello;
+static int bad_frame_reply;
+static int acked;
+static uint8_t ack_status;
+static int new_game;
+static uint8_t new_game_mode;
+static int game_over;
+static int winner;
+static int computer_shot_landed;
+static int human_shot_cell = -1;
+static int status_received;
+static uint8_t status[12];
+
+// Statistics
+static unsigned long commands_sent, resends, busy_replies, bad_frames_in;
+static unsigned long turns, turn_packets, human_wins, wrong_cells;
+static uint64_t turn_us_total;
+static uint32_t turn_us_worst;
+
+static const char *event_names[NUM_EVENT_TYPES] = {
+	"shot fired", "hit", "miss", "sunk", "game over", "mode change", "new game"
+};
+
+static uint64_t now_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void die(const char *message)
+{
+	fprintf(stderr, "remote_play: %s\n", message);
+	exit(1);
+}
+
+static uint8_t out[2 * FRAME_MAX_PAYLOAD + 8];
+static size_t out_length;
+
+static void put_out(uint8_t byte)
+{
+	out[out_length++] = byte;
+}
+
+static void write_all(const uint8_t *data, size_t length)
+{
+	while (length)
+	{
+		ssize_t n = write(fd, data, length);
+		if (n < 0 && errno != EINTR && errno != EAGAIN)
+		{
+			die("write failed");
+		}
+		if (n > 0)
+		{
+			data += n;
+			length -= n;
+		}
+	}
+}
+
+static void handle_packet(const uint8_t *p, int length)
+{
+	if (verbose)
+	{
+		printf("<");
+		for (int i = 0; i < length; i++)
+		{
+			printf(" %02x", p[i]);
+		}
+		if (p[0] == REMOTE_EVENT && length == 5 && p[1] < NUM_EVENT_TYPES)
+		{
+			printf("  (%s)", event_names[p[1]]);
+		}
+		printf("\n");
+	}
+	switch (p[0])
+	{
+		case REMOTE_HELLO:
+			hello = 1;
+			if (length != 2 || p[1] != REMOTE_PROTOCOL_VERSION)
+			{
+				die("firmware speaks a different protocol version");
+			}
+			break;
+		case REMOTE_ACK:
+			if (length == 3 && p[1] == (uint8_t)(next_seq - 1))
+			{
+				acked = 1;
+				ack_status = p[2];
+			}
+			break;
+		case REMOTE_BAD_FRAME:
+			bad_frame_reply = 1;
+			break;
+		case REMOTE_EVENT:
+			if (length != 5)
+			{
+				break;
+			}
+			if (p[1] == EVENT_NEW_GAME)
+			{
+				new_game = 1;
+				new_game_mode = p[4];
+			} else if (p[1] == EVENT_GAME_OVER)
+			{
+				game_over = 1;
+				winner = p[2];
+			} else if (p[1] == EVENT_SHOT_FIRED && p[2] == PLAYER_HUMAN)
+			{
+				human_shot_cell = p[3];
+			} else if ((p[1] == EVENT_HIT || p[1] == EVENT_MISS) && p[2] == PLAYER_COMPUTER)
+			{
+				computer_shot_landed = 1;
+			}
+			break;
+		case REMOTE_TURN:
+			if (length == 5)
+			{
+				uint32_t us = p[1] | p[2] << 8 | p[3] << 16 | (uint32_t)p[4] << 24;
+				turn_us_total += us;
+				turn_us_worst = us > turn_us_worst ? us : turn_us_worst;
+				turn_packets++;
+			}
+			break;
+		case REMOTE_STATUS:
+			if (length == 12)
+			{
+				memcpy(status, p, sizeof(status));
+				status_received = 1;
+			}
+			break;
+	}
+}
+
+// Read and handle whatever arrives until *flag is set or the time runs
+// out. Returns the flag.
+static int wait_for(const int *flag, int timeout_ms)
+{
+	uint64_t end = now_ms() + timeout_ms;
+	while (!*flag)
+	{
+		int64_t left = (int64_t)(end - now_ms());
+		if (left <= 0)
+		{
+			break;
+		}
+		struct pollfd p = {fd, POLLIN, 0};
+		if (poll(&p, 1, left) <= 0)
+		{
+			continue;
+		}
+		uint8_t buffer[256];
+		ssize_t n = read(fd, buffer, sizeof(buffer));
+		if (n <= 0)
+		{
+			if (n < 0 && errno != EAGAIN && errno != EINTR)
+			{
+				die("read failed");
+			}
+			continue;
+		}
+		for (ssize_t i = 0; i < n; i++)
+		{
+			int length = frame_decode_byte(&decoder, buffer[i]);
+			if (length == FRAME_BAD)
+			{
+				bad_frames_in++;
+			} else if (length > 0)
+			{
+				handle_packet(decoder.data, length);
+			}
+		}
+	}
+	return *flag;
+}
+
+// Send a command and wait for it to be acknowledged, sending it again if
+// it is lost, damaged or the firmware is busy. Returns the RemoteStatus.
+static uint8_t command(uint8_t type, const uint8_t *args, uint8_t arg_length)
+{
+	uint8_t packet[FRAME_MAX_PAYLOAD + 2];
+	packet[0] = type;
+	packet[1] = next_seq++;
+	memcpy(&packet[2], args, arg_length);
+	out_length = 0;
+	frame_encode(packet, frame_seal(packet, arg_length + 2), put_out);
+	commands_sent++;
+
+	for (int tries = 0; tries <= MAX_RESENDS; )
+	{
+		acked = 0;
+		bad_frame_reply = 0;
+		write_all(out, out_length);
+		int got = 0;
+		uint64_t end = now_ms() + ACK_TIMEOUT_MS;
+		while (!got && now_ms() < end)
+		{
+			wait_for(&acked, 10);
+			got = acked || bad_frame_reply;
+		}
+		if (acked && ack_status == REMOTE_BUSY)
+		{
+			// Not lost, so it doesn't count against the resends
+			busy_replies++;
+			usleep(1000);
+			continue;
+		}
+		if (acked)
+		{
+			return ack_status;
+		}
+		resends++;
+		tries++;
+	}
+	die("no answer from the firmware");
+	return REMOTE_UNKNOWN_COMMAND;
+}
+
+// A zero, then REMOTE_CMD_HELLO in a frame of its own
+static void enter_binary_mode(void)
+{
+	uint8_t packet[3 + 2] = {REMOTE_CMD_HELLO, next_seq++, REMOTE_PROTOCOL_VERSION};
+	out_length = 0;
+	put_out(0);
+	frame_encode(packet, frame_seal(packet, 3), put_out);
+	for (int tries = 0; tries <= MAX_RESENDS; tries++)
+	{
+		acked = 0;
+		write_all(out, out_length);
+		wait_for(&hello, ACK_TIMEOUT_MS);
+		// Perhaps it was in binary mode already, from an earlier run, and
+		// the HELLO was acknowledged as a command
+		if (hello || (acked && ack_status == REMOTE_OK))
+		{
+			return;
+		}
+	}
+	die("firmware didn't start binary mode");
+}
+
+// Get from whichever screen the firmware is on to a new game
+static void start_game(uint8_t mode, int at_game_over)
+{
+	for (int tries = 0; tries < 3; tries++)
+	{
+		new_game = 0;
+		if (at_game_over)
+		{
+			command(REMOTE_CMD_START, NULL, 0);
+		}
+		command(REMOTE_CMD_SET_MODE, &mode, 1);
+		command(REMOTE_CMD_START, NULL, 0);
+		if (wait_for(&new_game, 1000))
+		{
+			if (new_game_mode != mode)
+			{
+				die("game started in the wrong mode");
+			}
+			return;
+		}
+		// It must have been on the game over screen, which the first START
+		// left, and is on the start screen now
+		at_game_over = 0;
+	}
+	die("can't start a game");
+}
+
+// Shortest move from a to b on the 8 wide grid, which wraps
+static int8_t step_to(int a, int b)
+{
+	int d = ((b - a) % 8 + 8) % 8;
+	return d > 4 ? d - 8 : d;
+}
+
+static void play(uint8_t mode, int at_game_over)
+{
+	start_game(mode, at_game_over);
+	game_over = 0;
+
+	uint8_t cells[64];
+	for (int i = 0; i < 64; i++)
+	{
+		cells[i] = i;
+	}
+	for (int i = 63; i > 0; i--)
+	{
+		int j = rand() % (i + 1);
+		uint8_t t = cells[i];
+		cells[i] = cells[j];
+		cells[j] = t;
+	}
+
+	// The cursor starts in the same place every game (initialise_game())
+	int x = 3, y = 3;
+	for (int i = 0; i < 64 && !game_over; i++)
+	{
+		int tx = cells[i] % 8, ty = cells[i] / 8;
+		int8_t move[2] = {step_to(x, tx), step_to(y, ty)};
+		if (move[0] || move[1])
+		{
+			command(REMOTE_CMD_MOVE, (uint8_t *)move, 2);
+			x = tx;
+			y = ty;
+		}
+		computer_shot_landed = 0;
+		human_shot_cell = -1;
+		command(REMOTE_CMD_FIRE, NULL, 0);
+		uint64_t end = now_ms() + TURN_TIMEOUT_MS;
+		while (!computer_shot_landed && !game_over && now_ms() < end)
+		{
+			wait_for(&computer_shot_landed, 10);
+		}
+		if (!computer_shot_landed && !game_over)
+		{
+			fprintf(stderr, "remote_play: no reply to the shot at %d,%d\n", tx, ty);
+			exit(1);
+		}
+		if (game_over && human_shot_cell < 0)
+		{
+			// The game ended on the last turn, before its game over event
+			// arrived. The game over screen ignores moves and shots.
+			break;
+		}
+		if (human_shot_cell != cells[i])
+		{
+			if (verbose)
+			{
+				printf("Aimed at %d,%d but the shot was at cell %d\n", tx, ty, human_shot_cell);
+			}
+			wrong_cells++;
+		}
+		turns++;
+	}
+	if (!game_over)
+	{
+		// Every cell has been fired at, so this can't happen unless
+		// events were lost
+		wait_for(&game_over, TURN_TIMEOUT_MS);
+	}
+	if (game_over && winner == PLAYER_HUMAN)
+	{
+		human_wins++;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long games = 10;
+	const char *mode_name = "basic";
+	unsigned seed = 1;
+	uint8_t animation = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "ag:m:s:v")) != -1)
+	{
+		switch (opt)
+		{
+			case 'a':
+				animation = 1;
+				break;
+			case 'g':
+				games = strtoul(optarg, NULL, 0);
+				break;
+			case 'm':
+				mode_name = optarg;
+				break;
+			case 's':
+				seed = strtoul(optarg, NULL, 0);
+				break;
+			case 'v':
+				verbose = 1;
+				break;
+			default:
+				optind = argc;
+				break;
+		}
+	}
+	if (optind != argc - 1)
+	{
+		fprintf(stderr, "usage: %s [-a] [-g games] [-m basic|search|prob] [-s seed] [-v] device\n",
+				argv[0]);
+		return 1;
+	}
+	uint8_t mode;
+	if (strcmp(mode_name, "basic") == 0)
+	{
+		mode = MODE_BASIC;
+	} else if (strcmp(mode_name, "search") == 0)
+	{
+		mode = MODE_SEARCH_AND_DESTROY;
+	} else if (strcmp(mode_name, "prob") == 0)
+	{
+		mode = MODE_PROBABILITY_HUNT;
+	} else
+	{
+		fprintf(stderr, "unknown mode '%s'\n", mode_name);
+		return 1;
+	}
+	srand(seed);
+
+	fd = open(argv[optind], O_RDWR | O_NOCTTY);
+	struct termios tio;
+	if (fd < 0 || tcgetattr(fd, &tio) != 0)
+	{
+		perror(argv[optind]);
+		return 1;
+	}
+	// The firmware's rate (init_serial_stdio() in project.c); a pty
+	// ignores it
+	cfmakeraw(&tio);
+	cfsetspeed(&tio, B19200);
+	tcsetattr(fd, TCSANOW, &tio);
+	tcflush(fd, TCIFLUSH);
+	frame_decoder_init(&decoder);
+
+	uint64_t start = now_ms();
+	enter_binary_mode();
+	command(REMOTE_CMD_ANIMATION, &animation, 1);
+	for (unsigned long game = 0; game < games; game++)
+	{
+		play(mode, game > 0);
+	}
+	double seconds = (now_ms() - start) / 1e3;
+	command(REMOTE_CMD_STATUS, NULL, 0);
+	wait_for(&status_received, ACK_TIMEOUT_MS);
+	command(REMOTE_CMD_TEXT, NULL, 0);
+
+	printf("%lu games (%lu won by the human), %lu turns in %.1f s: %.0f turns per minute\n",
+			games, human_wins, turns, seconds, seconds > 0 ? turns * 60 / seconds : 0);
+	if (turn_packets)
+	{
+		printf("Turn time (firmware clock) %.1f ms average, %.1f ms worst\n",
+				turn_us_total / 1e3 / turn_packets, turn_us_worst / 1e3);
+	}
+	printf("%lu commands, %lu sent again, %lu busy replies, %lu bad frames received, "
+			"%lu shots at the wrong cell\n", commands_sent, resends, busy_replies,
+			bad_frames_in, wrong_cells);
+	if (status_received)
+	{
+		printf("Firmware: output space %u, %u output stalls, %u output bytes dropped, "
+				"%u input overruns, %u bad frames\n", status[1],
+				status[4] | status[5] << 8, status[6] | status[7] << 8,
+				status[8] | status[9] << 8, status[10] | status[11] << 8);
+	}
+	return 0;
+}
@@ -0,0 +1,356 @@
+/*
+ * simavr_bench.c
+ *
+ * Headless cycle-accounting benchmark. Runs the real firmware ELF (built
+ * with BENCH_MARKERS, see bench_marker.h) on simavr's ATmega324A model,
+ * types a scripted sequence of keys into USART0 and reports:
+ *  - CPU cycles per play_game() iteration, not counting time asleep
+ *  - CPU cycles per computer_turn() (choosing the target) and for the
+ *    shot landing when the firing animation ends
+ *  - per computer turn, from computer_turn() to the end of the first
+ *    frame sent after its shot lands: the CPU cycles spent awake, and the
+ *    SPI bytes sent to the LED matrix and UART bytes sent
+ *  - CPU cycles per terminal escape sequence with and without printf_P()
+ *    (terminal_bench() in terminalio.c, run once at start-up)
+ *
+ * Keys are only typed once the firmware has been round an input polling
+ * loop since the last key, so none are lost however long a turn blocks.
+ *
+ * Usage: simavr_bench [-g games] [-k keys] [-i interval_ms] [-c max_cycles] firmware.elf
+ *   -g  stop after this many games have finished (default 3)
+ *   -k  keys to type, repeated as needed (default: start a game, then
+ *       fire at every cell on the board row by row)
+ *   -i  minimum modelled time between keys (default 5ms)
+ *   -c  give up after this many cycles (default 60 seconds' worth)
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_io.h"
+#include "avr_uart.h"
+#include "avr_spi.h"
+#include "avr_adc.h"
+
+#include "../bench_marker.h"
+
+#define F_CPU 8000000UL
+#define GPIOR0_ADDRESS 0x3E
+
+typedef struct {
+	uint64_t count;
+	uint64_t total;
+	uint64_t worst;
+} CycleStats;
+
+typedef struct {
+	avr_t *avr;
+	avr_irq_t *uart_in;
+
+	const char *keys;
+	size_t key_length;
+	size_t next_key;
+	uint64_t key_interval;
+	uint64_t last_key_cycle;
+	uint32_t polls_since_key;
+
+	uint64_t loop_start;
+	uint64_t loop_idle_start;
+	uint64_t shot_start;
+
+	// The computer turn being measured: started, shot landed
+	int turn_open;
+	int turn_landed;
+	uint64_t turn_start;
+	uint64_t turn_idle_start;
+	uint32_t turn_spi_start;
+	uint32_t turn_uart_start;
+
+	uint64_t sleep_start;
+	uint64_t idle_cycles;
+	uint32_t games_started;
+	uint32_t games_over;
+
+	uint32_t spi_bytes;
+	uint32_t uart_bytes;
+
+	uint64_t terminal_printf_start;
+	uint64_t terminal_direct_start;
+	uint64_t terminal_printf_cycles;
+	uint64_t terminal_direct_cycles;
+
+	CycleStats loop;
+	CycleStats choose;
+	CycleStats shot;
+	CycleStats turn;
+	CycleStats turn_spi;
+	CycleStats turn_uart;
+} Bench;
+
+static void add_sample(CycleStats *stats, uint64_t value)
+{
+	stats->count++;
+	stats->total += value;
+	if (value > stats->worst)
+	{
+		stats->worst = value;
+	}
+}
+
+static void print_stats(const char *name, const char *unit, const CycleStats *stats)
+{
+	printf("%-28s %8llu samples %12.1f %s avg %10llu %s worst\n", name,
+			(unsigned long long)stats->count,
+			stats->count ? (double)stats->total / stats->count : 0.0, unit,
+			(unsigned long long)stats->worst, unit);
+}
+
+static void marker_write(avr_t *avr, avr_io_addr_t addr, uint8_t value, void *param)
+{
+	Bench *bench = param;
+	uint64_t now = avr->cycle;
+
+	avr->data[addr] = value;
+	switch (value)
+	{
+		case BENCH_GAME_LOOP:
+			if (bench->loop_start)
+			{
+				add_sample(&bench->loop, now - bench->loop_start
+						- (bench->idle_cycles - bench->loop_idle_start));
+			}
+			bench->loop_start = now;
+			bench->loop_idle_start = bench->idle_cycles;
+			/* FALLTHROUGH */
+		case BENCH_INPUT_POLL:
+			bench->polls_since_key++;
+			break;
+		case BENCH_SLEEP:
+			bench->sleep_start = now;
+			break;
+		case BENCH_WAKE:
+			// Including the interrupt that woke it
+			bench->idle_cycles += now - bench->sleep_start;
+			break;
+		case BENCH_TURN_START:
+			bench->turn_open = 1;
+			bench->turn_landed = 0;
+			bench->turn_start = now;
+			bench->turn_idle_start = bench->idle_cycles;
+			bench->turn_spi_start = bench->spi_bytes;
+			bench->turn_uart_start = bench->uart_bytes;
+			break;
+		case BENCH_TURN_END:
+			add_sample(&bench->choose, now - bench->turn_start);
+			break;
+		case BENCH_SHOT_START:
+			bench->shot_start = now;
+			break;
+		case BENCH_SHOT_END:
+			add_sample(&bench->shot, now - bench->shot_start);
+			bench->turn_landed = bench->turn_open;
+			break;
+		case BENCH_COMMIT_END:
+			if (bench->turn_landed)
+			{
+				add_sample(&bench->turn, now - bench->turn_start
+						- (bench->idle_cycles - bench->turn_idle_start));
+				add_sample(&bench->turn_spi, bench->spi_bytes - bench->turn_spi_start);
+				add_sample(&bench->turn_uart, bench->uart_bytes - bench->turn_uart_start);
+				bench->turn_open = 0;
+				bench->turn_landed = 0;
+			}
+			break;
+		case BENCH_GAME_START:
+			bench->games_started++;
+			// The gap between games isn't a play_game() iteration
+			bench->loop_start = 0;
+			break;
+		case BENCH_GAME_OVER:
+			bench->games_over++;
+			bench->loop_start = 0;
+			bench->turn_open = 0;
+			bench->turn_landed = 0;
+			break;
+		case BENCH_TERMINAL_PRINTF:
+			bench->terminal_printf_start = now;
+			break;
+		case BENCH_TERMINAL_DIRECT:
+			bench->terminal_printf_cycles = now - bench->terminal_printf_start;
+			bench->terminal_direct_start = now;
+			break;
+		case BENCH_TERMINAL_END:
+			bench->terminal_direct_cycles = now - bench->terminal_direct_start;
+			break;
+	}
+}
+
+static void spi_output(avr_irq_t *irq, uint32_t value, void *param)
+{
+	Bench *bench = param;
+	bench->spi_bytes++;
+}
+
+static void uart_output(avr_irq_t *irq, uint32_t value, void *param)
+{
+	Bench *bench = param;
+	bench->uart_bytes++;
+}
+
+// Type the next key once the firmware has had a chance to read the last
+static void feed_keys(Bench *bench)
+{
+	if (bench->polls_since_key < 2
+			|| bench->avr->cycle - bench->last_key_cycle < bench->key_interval)
+	{
+		return;
+	}
+	avr_raise_irq(bench->uart_in, (uint8_t)bench->keys[bench->next_key]);
+	bench->next_key = (bench->next_key + 1) % bench->key_length;
+	bench->last_key_cycle = bench->avr->cycle;
+	bench->polls_since_key = 0;
+}
+
+// Start a game then fire at every cell, row by row, moving right along
+// each row and up to the next
+static char *default_keys(void)
+{
+	static char keys[1 + 8 * (8 * 2 + 1) + 1];
+	char *k = keys;
+	*k++ = 's';
+	for (int row = 0; row < 8; row++)
+	{
+		for (int col = 0; col < 8; col++)
+		{
+			*k++ = 'f';
+			*k++ = 'd';
+		}
+		*k++ = 'w';
+	}
+	*k = '\0';
+	return keys;
+}
+
+int main(int argc, char **argv)
+{
+	Bench bench = {0};
+	uint32_t games = 3;
+	uint64_t max_cycles = 60ULL * F_CPU;
+	uint32_t interval_ms = 5;
+	const char *keys = NULL;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "g:k:i:c:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'g':
+				games = strtoul(optarg, NULL, 0);
+				break;
+			case 'k':
+				keys = optarg;
+				break;
+			case 'i':
+				interval_ms = strtoul(optarg, NULL, 0);
+				break;
+			case 'c':
+				max_cycles = strtoull(optarg, NULL, 0);
+				break;
+			default:
+				goto usage;
+		}
+	}
+	if (optind != argc - 1)
+	{
+usage:
+		fprintf(stderr, "usage: %s [-g games] [-k keys] [-i interval_ms] [-c max_cycles] firmware.elf\n",
+				argv[0]);
+		return 1;
+	}
+	if (!keys || !*keys)
+	{
+		// After a game 's' leaves the game over screen and 's' again
+		// leaves the start screen; the other keys are ignored there
+		keys = default_keys();
+	}
+
+	elf_firmware_t firmware = {{0}};
+	if (elf_read_firmware(argv[optind], &firmware) != 0)
+	{
+		fprintf(stderr, "%s: can't load %s\n", argv[0], argv[optind]);
+		return 1;
+	}
+
+	avr_t *avr = avr_make_mcu_by_name("atmega324a");
+	if (!avr)
+	{
+		fprintf(stderr, "%s: simavr has no atmega324a core\n", argv[0]);
+		return 1;
+	}
+	avr_init(avr);
+	avr->frequency = F_CPU;
+	avr->vcc = avr->avcc = avr->aref = 5000;
+	avr_load_firmware(avr, &firmware);
+
+	bench.avr = avr;
+	bench.keys = keys;
+	bench.key_length = strlen(keys);
+	bench.key_interval = (uint64_t)interval_ms * (F_CPU / 1000);
+
+	// Keep the terminal output to ourselves
+	uint32_t flags = 0;
+	avr_ioctl(avr, AVR_IOCTL_UART_GET_FLAGS('0'), &flags);
+	flags &= ~AVR_UART_FLAG_STDIO;
+	avr_ioctl(avr, AVR_IOCTL_UART_SET_FLAGS('0'), &flags);
+
+	bench.uart_in = avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_INPUT);
+	avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_OUTPUT),
+			uart_output, &bench);
+	avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_SPI_GETIRQ(0), SPI_IRQ_OUTPUT),
+			spi_output, &bench);
+	avr_register_io_write(avr, GPIOR0_ADDRESS, marker_write, &bench);
+
+	// Joystick centred (channels 0 and 1 at half of AVcc)
+	avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_ADC_GETIRQ, ADC_IRQ_ADC0), 2500);
+	avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_ADC_GETIRQ, ADC_IRQ_ADC1), 2500);
+
+	int state = cpu_Running;
+	while (bench.games_over < games && avr->cycle < max_cycles
+			&& state != cpu_Done && state != cpu_Crashed)
+	{
+		state = avr_run(avr);
+		feed_keys(&bench);
+	}
+
+	printf("%u games finished (%u started) in %llu cycles (%.2f s at %lu MHz)%s\n",
+			bench.games_over, bench.games_started, (unsigned long long)avr->cycle,
+			(double)avr->cycle / F_CPU, F_CPU / 1000000,
+			state == cpu_Crashed ? " - firmware crashed" :
+			bench.games_over < games ? " - cycle limit reached" : "");
+	print_stats("play_game iteration (awake)", "cycles", &bench.loop);
+	print_stats("computer_turn (choosing)", "cycles", &bench.choose);
+	print_stats("computer shot landing", "cycles", &bench.shot);
+	print_stats("computer turn (awake)", "cycles", &bench.turn);
+	print_stats("SPI bytes per turn", "bytes", &bench.turn_spi);
+	print_stats("UART bytes per turn", "bytes", &bench.turn_uart);
+	printf("%-28s %8u bytes total\n", "SPI to LED matrix", bench.spi_bytes);
+	printf("%-28s %8u bytes total\n", "UART", bench.uart_bytes);
+	printf("%-28s %12.1f%% of the cycles\n", "asleep",
+			avr->cycle ? 100.0 * bench.idle_cycles / avr->cycle : 0.0);
+	if (bench.terminal_direct_cycles)
+	{
+		// Each iteration is one cursor move and one attribute change
+		printf("%-28s %12.1f cycles per escape with printf_P, %.1f without\n",
+				"terminal escapes",
+				bench.terminal_printf_cycles / (2.0 * BENCH_TERMINAL_CALLS),
+				bench.terminal_direct_cycles / (2.0 * BENCH_TERMINAL_CALLS));
+	}
+
+	avr_terminate(avr);
+	return bench.games_over < games;
+}
@@ -0,0 +1,169 @@
+/*
+ * uart_pty.c
+ *
+ * Runs the firmware's own main() on the host build (see hal.h) with
+ * USART0 connected to a pseudo-terminal, as simavr's UART pty does, so a
+ * terminal program or remote_play can talk to it. The pty's name is
+ * printed on start up.
+ *
+ * Modelled time runs as fast as the host can manage while there is
+ * serial traffic. Once nothing has been sent either way for a couple of
+ * modelled seconds the firmware is idling on a screen, and the model
+ * waits for input in real time instead of spinning.
+ *
+ * Usage: uart_pty [-l link] [-a]
+ *   -l  also make link a symbolic link to the pty (e.g. /tmp/battleship)
+ *   -a  leave sound on
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "hal.h"
+
+// Firmware globals and functions that aren't in a header
+extern uint32_t is_muted;
+int firmware_main(void);
+
+// Modelled time with no serial traffic before the model waits in real time
+#define QUIET_MS 2000
+// Keep this much input queued in the model at most, so the firmware's
+// own input buffer sees bytes arrive at the baud rate
+#define RX_QUEUE_LIMIT 64
+
+static int master = -1;
+static uint8_t tx_buffer[4096];
+static size_t tx_length;
+static uint32_t last_traffic_ms;
+
+static void flush_tx(void)
+{
+	size_t sent = 0;
+	while (sent < tx_length)
+	{
+		ssize_t n = write(master, tx_buffer + sent, tx_length - sent);
+		if (n > 0)
+		{
+			sent += n;
+		} else if (n < 0 && errno != EAGAIN && errno != EINTR)
+		{
+			perror("uart_pty: write");
+			exit(1);
+		} else
+		{
+			struct pollfd p = {master, POLLOUT, 0};
+			poll(&p, 1, 10);
+		}
+	}
+	tx_length = 0;
+}
+
+static void tx_sink(uint8_t byte)
+{
+	if (tx_length == sizeof(tx_buffer))
+	{
+		flush_tx();
+	}
+	tx_buffer[tx_length++] = byte;
+	last_traffic_ms = hal_time_ms();
+}
+
+// Called whenever the firmware sleeps: pass the firmware's output on and
+// queue whatever has been typed at the other end
+static void idle(void)
+{
+	flush_tx();
+	if (hal_uart_rx_pending() >= RX_QUEUE_LIMIT)
+	{
+		return;
+	}
+	int timeout = hal_time_ms() - last_traffic_ms > QUIET_MS ? 10 : 0;
+	struct pollfd p = {master, POLLIN, 0};
+	if (poll(&p, 1, timeout) <= 0 || !(p.revents & POLLIN))
+	{
+		return;
+	}
+	uint8_t buffer[RX_QUEUE_LIMIT];
+	ssize_t n = read(master, buffer, RX_QUEUE_LIMIT - hal_uart_rx_pending());
+	for (ssize_t i = 0; i < n; i++)
+	{
+		hal_uart_rx_push_byte(buffer[i]);
+	}
+	if (n > 0)
+	{
+		last_traffic_ms = hal_time_ms();
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const char *link_path = NULL;
+	int sound = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "l:a")) != -1)
+	{
+		switch (opt)
+		{
+			case 'l':
+				link_path = optarg;
+				break;
+			case 'a':
+				sound = 1;
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-l link] [-a]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	master = posix_openpt(O_RDWR | O_NOCTTY);
+	if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+	{
+		perror("uart_pty: posix_openpt");
+		return 1;
+	}
+	const char *name = ptsname(master);
+	// Keep the other end open, in raw mode, so that reads don't fail
+	// between clients and nothing is echoed or translated
+	int slave = open(name, O_RDWR | O_NOCTTY);
+	struct termios tio;
+	if (slave < 0 || tcgetattr(slave, &tio) != 0)
+	{
+		perror("uart_pty: open pty");
+		return 1;
+	}
+	cfmakeraw(&tio);
+	tcsetattr(slave, TCSANOW, &tio);
+	fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+	if (link_path)
+	{
+		unlink(link_path);
+		if (symlink(name, link_path) != 0)
+		{
+			perror("uart_pty: symlink");
+			return 1;
+		}
+	}
+	printf("%s\n", link_path ? link_path : name);
+	fflush(stdout);
+
+	hal_reset();
+	hal_adc_set_input(0, 512);
+	hal_adc_set_input(1, 512);
+	hal_set_uart_tx_sink(tx_sink);
+	hal_set_idle_hook(idle);
+	if (!sound)
+	{
+		is_muted = 1;
+	}
+	return firmware_main();
+}
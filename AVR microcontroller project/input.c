@@ -0,0 +1,186 @@
+/*
+ * input.c
+ *
+ * The input event queue - see input.h
+ */
+
+#include "input.h"
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "buttons.h"
+#include "remote.h"
+#include "timer0.h"
+
+#if INPUT_QUEUE_SIZE & (INPUT_QUEUE_SIZE - 1) || INPUT_QUEUE_SIZE > 128
+#error INPUT_QUEUE_SIZE must be a power of two up to 128
+#endif
+#define QUEUE_MASK (INPUT_QUEUE_SIZE - 1)
+
+// Events are added at the head, by interrupt handlers and the main loop,
+// and taken from the tail. The indices run freely and are masked when
+// used. There is more than one producer, so the queue is only changed
+// with interrupts off - for the few cycles it takes to copy an event.
+static InputEvent queue[INPUT_QUEUE_SIZE];
+static volatile uint8_t head;
+static volatile uint8_t tail;
+
+static InputStats stats;
+
+void input_init(void)
+{
+	head = tail = 0;
+	stats = (InputStats){0};
+}
+
+// Interrupts must be off
+static uint8_t add(uint8_t type, uint8_t value, int8_t dx, int8_t dy, uint16_t time)
+{
+	uint8_t queued = head - tail;
+	if (queued == INPUT_QUEUE_SIZE)
+	{
+		stats.dropped++;
+		return 0;
+	}
+	InputEvent* event = &queue[head & QUEUE_MASK];
+	event->type = type;
+	event->value = value;
+	event->dx = dx;
+	event->dy = dy;
+	event->time = time;
+	head++;
+	if (++queued > stats.most_queued)
+	{
+		stats.most_queued = queued;
+	}
+	return 1;
+}
+
+uint8_t input_post(InputType type, uint8_t value, uint16_t time)
+{
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	uint8_t posted = add(type, value, 0, 0, time);
+	if (interrupts_were_enabled)
+	{
+		sei();
+	}
+	return posted;
+}
+
+// Add a move to one waiting from the same source
+static int8_t merge(int8_t waiting, int8_t step, InputSource source)
+{
+	int8_t sum = waiting + step;
+	if (source == INPUT_FROM_JOYSTICK)
+	{
+		return sum > 1 ? 1 : sum < -1 ? -1 : sum;
+	}
+	return sum;
+}
+
+uint8_t input_post_move(int8_t dx, int8_t dy, InputSource source, uint16_t time)
+{
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	uint8_t posted = 1;
+	InputEvent* last = &queue[(uint8_t)(head - 1) & QUEUE_MASK];
+	// A remote move is at most REMOTE_MAX_MOVE each way, so one under 64
+	// can take another without overflowing
+	if (head != tail && last->type == INPUT_MOVE && last->value == source
+			&& last->dx < 64 && last->dx > -64 && last->dy < 64 && last->dy > -64)
+	{
+		// Still waiting, so there is no point in queueing this one too. The
+		// merged move keeps its time, as that is how long the player has
+		// been waiting.
+		last->dx = merge(last->dx, dx, source);
+		last->dy = merge(last->dy, dy, source);
+		stats.coalesced++;
+	} else
+	{
+		posted = add(INPUT_MOVE, source, dx, dy, time);
+	}
+	if (interrupts_were_enabled)
+	{
+		sei();
+	}
+	return posted;
+}
+
+uint8_t input_room(void)
+{
+	return INPUT_QUEUE_SIZE - (uint8_t)(head - tail);
+}
+
+uint8_t input_peek(InputEvent* event)
+{
+	remote_poll();
+	
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	uint8_t got = head != tail;
+	if (got)
+	{
+		*event = queue[tail & QUEUE_MASK];
+	}
+	if (interrupts_were_enabled)
+	{
+		sei();
+	}
+	return got;
+}
+
+uint8_t input_get(InputEvent* event)
+{
+	remote_poll();
+	
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	uint8_t got = head != tail;
+	if (got)
+	{
+		*event = queue[tail & QUEUE_MASK];
+		tail++;
+		uint16_t latency = (uint16_t)get_current_time() - event->time;
+		if (latency > stats.worst_latency_ms)
+		{
+			stats.worst_latency_ms = latency;
+		}
+		stats.events++;
+	}
+	if (interrupts_were_enabled)
+	{
+		sei();
+	}
+	return got;
+}
+
+uint8_t input_waiting(void)
+{
+	return head != tail || remote_input_waiting();
+}
+
+void input_clear(void)
+{
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	tail = head;
+	if (interrupts_were_enabled)
+	{
+		sei();
+	}
+	buttons_clear();
+	remote_clear_input();
+}
+
+InputStats input_stats(void)
+{
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	InputStats copy = stats;
+	if (interrupts_were_enabled)
+	{
+		sei();
+	}
+	return copy;
+}
@@ -0,0 +1,87 @@
+/*
+ * input.h
+ *
+ * One queue for everything the player does. The push buttons (from the
+ * timer 0 interrupt) and the joystick (from the ADC interrupt) post events
+ * as they happen, and keys from the serial port, typed or from remote
+ * commands (remote.h), are added as input_get() finds them. Each event
+ * carries the time it happened - for serial input, when the byte that
+ * completed it was received, as it may have waited in the serial input
+ * buffer (serialio.h) before being queued here - so how long it waited
+ * to be handled is known. A move posted while another from the same source is still
+ * waiting is merged into it, so moves don't build up while the game is
+ * busy.
+ */
+
+#ifndef INPUT_H_
+#define INPUT_H_
+
+#include <stdint.h>
+
+// A power of two up to 128
+#ifndef INPUT_QUEUE_SIZE
+#define INPUT_QUEUE_SIZE 8
+#endif
+
+typedef enum {
+	INPUT_BUTTON,	// push button value (0 to 3) was pushed
+	INPUT_KEY,		// key value came from the serial port
+	INPUT_MOVE,		// move the cursor by dx, dy; value is the InputSource
+	INPUT_START,	// a remote command to leave the start or game over screen
+	INPUT_SET_MODE	// a remote command to play the next game in mode value
+} InputType;
+
+// Where a move came from. The joystick moves one step at a time, and a
+// joystick move merged into a waiting one still moves at most one step
+// on each axis. Remote moves are added together.
+typedef enum {
+	INPUT_FROM_JOYSTICK,
+	INPUT_FROM_REMOTE
+} InputSource;
+
+typedef struct {
+	uint8_t type;
+	uint8_t value;
+	int8_t dx;
+	int8_t dy;
+	uint16_t time;	// get_current_time() when it happened, low 16 bits
+} InputEvent;
+
+typedef struct {
+	uint16_t events;			// events handled
+	uint16_t coalesced;			// moves merged into one waiting
+	uint16_t dropped;			// events lost because the queue was full
+	uint16_t worst_latency_ms;	// longest an event waited to be handled
+	uint8_t most_queued;
+} InputStats;
+
+// Empty the queue and zero the statistics
+void input_init(void);
+
+// Queue an event that happened at time (the low 16 bits of
+// get_current_time()). These can be called from interrupt handlers.
+// Return 0 if the queue is full and the event was dropped.
+uint8_t input_post(InputType type, uint8_t value, uint16_t time);
+uint8_t input_post_move(int8_t dx, int8_t dy, InputSource source, uint16_t time);
+
+// Room left in the queue
+uint8_t input_room(void);
+
+// Take the oldest event, after queueing any serial input. Returns 0 if
+// there is none.
+uint8_t input_get(InputEvent* event);
+
+// Copy the oldest event without taking it, after queueing any serial
+// input. Returns 0 if there is none.
+uint8_t input_peek(InputEvent* event);
+
+// Returns non-zero if there is an event, or serial input that may make one
+uint8_t input_waiting(void);
+
+// Forget the events waiting and the serial input not yet read, and stop
+// buttons held down now from repeating
+void input_clear(void);
+
+InputStats input_stats(void);
+
+#endif /* INPUT_H_ */
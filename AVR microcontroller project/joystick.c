@@ -0,0 +1,155 @@
+/*
+ * joystick.c
+ *
+ * Joystick sampling and cursor moves - see joystick.h
+ */
+
+#include "joystick.h"
+#include "input.h"
+#include "timer0.h"
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+#define F_CPU 8000000UL
+
+// Conversions averaged for each reading of an axis
+#define JOYSTICK_OVERSAMPLE 16
+
+// Positions within this distance of the centre don't move the cursor
+#define JOYSTICK_DEAD_ZONE 50
+#define ADC_MID 512
+
+// A free running conversion takes 13 ADC clocks (F_CPU / 128), so this
+// is how often each axis gets a new reading (about 150Hz)
+#define READINGS_PER_SECOND (F_CPU / 128 / 13 / 2 / JOYSTICK_OVERSAMPLE)
+
+// Time between moves for a distance from the centre: 250ms at the edge of
+// the dead zone down to 25ms at full deflection
+#define MOVE_DELAY_MS(offset) \
+	((250 - 200L * (offset) / (ADC_MID - 1 - JOYSTICK_DEAD_ZONE)) > 25 ? \
+	 (250 - 200L * (offset) / (ADC_MID - 1 - JOYSTICK_DEAD_ZONE)) : 25)
+
+// Each reading adds the step for the joystick's distance from the centre
+// (in steps of 32) to the axis's phase; a move is due each time the phase
+// wraps around. Worked out by the compiler from MOVE_DELAY_MS, using the
+// middle of each band (or the edge of the dead zone if that is in it).
+#define BAND_OFFSET(i) ((i) * 32 + 16 > JOYSTICK_DEAD_ZONE ? (i) * 32 + 16 : JOYSTICK_DEAD_ZONE)
+#define PHASE_STEP(i) ((i) * 32 + 31 < JOYSTICK_DEAD_ZONE ? 0 : \
+	(uint16_t)(65536UL * 1000 / READINGS_PER_SECOND / MOVE_DELAY_MS(BAND_OFFSET(i))))
+static const uint16_t phase_steps[17] PROGMEM = {
+	PHASE_STEP(0), PHASE_STEP(1), PHASE_STEP(2), PHASE_STEP(3),
+	PHASE_STEP(4), PHASE_STEP(5), PHASE_STEP(6), PHASE_STEP(7),
+	PHASE_STEP(8), PHASE_STEP(9), PHASE_STEP(10), PHASE_STEP(11),
+	PHASE_STEP(12), PHASE_STEP(13), PHASE_STEP(14), PHASE_STEP(15),
+	PHASE_STEP(16)
+};
+
+typedef struct {
+	uint16_t sum;		// conversions added up so far
+	uint8_t count;
+	uint16_t position;	// smoothed position
+	uint16_t phase;
+} Axis;
+
+static volatile Axis axes[2];
+
+// The channel selected in ADMUX, and the channel of the conversion in
+// progress. In free running mode the next conversion starts as soon as
+// one finishes, so a new channel only applies to the conversion after.
+static uint8_t selected_channel;
+static uint8_t converting_channel;
+
+void init_joystick(void)
+{
+	for (uint8_t i = 0; i < 2; i++)
+	{
+		axes[i].sum = 0;
+		axes[i].count = 0;
+		axes[i].position = ADC_MID;
+		axes[i].phase = 0;
+	}
+	selected_channel = 0;
+	converting_channel = 0;
+	
+	// Set the reference voltage to AVcc and start on channel 0 (X)
+	ADMUX = (1 << REFS0);
+	
+	// Free running mode
+	ADCSRB &= ~((1 << ADTS2) | (1 << ADTS1) | (1 << ADTS0));
+	
+	// Enable the ADC with its interrupt, auto triggering and the
+	// prescaler at 128 (ADC clock 8000000 / 128 = 62500Hz), and start
+	// converting
+	ADCSRA = (1 << ADEN) | (1 << ADSC) | (1 << ADATE) | (1 << ADIE)
+			| (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);
+}
+
+// A new smoothed reading for an axis (0 is X, 1 is Y)
+static void new_reading(uint8_t channel, uint16_t value)
+{
+	volatile Axis* axis = &axes[channel];
+	axis->position = (axis->position * 3 + value) / 4;
+	
+	uint16_t offset = axis->position >= ADC_MID ? axis->position - ADC_MID : ADC_MID - axis->position;
+	uint16_t step = pgm_read_word(&phase_steps[offset >> 5]);
+	if (offset < JOYSTICK_DEAD_ZONE || step == 0)
+	{
+		// Centred - the next push moves straight away
+		axis->phase = 0xFFFF;
+		return;
+	}
+	uint16_t phase = axis->phase + step;
+	if (phase < axis->phase)
+	{
+		// A move that is still waiting absorbs this one
+		int8_t move = axis->position >= ADC_MID ? 1 : -1;
+		input_post_move(channel ? 0 : move, channel ? move : 0, INPUT_FROM_JOYSTICK,
+				get_current_time());
+	}
+	axis->phase = phase;
+}
+
+ISR(ADC_vect)
+{
+	uint16_t value = ADC;
+	uint8_t channel = converting_channel;
+	
+	// The conversion that has just started uses the channel selected
+	// now. Switch channels for the one after it.
+	converting_channel = selected_channel;
+	selected_channel ^= 1;
+	ADMUX = (ADMUX & 0xF0) | selected_channel;
+	
+	volatile Axis* axis = &axes[channel];
+	axis->sum += value;
+	if (++axis->count == JOYSTICK_OVERSAMPLE)
+	{
+		new_reading(channel, axis->sum / JOYSTICK_OVERSAMPLE);
+		axis->sum = 0;
+		axis->count = 0;
+	}
+}
+
+static uint16_t read_position(uint8_t channel)
+{
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	uint16_t position = axes[channel].position;
+	if (interrupts_were_enabled)
+	{
+		sei();
+	}
+	return position;
+}
+
+uint16_t joystick_x(void)
+{
+	return read_position(0);
+}
+
+uint16_t joystick_y(void)
+{
+	return read_position(1);
+}
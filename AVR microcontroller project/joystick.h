@@ -0,0 +1,26 @@
+/*
+ * joystick.h
+ *
+ * The joystick is read by the ADC (X on channel 0, Y on channel 1) in
+ * free running mode. The ADC interrupt alternates between the channels,
+ * averages JOYSTICK_OVERSAMPLE conversions of each and smooths the
+ * result. From the smoothed position it posts cursor moves to the input
+ * queue (input.h) at a rate that depends on how far the joystick is
+ * pushed: from 4 moves a second just outside the dead zone to 40 a second
+ * at full deflection.
+ * Interrupts must be enabled globally for this module to work.
+ */
+
+#ifndef JOYSTICK_H_
+#define JOYSTICK_H_
+
+#include <stdint.h>
+
+// Start the ADC sampling the joystick
+void init_joystick(void);
+
+// Smoothed joystick position on each axis, 0 to 1023 (512 is centred)
+uint16_t joystick_x(void);
+uint16_t joystick_y(void);
+
+#endif /* JOYSTICK_H_ */
@@ -8,6 +8,7 @@
 
 #include "ledmatrix.h"
 #include <stdint.h>
+#include <string.h>
 #include <avr/io.h>
 #include "spi.h"
 
@@ -18,22 +19,230 @@
 #define CMD_SHIFT_DISPLAY	(0x04)
 #define CMD_CLEAR_SCREEN	(0x0F)
 
+// Number of SPI bytes each command takes
+#define PIXEL_CMD_BYTES		3
+#define ROW_CMD_BYTES		(2 + MATRIX_NUM_COLUMNS)
+#define COL_CMD_BYTES		(2 + MATRIX_NUM_ROWS)
+#define ALL_CMD_BYTES		(1 + MATRIX_NUM_COLUMNS * MATRIX_NUM_ROWS)
+#define SHIFT_CMD_BYTES		2
+#define CLEAR_CMD_BYTES		1
+
+// The frame being drawn and what the LED matrix is currently showing.
+// The drawing functions only change frame; ledmatrix_commit() brings the
+// matrix up to date.
+static MatrixData frame;
+static MatrixData shown;
+static uint8_t frame_changed;
+
+// SPI bytes the drawing calls would have taken if each had been sent
+// straight away, and the number actually sent
+static uint32_t bytes_requested;
+static uint32_t bytes_sent;
+
+// Ways of sending the changes in a frame. Rows and columns send a whole
+// row/column where that is cheaper than its changed pixels and the
+// changed pixels otherwise.
+typedef enum {
+	SEND_ROWS,
+	SEND_COLUMNS,
+	SEND_ALL
+} Encoding;
+
+typedef struct {
+	Encoding encoding;
+	uint16_t cost;
+	uint8_t row_changes[MATRIX_NUM_ROWS];
+	uint8_t col_changes[MATRIX_NUM_COLUMNS];
+} UpdatePlan;
+
+static void send_byte(uint8_t byte)
+{
+	spi_queue_byte(byte);
+	bytes_sent++;
+}
+
 void ledmatrix_setup(void)
 {
 	// Setup SPI - we divide the clock by 128.
 	// (This speed guarantees the SPI buffer will never overflow on
-	// the LED matrix.)
+	// the LED matrix.) Commands are queued and sent from the SPI
+	// interrupt so drawing doesn't wait for the (slow) transfers.
 	spi_setup_master(128);
+	
+	// Start from a blank matrix so it matches our copy of it
+	memset(frame, COLOUR_BLACK, sizeof(frame));
+	memset(shown, COLOUR_BLACK, sizeof(shown));
+	frame_changed = 0;
+	send_byte(CMD_CLEAR_SCREEN);
+}
+
+// Count the pixels of frame that differ from what is shown (or from a
+// blank matrix if from_blank is set) and pick the cheapest encoding.
+static void plan_update(UpdatePlan* plan, uint8_t from_blank)
+{
+	memset(plan, 0, sizeof(*plan));
+	for (uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++)
+	{
+		for (uint8_t y = 0; y < MATRIX_NUM_ROWS; y++)
+		{
+			PixelColour base = from_blank ? COLOUR_BLACK : shown[x][y];
+			if (frame[x][y] != base)
+			{
+				plan->row_changes[y]++;
+				plan->col_changes[x]++;
+			}
+		}
+	}
+	
+	uint16_t row_cost = 0;
+	for (uint8_t y = 0; y < MATRIX_NUM_ROWS; y++)
+	{
+		uint16_t pixel_cost = plan->row_changes[y] * PIXEL_CMD_BYTES;
+		row_cost += pixel_cost < ROW_CMD_BYTES ? pixel_cost : ROW_CMD_BYTES;
+	}
+	uint16_t col_cost = 0;
+	for (uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++)
+	{
+		uint16_t pixel_cost = plan->col_changes[x] * PIXEL_CMD_BYTES;
+		col_cost += pixel_cost < COL_CMD_BYTES ? pixel_cost : COL_CMD_BYTES;
+	}
+	
+	plan->encoding = SEND_ROWS;
+	plan->cost = row_cost;
+	if (col_cost < plan->cost)
+	{
+		plan->encoding = SEND_COLUMNS;
+		plan->cost = col_cost;
+	}
+	if (ALL_CMD_BYTES < plan->cost)
+	{
+		plan->encoding = SEND_ALL;
+		plan->cost = ALL_CMD_BYTES;
+	}
+}
+
+static void send_pixel(uint8_t x, uint8_t y)
+{
+	send_byte(CMD_UPDATE_PIXEL);
+	send_byte(((y & 0x07) << 4) | (x & 0x0F));
+	send_byte(frame[x][y]);
+}
+
+static void send_plan(UpdatePlan* plan)
+{
+	switch (plan->encoding)
+	{
+		case SEND_ALL:
+			send_byte(CMD_UPDATE_ALL);
+			for (uint8_t y = 0; y < MATRIX_NUM_ROWS; y++)
+			{
+				for (uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++)
+				{
+					send_byte(frame[x][y]);
+				}
+			}
+			break;
+		case SEND_ROWS:
+			for (uint8_t y = 0; y < MATRIX_NUM_ROWS; y++)
+			{
+				if (plan->row_changes[y] * PIXEL_CMD_BYTES > ROW_CMD_BYTES)
+				{
+					send_byte(CMD_UPDATE_ROW);
+					send_byte(y & 0x07);
+					for (uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++)
+					{
+						send_byte(frame[x][y]);
+					}
+				} else if (plan->row_changes[y])
+				{
+					for (uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++)
+					{
+						if (frame[x][y] != shown[x][y])
+						{
+							send_pixel(x, y);
+						}
+					}
+				}
+			}
+			break;
+		case SEND_COLUMNS:
+			for (uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++)
+			{
+				if (plan->col_changes[x] * PIXEL_CMD_BYTES > COL_CMD_BYTES)
+				{
+					send_byte(CMD_UPDATE_COL);
+					send_byte(x & 0x0F);
+					for (uint8_t y = 0; y < MATRIX_NUM_ROWS; y++)
+					{
+						send_byte(frame[x][y]);
+					}
+				} else if (plan->col_changes[x])
+				{
+					for (uint8_t y = 0; y < MATRIX_NUM_ROWS; y++)
+					{
+						if (frame[x][y] != shown[x][y])
+						{
+							send_pixel(x, y);
+						}
+					}
+				}
+			}
+			break;
+	}
+	memcpy(shown, frame, sizeof(shown));
+}
+
+void ledmatrix_commit(void)
+{
+	if (!frame_changed)
+	{
+		return;
+	}
+	frame_changed = 0;
+	
+	// Either update what is shown, or clear the matrix and draw the
+	// frame from scratch - whichever takes fewer bytes
+	UpdatePlan update, redraw;
+	plan_update(&update, 0);
+	plan_update(&redraw, 1);
+	if (CLEAR_CMD_BYTES + redraw.cost < update.cost)
+	{
+		send_byte(CMD_CLEAR_SCREEN);
+		memset(shown, COLOUR_BLACK, sizeof(shown));
+		send_plan(&redraw);
+	} else
+	{
+		send_plan(&update);
+	}
+}
+
+uint32_t ledmatrix_bytes_sent(void)
+{
+	return bytes_sent;
+}
+
+int32_t ledmatrix_bytes_saved(void)
+{
+	return (int32_t)(bytes_requested - bytes_sent);
+}
+
+static void set_frame_pixel(uint8_t x, uint8_t y, PixelColour pixel)
+{
+	if (frame[x][y] != pixel)
+	{
+		frame[x][y] = pixel;
+		frame_changed = 1;
+	}
 }
 
 void ledmatrix_update_all(MatrixData data)
 {
-	(void)spi_send_byte(CMD_UPDATE_ALL);
+	bytes_requested += ALL_CMD_BYTES;
 	for (uint8_t y = 0; y < MATRIX_NUM_ROWS; y++)
 	{
 		for (uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++)
 		{
-			(void)spi_send_byte(data[x][y]);
+			set_frame_pixel(x, y, data[x][y]);
 		}
 	}
 }
@@ -45,9 +254,8 @@ void ledmatrix_update_pixel(uint8_t x, uint8_t y, PixelColour pixel)
 		// Position isn't valid - we ignore the request.
 		return;
 	}
-	(void)spi_send_byte(CMD_UPDATE_PIXEL);
-	(void)spi_send_byte(((y & 0x07) << 4) | (x & 0x0F));
-	(void)spi_send_byte(pixel);
+	bytes_requested += PIXEL_CMD_BYTES;
+	set_frame_pixel(x, y, pixel);
 }
 
 void ledmatrix_draw_pixel_in_human_grid(uint8_t x, uint8_t y, PixelColour pixel)
@@ -77,11 +285,10 @@ void ledmatrix_update_row(uint8_t y, MatrixRow row)
 		// y value is too large - we ignore the request
 		return;
 	}
-	(void)spi_send_byte(CMD_UPDATE_ROW);
-	(void)spi_send_byte(y & 0x07);	// row number
+	bytes_requested += ROW_CMD_BYTES;
 	for (uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++)
 	{
-		(void)spi_send_byte(row[x]);
+		set_frame_pixel(x, y, row[x]);
 	}
 }
 
@@ -92,41 +299,75 @@ void ledmatrix_update_column(uint8_t x, MatrixColumn col)
 		// x value is too large - we ignore the request
 		return;
 	}
-	(void)spi_send_byte(CMD_UPDATE_COL);
-	(void)spi_send_byte(x & 0x0F); // column number
+	bytes_requested += COL_CMD_BYTES;
 	for (uint8_t y = 0; y < MATRIX_NUM_ROWS; y++)
 	{
-		(void)spi_send_byte(col[y]);
+		set_frame_pixel(x, y, col[y]);
+	}
+}
+
+// Shifting is done by the matrix itself (two bytes rather than a redraw).
+// Anything drawn so far goes out first, then our copies are shifted the
+// same way: by one pixel in x or y with blank pixels shifted in.
+static void shift_display(uint8_t direction, int8_t dx, int8_t dy)
+{
+	ledmatrix_commit();
+	bytes_requested += SHIFT_CMD_BYTES;
+	send_byte(CMD_SHIFT_DISPLAY);
+	send_byte(direction);
+	
+	for (uint8_t i = 0; i < MATRIX_NUM_COLUMNS; i++)
+	{
+		// Work away from the edge pixels move towards so every pixel is
+		// read before it is overwritten
+		uint8_t x = dx > 0 ? MATRIX_NUM_COLUMNS - 1 - i : i;
+		for (uint8_t j = 0; j < MATRIX_NUM_ROWS; j++)
+		{
+			uint8_t y = dy > 0 ? MATRIX_NUM_ROWS - 1 - j : j;
+			int8_t from_x = x - dx;
+			int8_t from_y = y - dy;
+			if (from_x >= 0 && from_x < MATRIX_NUM_COLUMNS && from_y >= 0 && from_y < MATRIX_NUM_ROWS)
+			{
+				shown[x][y] = shown[from_x][from_y];
+			} else
+			{
+				shown[x][y] = COLOUR_BLACK;
+			}
+		}
 	}
+	memcpy(frame, shown, sizeof(frame));
 }
 
 void ledmatrix_shift_display_left(void)
 {
-	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
-	(void)spi_send_byte(0x02);
+	shift_display(0x02, -1, 0);
 }
 
 void ledmatrix_shift_display_right(void)
 {
-	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
-	(void)spi_send_byte(0x01);
+	shift_display(0x01, 1, 0);
 }
 
 void ledmatrix_shift_display_up(void)
 {
-	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
-	(void)spi_send_byte(0x08);
+	shift_display(0x08, 0, 1);
 }
 
 void ledmatrix_shift_display_down(void)
 {
-	(void)spi_send_byte(CMD_SHIFT_DISPLAY);
-	(void)spi_send_byte(0x04);
+	shift_display(0x04, 0, -1);
 }
 
 void ledmatrix_clear(void)
 {
-	(void)spi_send_byte(CMD_CLEAR_SCREEN);
+	bytes_requested += CLEAR_CMD_BYTES;
+	for (uint8_t x = 0; x < MATRIX_NUM_COLUMNS; x++)
+	{
+		for (uint8_t y = 0; y < MATRIX_NUM_ROWS; y++)
+		{
+			set_frame_pixel(x, y, COLOUR_BLACK);
+		}
+	}
 }
 
 void copy_matrix_column(MatrixColumn from, MatrixColumn to)
@@ -33,6 +33,9 @@ void ledmatrix_setup(void);
 // For those functions which take an x or a y value, the value must be valid
 // or the request will be ignored. (i.e. x must be < MATRIX_NUM_COLUMNS
 // and y must be < MATRIX_NUM_ROWS)
+// Drawing is done into a frame held in RAM. Nothing is sent to the LED
+// matrix until ledmatrix_commit() is called (the shift functions commit
+// first since the matrix does the shifting itself).
 void ledmatrix_update_all(MatrixData data);
 void ledmatrix_update_pixel(uint8_t x, uint8_t y, PixelColour pixel);
 void ledmatrix_draw_pixel_in_human_grid(uint8_t x, uint8_t y, PixelColour pixel);
@@ -45,6 +48,16 @@ void ledmatrix_shift_display_up(void);
 void ledmatrix_shift_display_down(void);
 void ledmatrix_clear(void);
 
+// Send the changes made to the frame since the last commit. Only pixels
+// that differ from what the matrix shows are sent, using whichever mix of
+// pixel, row, column and whole-matrix commands takes the fewest bytes.
+void ledmatrix_commit(void);
+
+// SPI bytes sent to the matrix, and the number saved compared to sending
+// every drawing call straight away
+uint32_t ledmatrix_bytes_sent(void);
+int32_t ledmatrix_bytes_saved(void);
+
 // Functions to operate on MatrixRow and MatrixColumn data structures
 void copy_matrix_column(MatrixColumn from, MatrixColumn to);
 void copy_matrix_row(MatrixRow from, MatrixRow to);
@@ -0,0 +1,27 @@
+/*
+ * opening_book.c
+ *
+ * Looks up shots in the opening book - see opening_book.h. The table is
+ * generated by make from SHIP_SIZES in game.h.
+ */
+
+#include "opening_book.h"
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "opening_book_table.h"
+
+#define OPENING_BOOK_NODES ((1 << OPENING_BOOK_DEPTH) - 1)
+
+uint8_t opening_book_has(uint8_t node)
+{
+	return node < OPENING_BOOK_NODES;
+}
+
+uint8_t opening_book_shot(uint8_t node)
+{
+	// Cells are packed 6 bits each, low bits first
+	uint16_t bit = node * 6;
+	const uint8_t* p = &opening_book_table[bit / 8];
+	uint16_t bits = pgm_read_byte(p) | (pgm_read_byte(p + 1) << 8);
+	return (bits >> (bit % 8)) & 0x3F;
+}
@@ -0,0 +1,28 @@
+/*
+ * opening_book.h
+ *
+ * The computer's first shots in Probability Hunt mode, worked out ahead of
+ * time on the host (see host/make_opening_book.c). The book is a tree
+ * with a shot at each node: start at node 0 and after each shot move on
+ * to opening_book_next(node, hit). Once there have been
+ * OPENING_BOOK_DEPTH shots the node is past the end of the book.
+ */
+
+#ifndef OPENING_BOOK_H_
+#define OPENING_BOOK_H_
+
+#include <stdint.h>
+
+// Non-zero while node is in the book
+uint8_t opening_book_has(uint8_t node);
+
+// The cell (y * 8 + x) to fire at for a node in the book
+uint8_t opening_book_shot(uint8_t node);
+
+// The node after a node's shot hits or misses
+static inline uint8_t opening_book_next(uint8_t node, uint8_t hit)
+{
+	return 2 * node + (hit ? 2 : 1);
+}
+
+#endif /* OPENING_BOOK_H_ */
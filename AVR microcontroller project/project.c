@@ -11,7 +11,6 @@
 #include <stdint.h>
 #include <avr/io.h>
 #include <avr/interrupt.h>
-#include <avr/pgmspace.h>
 
 #define F_CPU 8000000UL
 #include <util/delay.h>
@@ -21,10 +20,18 @@
 #include "ledmatrix.h"
 #include "buttons.h"
 #include "serialio.h"
+#include "remote.h"
+#include "input.h"
 #include "terminalio.h"
+#include "screen.h"
 #include "timer0.h"
-#include "timer1.h"
+#include "sound.h"
 #include "timer2.h"
+#include "scheduler.h"
+#include "joystick.h"
+#include "fleet.h"
+#include "events.h"
+#include "bench_marker.h"
 #include <string.h> 
 #include <stdlib.h>
 
@@ -37,7 +44,7 @@ void play_game(void);
 void handle_game_over(void);
 
 uint32_t is_muted = 0;
-char mode[20] = "Basic Moves       ";
+GameMode game_mode = MODE_BASIC;
 
 // WARNING
 // Function prototype for move_is_valid
@@ -45,77 +52,31 @@ uint8_t move_is_valid();
 
 void pause_message(void)
 {
-	move_terminal_cursor(10, 20);
-	printf_P(PSTR("Game Paused. Press 'P' to resume."));
+	screen_write_text(10, 20, TEXT_PAUSED);
 }
 
 void clear_pause_message(void)
 {
-	move_terminal_cursor(10, 20);
-	printf_P(PSTR("                                 "));
+	screen_fill(10, 20, 33, ' ');
 }
 
-void adc_init() {
-	// Set the reference voltage to AVcc
-	ADMUX = (1<<REFS0);
-
-	// Enable ADC and set the prescaler to 128
-	// ADC frequency will be 8000000 / 128 = 62500Hz
-	ADCSRA = (1<<ADEN) | (1<<ADPS2) | (1<<ADPS1) | (1<<ADPS0);
-}
-
-// Read ADC value from a channel
-uint16_t adc_read(uint8_t channel) {
-	// Select ADC channel with safety mask
-	ADMUX = (ADMUX & 0xF0) | (channel & 0x0F);
-
-	// Start single conversion
-	ADCSRA |= (1<<ADSC);
-
-	// Wait for conversion to complete
-	while (ADCSRA & (1<<ADSC));
-
-	return ADC;
-}
-
-// Thresholds for detecting movement
-#define JOYSTICK_DEAD_ZONE 50
-#define ADC_MAX 1023
-#define ADC_MID 512
-
-// Calculate delay based on joystick position
-uint16_t calculate_delay(uint16_t joystick_value) {
-	uint16_t offset = abs(joystick_value - ADC_MID);
-	if (offset < JOYSTICK_DEAD_ZONE) return 0;  // No movement if within dead zone
+// Shows the computer's mode on the start screen
+static void show_mode(void)
+{
+	screen_write_text(screen_write_text(0, 40, TEXT_MODE), 40, game_mode_text(game_mode));
+}
 
-	uint16_t delay = 250 - (200 * offset / (ADC_MAX / 2 - JOYSTICK_DEAD_ZONE));
-	return delay > 25 ? delay : 25;  // Ensure minimum delay for controllability
+static void mode_change_event(const Event* event)
+{
+	show_mode();
 }
 
-// Delay for the joystick
-void custom_delay_ms(uint16_t milliseconds) {
-	while (milliseconds) {
-		_delay_ms(1);  
-		milliseconds--;
-	}
-}
-// Joystick movement
-void move_cursor_with_joystick(void) {
-	uint16_t x_pos = adc_read(0);
-	uint16_t y_pos = adc_read(1);
-
-	int8_t dx = 0, dy = 0;
-	if (x_pos > ADC_MID + JOYSTICK_DEAD_ZONE) dx = 1;
-	else if (x_pos < ADC_MID - JOYSTICK_DEAD_ZONE) dx = -1;
-
-	if (y_pos > ADC_MID + JOYSTICK_DEAD_ZONE) dy = 1;
-	else if (y_pos < ADC_MID - JOYSTICK_DEAD_ZONE) dy = -1;
-
-	uint16_t delay = calculate_delay(dx ? x_pos : y_pos);
-	if (delay) {
-		move_cursor(dx, dy);
-		custom_delay_ms(delay);
-	}
+// Returns non-zero if the event starts a game from the start or game
+// over screen: any button, 's' or a remote start command
+static uint8_t starts_game(const InputEvent* event)
+{
+	return event->type == INPUT_BUTTON || event->type == INPUT_START ||
+			(event->type == INPUT_KEY && (event->value == 's' || event->value == 'S'));
 }
 
 // Equals to 1 if the computer firing animation is running
@@ -133,9 +94,6 @@ int main(void)
 	// is complete.
 	start_screen();
 	
-	// Make pin OC1B be an output (port D, pin 4)
-	DDRD = (1<<4);
-	
 	// Loop forever and continuously play the game.
 	while(1)
 	{
@@ -148,46 +106,55 @@ int main(void)
 void initialise_hardware(void)
 {
 	ledmatrix_setup();
-	init_button_interrupts();
+	input_init();
+	init_buttons();
 	// Setup serial port for 19200 baud communication with no echo
 	// of incoming characters
 	init_serial_stdio(19200, 0);
 	
 	init_timer0();
-	init_timer1();
+	init_sound();
 	init_timer2();
-	adc_init(); // Initialize the ADC for joystick
+	scheduler_init();
+#ifdef FLEET_SEED
+	// The same fleets every run
+	fleet_seed(FLEET_SEED);
+#endif
+	init_joystick();
+	events_init();
+	init_game_events();
+	events_subscribe(mode_change_event, EVENT_MASK(EVENT_MODE_CHANGE));
+	remote_init();
 	// Turn on global interrupts
 	sei();
+#ifdef BENCH_MARKERS
+	terminal_bench();
+#endif
+}
+
+// Play the next game in the given mode
+static void set_mode(GameMode mode)
+{
+	if (mode != game_mode)
+	{
+		game_mode = mode;
+		event_post(EVENT_MODE_CHANGE, 0, 0, game_mode);
+	}
 }
 
 void start_screen(void)
 {
 	// Clear terminal screen and output a message
-	clear_terminal();
+	screen_clear();
 	hide_cursor();
 	set_display_attribute(FG_WHITE);
-	move_terminal_cursor(10,4);
-	printf_P(PSTR(" _______    ______  ________  ________  __        ________   ______   __    __  ______  _______  "));
-	move_terminal_cursor(10,5);
-	printf_P(PSTR("|       \\  /      \\|        \\|        \\|  \\      |        \\ /      \\ |  \\  |  \\|      \\|       \\ "));
-	move_terminal_cursor(10,6);
-	printf_P(PSTR("| $$$$$$$\\|  $$$$$$\\\\$$$$$$$$ \\$$$$$$$$| $$      | $$$$$$$$|  $$$$$$\\| $$  | $$ \\$$$$$$| $$$$$$$\\"));
-	move_terminal_cursor(10,7);
-	printf_P(PSTR("| $$__/ $$| $$__| $$  | $$      | $$   | $$      | $$__    | $$___\\$$| $$__| $$  | $$  | $$__/ $$"));
-	move_terminal_cursor(10,8);
-	printf_P(PSTR("| $$    $$| $$    $$  | $$      | $$   | $$      | $$  \\    \\$$    \\ | $$    $$  | $$  | $$    $$"));
-	move_terminal_cursor(10,9);
-	printf_P(PSTR("| $$$$$$$\\| $$$$$$$$  | $$      | $$   | $$      | $$$$$    _\\$$$$$$\\| $$$$$$$$  | $$  | $$$$$$$ "));
-	move_terminal_cursor(10,10);
-	printf_P(PSTR("| $$__/ $$| $$  | $$  | $$      | $$   | $$_____ | $$_____ |  \\__| $$| $$  | $$ _| $$_ | $$      "));
-	move_terminal_cursor(10,11);
-	printf_P(PSTR("| $$    $$| $$  | $$  | $$      | $$   | $$     \\| $$     \\ \\$$    $$| $$  | $$|   $$ \\| $$      "));
-	move_terminal_cursor(10,12);
-	printf_P(PSTR(" \\$$$$$$$  \\$$   \\$$   \\$$       \\$$    \\$$$$$$$$ \\$$$$$$$$  \\$$$$$$  \\$$   \\$$ \\$$$$$$ \\$$      "));
-	move_terminal_cursor(10,14);
-	// change this to your name and student number; remove the chevrons <>
-	printf_P(PSTR("CSSE2010/7201 Project by <Haozhi Ryan Yang> - <46968096>"));
+	// The banner is sent a line at a time by screen_flush() as the UART
+	// has room; the student line is in text_assets.txt
+	for (uint8_t i = 0; i < 9; i++)
+	{
+		screen_write_text(10, 4 + i, TEXT_BANNER_1 + i);
+	}
+	screen_write_text(10, 14, TEXT_STUDENT);
 	
 	// Output the static start screen and wait for a push button 
 	// to be pushed or a serial input of 's'
@@ -198,44 +165,34 @@ void start_screen(void)
 	
 	int8_t frame_number = -2*ANIMATION_DELAY;
 	
-	move_terminal_cursor(0, 40);
-	printf("MODE: %s", mode);
+	show_mode();
 
 	// Wait until a button is pressed, or 's' is pressed on the terminal
 	while(1)
 	{
-		// First check for if a 's' or a is pressed
-		// There are two steps to this
-		// 1) collect any serial input (if available)
-		// 2) check if the input is equal to the character 's' or 'a'
-		char serial_input = -1;
-		if (serial_input_available())
-		{
-			serial_input = fgetc(stdin);
-		}
-				
-		if (serial_input == 's' || serial_input == 'S') {
-			 
-			break;
-		}
+		BENCH_MARK(BENCH_INPUT_POLL);
 		
-		if (serial_input == 'y' || serial_input == 'Y') {
-			if (strcmp(mode, "Basic Moves       ") == 0) {
-				move_terminal_cursor(0, 40);
-				strcpy(mode, "Search and Destroy");
-				printf("MODE: %s", mode);
-			} else {
-				strcpy(mode, "Basic Moves       ");
-				move_terminal_cursor(0, 40);
-				printf("MODE: %s", mode);
+		// Handle all the input that has arrived since last time round:
+		// 'y' or a remote command changes the mode, and a button or 's'
+		// starts the game
+		uint8_t start = 0;
+		InputEvent event;
+		while (!start && input_get(&event))
+		{
+			if (starts_game(&event))
+			{
+				start = 1;
+			} else if (event.type == INPUT_KEY && (event.value == 'y' || event.value == 'Y'))
+			{
+				// Next mode
+				set_mode((game_mode + 1) % NUM_GAME_MODES);
+			} else if (event.type == INPUT_SET_MODE)
+			{
+				set_mode(event.value);
 			}
-			
 		}
-		
-		
-		// Next check for any button presses
-		int8_t btn = button_pushed();
-		if (btn != NO_BUTTON_PUSHED)
+		events_dispatch();
+		if (start)
 		{
 			break;
 		}
@@ -252,232 +209,311 @@ void start_screen(void)
 			}
 			last_screen_update = current_time;
 		}
+		
+		// Send this iteration's drawing to the LED matrix and terminal
+		ledmatrix_commit();
+		screen_flush();
+		
+		// Nothing more to do until the next tick or some input
+		scheduler_sleep_unless(input_waiting);
 	}
 }
 
 void new_game(void)
 {
 	// Clear the serial terminal
-	clear_terminal();
+	screen_clear();
+	
+#ifndef FLEET_SEED
+	// New fleets every game. How long the player took to start it is
+	// as random as anything we have.
+	fleet_seed(get_current_time_us());
+#endif
 	
 	// Initialize the game and display
 	initialise_game();
+	event_post(EVENT_NEW_GAME, 0, 0, game_mode);
+	BENCH_MARK(BENCH_GAME_START);
 	
-	// Clear a button push or serial input if any are waiting
-	// (The cast to void means the return value is ignored.)
-	(void)button_pushed();
-	clear_serial_input_buffer();
+	// Clear button pushes or serial input if any are waiting, and
+	// don't repeat a button still held from the start screen
+	input_clear();
 	
 }
 
-void play_game(void)
+// Tasks run by the scheduler while a game is played
+TaskId input_task, flash_task, animation_task, reveal_task, display_task;
+TaskId think_task, events_task;
+
+static uint8_t game_paused;
+static uint8_t cheat_used;
+
+// Pausing stops the cursor and the computer (and handle_event() ignores
+// the buttons and joystick)
+static void set_game_tasks_enabled(uint8_t enabled)
 {
-	uint32_t last_flash_time, current_time;
-	int8_t btn; 
+	scheduler_enable(flash_task, enabled);
+	scheduler_enable(animation_task, enabled);
+	scheduler_enable(think_task, enabled);
+}
+
+// Handle a button push, a joystick move or a character from the serial
+// port. Returns non-zero if the human fired, after which the game may be
+// over.
+static uint8_t handle_event(const InputEvent* event)
+{
+	// See `input.h` for the events and `buttons.h` for the button numbers
+	int8_t btn = event->type == INPUT_BUTTON ? event->value : NO_BUTTON_PUSHED;
+	char serial_input = event->type == INPUT_KEY ? event->value : 0;
+	uint8_t fired = 0;
 	
-	last_flash_time = get_current_time();
+	// While paused only 'p' does anything
+	if (game_paused)
+	{
+		if (serial_input == 'p' || serial_input == 'P')
+		{
+			game_paused = 0;
+			set_game_tasks_enabled(1);
+			clear_pause_message();
+		}
+		return 0;
+	}
 	
-	// time at when the computer's ships were revealed
-	uint32_t reveal_start_time = 0;
+	if (event->type == INPUT_MOVE && (event->dx || event->dy))
+	{
+		// From the joystick or a remote command
+		move_cursor(event->dx, event->dy);
+	}
 	
-	uint8_t reveal_end_time = 0;
-	uint8_t game_paused = 0;
-	uint32_t pause_start_time = 0;
-	uint32_t pause_duration = 0;
-	uint32_t cheat_used = 0;
-	  
-	// We play the game until it's over
-	while (!is_game_over())
-	{
-		
-			
-			// Handle joystick movement
-			move_cursor_with_joystick();
-		
-			// We need to check if any button has been pushed, this will be
-			// NO_BUTTON_PUSHED if no button has been pushed
-			// Checkout the function comment in `buttons.h` and the implementation
-			// in `buttons.c`.
-			btn = button_pushed();
-		
-			if (btn == BUTTON0_PUSHED)
-			{
-				// move the cursor
-				// see move_cursor(...) in game.c
-				// remember to reset the cursor flashing cycle
-		
-				move_cursor(1, 0);
-			}
-			// repeat for the other buttons
-			// combine with serial inputs
+	if (btn == BUTTON0_PUSHED)
+	{
+		// move the cursor
+		// see move_cursor(...) in game.c
+		// remember to reset the cursor flashing cycle
 		
-			if (btn == BUTTON1_PUSHED)
-			{
-				// move the cursor
-				// see move_cursor(...) in game.c
-				// remember to reset the cursor flashing cycle
-			
-				move_cursor(0, -1);
-			}
+		move_cursor(1, 0);
+	}
+	// repeat for the other buttons
+	// combine with serial inputs
 		
-			if( btn == BUTTON2_PUSHED)
-			{
-				// move the cursor
-				// see move_cursor(...) in game.c
-				// remember to reset the cursor flashing cycle
+	if (btn == BUTTON1_PUSHED)
+	{
+		// move the cursor
+		// see move_cursor(...) in game.c
+		// remember to reset the cursor flashing cycle
 			
-				move_cursor(0, 1);
-			}
+		move_cursor(0, -1);
+	}
 		
-			if (btn == BUTTON3_PUSHED)
-			{
-				// move the cursor
-				// see move_cursor(...) in game.c
-				// remember to reset the cursor flashing cycle
+	if( btn == BUTTON2_PUSHED)
+	{
+		// move the cursor
+		// see move_cursor(...) in game.c
+		// remember to reset the cursor flashing cycle
 			
-				move_cursor(-1, 0);
-			}
-		
-			current_time = get_current_time();
-			if (current_time - pause_duration >= last_flash_time + 200)
-			{
-				// 200ms (0.2 second) has passed since the last time we advance the
-				// notes here, so update the advance the notes
-				flash_cursor();
-				
-				pause_duration = 0;
-				
-				// Update the most recent time the notes were advance
-				last_flash_time = current_time;
-			}
-		
-			char serial_input = -1;
-			if (serial_input_available())
-			{
-				serial_input = fgetc(stdin);
-			}
-		
-			if (serial_input == 's' || serial_input == 'S')
-			{
-				// Move cursor with terminal input
-				move_cursor(0, -1);
-			} else if (serial_input == 'w' || serial_input == 'W') {
-				// Move cursor with terminal input
-				move_cursor(0, 1);
-			} else if (serial_input == 'a' || serial_input == 'A') {
-				// Move cursor with terminal input
-				move_cursor(-1, 0);
-			} else if (serial_input == 'd' || serial_input == 'D') {
-				// Move cursor with terminal input
-				move_cursor(1, 0);
-			} else if (serial_input == 'f' || serial_input == 'F') {
-				// Fire at location
-				if (move_is_valid()) {
-					fire_at_location(0, 0);
-					computer_turn();	
-				}
-			} else if (serial_input == 'c' || serial_input == 'C') {
-				// Reveals the computer's ships
-				reveal_start_time = get_current_time();
-				reveal_computer_ships();	
-				reveal_end_time = 1;
-			} else if (serial_input == 'p' || serial_input == 'P') {
-				// Pauses the game
-				game_paused = 1;
-				pause_start_time = get_current_time();
-				pause_duration = 0;
-				clear_invalid_move_message();
-				pause_message();
-			} else if (serial_input == 'b' || serial_input == 'B') {
-				if (cheat_used == 0) {
-					// Fires at the location and its surroundings
-					fire_around_location();
-					computer_turn();
-					cheat_used ++;
-				} else {
-					invalid_move_message();
-				}
-			} else if (serial_input == 'n' || serial_input == 'N') {
-				if (cheat_used == 0) {
-					// Fires at the location and its row
-					fire_in_row();
-					computer_turn();
-					cheat_used ++;
-					} else {
-					invalid_move_message();
-				}
-			} else if (serial_input == 'm' || serial_input == 'M') {
-				if (cheat_used == 0) {
-					// Fires at the location and its column
-					fire_in_column();
-					computer_turn();
-					cheat_used ++;
-					} else {
-					invalid_move_message();
-				}
-			} else if (serial_input == 'q' || serial_input == 'Q') {
-				// mute/unmute the sound
-				if (is_muted) {
-					is_muted = 0;
-				} else {
-					is_muted = 1;
-				}
-			}
-		
-			// Hides the computer's ships after 1 second
-			if (reveal_end_time && current_time - reveal_start_time >= 1000) {
-				hide_computer_ships();
-				reveal_end_time = 0;
-			}
+		move_cursor(0, 1);
+	}
 		
-			// Handles the pause
-			while (game_paused) {
-				char serial_input = -1;
-				if (serial_input_available())
-				{
-					serial_input = fgetc(stdin);
-				}
-			
-				if (serial_input == 'p' || serial_input == 'P')
-				{
-					pause_duration += get_current_time() - pause_start_time;
-					game_paused = 0;
-					clear_pause_message();
-				}
+	if (btn == BUTTON3_PUSHED)
+	{
+		// move the cursor
+		// see move_cursor(...) in game.c
+		// remember to reset the cursor flashing cycle
 			
-			}
-		
-		
+		move_cursor(-1, 0);
+	}
+	
+	if (serial_input == 's' || serial_input == 'S')
+	{
+		// Move cursor with terminal input
+		move_cursor(0, -1);
+	} else if (serial_input == 'w' || serial_input == 'W') {
+		// Move cursor with terminal input
+		move_cursor(0, 1);
+	} else if (serial_input == 'a' || serial_input == 'A') {
+		// Move cursor with terminal input
+		move_cursor(-1, 0);
+	} else if (serial_input == 'd' || serial_input == 'D') {
+		// Move cursor with terminal input
+		move_cursor(1, 0);
+	} else if (serial_input == 'f' || serial_input == 'F') {
+		// Fire at location
+		if (move_is_valid()) {
+			fire_at_location(0, 0);
+			computer_turn();	
+			fired = 1;
+		}
+	} else if (serial_input == 'c' || serial_input == 'C') {
+		// Reveals the computer's ships, and hides them again after
+		// 1 second
+		reveal_computer_ships();
+		scheduler_enable(reveal_task, 0);
+		scheduler_enable(reveal_task, 1);
+	} else if (serial_input == 'p' || serial_input == 'P') {
+		// Pauses the game
+		game_paused = 1;
+		set_game_tasks_enabled(0);
+		clear_invalid_move_message();
+		pause_message();
+	} else if (serial_input == 'b' || serial_input == 'B') {
+		if (cheat_used == 0) {
+			// Fires at the location and its surroundings
+			fire_around_location();
+			computer_turn();
+			fired = 1;
+			cheat_used ++;
+		} else {
+			invalid_move_message();
+		}
+	} else if (serial_input == 'n' || serial_input == 'N') {
+		if (cheat_used == 0) {
+			// Fires at the location and its row
+			fire_in_row();
+			computer_turn();
+			fired = 1;
+			cheat_used ++;
+			} else {
+			invalid_move_message();
+		}
+	} else if (serial_input == 'm' || serial_input == 'M') {
+		if (cheat_used == 0) {
+			// Fires at the location and its column
+			fire_in_column();
+			computer_turn();
+			fired = 1;
+			cheat_used ++;
+			} else {
+			invalid_move_message();
+		}
+	} else if (serial_input == 'q' || serial_input == 'Q') {
+		// mute/unmute the sound
+		if (is_muted) {
+			is_muted = 0;
+		} else {
+			is_muted = 1;
+			sound_stop();
+		}
+	}
+	return fired;
+}
+
+// Returns non-zero for the keys that fire
+static uint8_t is_fire(const InputEvent* event)
+{
+	char key = event->type == INPUT_KEY ? event->value : 0;
+	return key == 'f' || key == 'F' || key == 'b' || key == 'B' ||
+			key == 'n' || key == 'N' || key == 'm' || key == 'M';
+}
+
+// The human can't fire again until the computer's shot has landed, so a
+// fire waits at the front of the queue until then, and what was queued
+// after it waits behind it. (While the game is paused fires are taken
+// and ignored, like everything but 'p'.)
+static uint8_t fire_must_wait(void)
+{
+	InputEvent event;
+	return animation_running && !game_paused && input_peek(&event) && is_fire(&event);
+}
+
+static uint8_t input_ready(void)
+{
+	return input_waiting() && !fire_must_wait();
+}
+
+// Handle everything in the input queue in one go, unless the human
+// fires: the game may be over, which is checked before anything else
+static void handle_input(void)
+{
+	InputEvent event;
+	while (!fire_must_wait() && input_get(&event))
+	{
+		if (handle_event(&event))
+		{
+			break;
+		}
+	}
+}
+
+// Sends whatever has been drawn to the LED matrix and written to the
+// terminal
+static void update_display(void)
+{
+	BENCH_MARK(BENCH_COMMIT_START);
+	ledmatrix_commit();
+	screen_flush();
+	BENCH_MARK(BENCH_COMMIT_END);
+}
+
+// Hides the computer's ships once they have been shown for 1 second
+static void end_reveal(void)
+{
+	hide_computer_ships();
+	scheduler_enable(reveal_task, 0);
+}
+
+void play_game(void)
+{
+	game_paused = 0;
+	cheat_used = 0;
+	
+	// Input is handled as it arrives; everything else runs off the
+	// millisecond tick. The game's events are handed to the display, sound
+	// and terminal code after the tasks that post them, and the LED matrix
+	// is sent whatever has been drawn after that. The computer works out its
+	// next shot with any time left over. The tasks are set up for the
+	// first game and kept (along with their statistics) after that.
+	if (scheduler_num_tasks() == 0)
+	{
+		input_task = scheduler_add_event(handle_input, input_ready, 50);
+		flash_task = scheduler_add_periodic(flash_cursor, 200);
+		animation_task = scheduler_add_periodic(update_computer_fire_animation, 10);
+		reveal_task = scheduler_add_periodic(end_reveal, 1000);
+		events_task = scheduler_add_event(events_dispatch, events_pending, 10);
+		display_task = scheduler_add_periodic(update_display, 1);
+		think_task = scheduler_add_event(computer_think, computer_thinking, 100);
+	}
+	set_game_tasks_enabled(1);
+	scheduler_enable(reveal_task, 0);
+	  
+	// We play the game until it's over
+	while (!is_game_over())
+	{
+		BENCH_MARK(BENCH_GAME_LOOP);
+		scheduler_run_once();
 	}
 	// We get here if the game is over.
 }
 
 void handle_game_over()
 {
-	move_terminal_cursor(10,14);
-	printf_P(PSTR("GAME OVER"));
-	move_terminal_cursor(10,15);
-	printf_P(PSTR("Press a button or 's'/'S' to start a new game"));
+	BENCH_MARK(BENCH_GAME_OVER);
+	
+	screen_write_text(10, 14, TEXT_GAME_OVER);
+	screen_write_text(10, 15, TEXT_PLAY_AGAIN);
 		
 	// Do nothing until a button or 's'/'S' are pushed should also start a
 	// new game
 	while (1) {
-			char serial_input = -1;
-			if (serial_input_available())
-			{
-				serial_input = fgetc(stdin);
-			}
-			// If the serial input is 's', then exit the start screen
-			if (serial_input == 's' || serial_input == 'S')
+			BENCH_MARK(BENCH_INPUT_POLL);
+			screen_flush();
+			
+			// Everything but a button, 's' or a remote command to start or
+			// change the mode is ignored here
+			uint8_t start = 0;
+			InputEvent event;
+			while (!start && input_get(&event))
 			{
-				break;
+				start = starts_game(&event);
+				if (event.type == INPUT_SET_MODE)
+				{
+					set_mode(event.value);
+				}
 			}
-			// Next check for any button presses
-			int8_t btn = button_pushed();
-			if (btn != NO_BUTTON_PUSHED)
+			if (start)
 			{
 				break;
 			}
+			scheduler_sleep_unless(input_waiting);
 	}
 	
 	start_screen();
@@ -0,0 +1,326 @@
+/*
+ * remote.c
+ *
+ * Terminal keys and the binary command protocol - see remote.h
+ */
+
+#include "remote.h"
+#include <stdio.h>
+#include <stdint.h>
+#include "remote_protocol.h"
+#include "frame.h"
+#include "serialio.h"
+#include "events.h"
+#include "game.h"
+#include "input.h"
+#include "timer0.h"
+#include "screen.h"
+
+static uint8_t binary;
+static FrameDecoder decoder;
+static uint16_t bad_frames;
+
+// The bytes received since a zero in text mode, while they may be a
+// HELLO frame. If they aren't, they were keys after all. A HELLO frame
+// and the zero that ends it take 7 bytes.
+#define HANDSHAKE_MAX 8
+#define HANDSHAKE_TIMEOUT_MS 50
+static uint8_t handshake;
+static char held[HANDSHAKE_MAX];
+static uint8_t num_held;
+static uint32_t handshake_time;
+
+// The sequence number and status of the last command run, so that one
+// sent again because its ACK was lost is answered but not run twice
+static uint8_t last_seq;
+static uint8_t last_status;
+static uint8_t have_last;
+static uint32_t human_shot_us;
+
+static void send(uint8_t* packet, uint8_t length)
+{
+	frame_encode(packet, frame_seal(packet, length), serial_put_byte);
+}
+
+static void put16(uint8_t* p, uint16_t value)
+{
+	p[0] = value & 0xFF;
+	p[1] = value >> 8;
+}
+
+// Events go to the host as they happen, along with the time from each
+// of the human's shots to the computer's reply
+static void remote_event(const Event* event)
+{
+	if (!binary)
+	{
+		return;
+	}
+	uint8_t packet[5 + 2] = {REMOTE_EVENT, event->type, event->player, event->cell,
+			event->detail};
+	send(packet, 5);
+	
+	if (event->type == EVENT_SHOT_FIRED)
+	{
+		uint32_t now = get_current_time_us();
+		if (event->player == PLAYER_HUMAN)
+		{
+			human_shot_us = now;
+		} else
+		{
+			uint32_t turn_us = now - human_shot_us;
+			uint8_t turn[5 + 2] = {REMOTE_TURN, turn_us, turn_us >> 8, turn_us >> 16,
+					turn_us >> 24};
+			send(turn, 5);
+		}
+	}
+}
+
+void remote_init(void)
+{
+	binary = 0;
+	handshake = 0;
+	bad_frames = 0;
+	events_subscribe(remote_event, (1 << NUM_EVENT_TYPES) - 1);
+}
+
+static void send_status(void)
+{
+	SerialStats serial = serial_stats();
+	uint8_t packet[12 + 2] = {REMOTE_STATUS, serial_output_space(),
+			INPUT_QUEUE_SIZE - input_room(), events_stats()->most_queued};
+	put16(&packet[4], serial.tx_stalls);
+	put16(&packet[6], serial.tx_dropped);
+	put16(&packet[8], serial.rx_overruns);
+	put16(&packet[10], bad_frames);
+	send(packet, 12);
+}
+
+static uint8_t magnitude(int8_t value)
+{
+	return value < 0 ? -value : value;
+}
+
+// Turn a command that arrived at time into input events. Returns its
+// RemoteStatus.
+static uint8_t run_command(const uint8_t* packet, uint8_t length, uint16_t time)
+{
+	switch (packet[0])
+	{
+		case REMOTE_CMD_MOVE:
+		{
+			if (length != 4)
+			{
+				return REMOTE_BAD_ARGUMENT;
+			}
+			int8_t dx = packet[2];
+			int8_t dy = packet[3];
+			if (magnitude(dx) > REMOTE_MAX_MOVE || magnitude(dy) > REMOTE_MAX_MOVE)
+			{
+				return REMOTE_BAD_ARGUMENT;
+			}
+			// A move, not keys: 's' is a move down only during a game
+			return input_post_move(dx, dy, INPUT_FROM_REMOTE, time) ? REMOTE_OK : REMOTE_BUSY;
+		}
+		case REMOTE_CMD_SET_MODE:
+		{
+			if (length != 3 || packet[2] >= NUM_GAME_MODES)
+			{
+				return REMOTE_BAD_ARGUMENT;
+			}
+			return input_post(INPUT_SET_MODE, packet[2], time) ? REMOTE_OK : REMOTE_BUSY;
+		}
+		case REMOTE_CMD_ANIMATION:
+			if (length != 3 || packet[2] > 1)
+			{
+				return REMOTE_BAD_ARGUMENT;
+			}
+			set_fire_animation(packet[2]);
+			return REMOTE_OK;
+		case REMOTE_CMD_FIRE:
+		case REMOTE_CMD_PAUSE:
+		case REMOTE_CMD_START:
+		{
+			if (length != 2)
+			{
+				return REMOTE_BAD_ARGUMENT;
+			}
+			uint8_t posted = packet[0] == REMOTE_CMD_START ? input_post(INPUT_START, 0, time) :
+					input_post(INPUT_KEY, packet[0] == REMOTE_CMD_FIRE ? 'f' : 'p', time);
+			return posted ? REMOTE_OK : REMOTE_BUSY;
+		}
+		case REMOTE_CMD_STATUS:
+		case REMOTE_CMD_TEXT:
+			if (length != 2)
+			{
+				return REMOTE_BAD_ARGUMENT;
+			}
+			if (packet[0] == REMOTE_CMD_STATUS)
+			{
+				send_status();
+			}
+			return REMOTE_OK;
+		case REMOTE_CMD_HELLO:
+			// Already in binary mode, so there is nothing more to do
+			if (length != 3 || packet[2] != REMOTE_PROTOCOL_VERSION)
+			{
+				return REMOTE_BAD_ARGUMENT;
+			}
+			return REMOTE_OK;
+		default:
+			return REMOTE_UNKNOWN_COMMAND;
+	}
+}
+
+static void start_text(void);
+
+// The byte arrived at time, which a command it completes happened at
+static void receive_byte(uint8_t byte, uint16_t time)
+{
+	int8_t length = frame_decode_byte(&decoder, byte);
+	if (length == FRAME_BAD)
+	{
+		bad_frames++;
+		uint8_t packet[1 + 2] = {REMOTE_BAD_FRAME};
+		send(packet, 1);
+	} else if (length > 0)
+	{
+		// Commands without a sequence number can't be answered
+		if (length < 2)
+		{
+			bad_frames++;
+			return;
+		}
+		uint8_t seq = decoder.data[1];
+		uint8_t status;
+		if (have_last && seq == last_seq && decoder.data[0] != REMOTE_CMD_STATUS)
+		{
+			status = last_status;
+		} else
+		{
+			status = run_command(decoder.data, length, time);
+			// A busy command wasn't run, so it is run when sent again
+			if (status != REMOTE_BUSY)
+			{
+				last_seq = seq;
+				last_status = status;
+				have_last = 1;
+			}
+		}
+		uint8_t ack[3 + 2] = {REMOTE_ACK, seq, status};
+		send(ack, 3);
+		if (decoder.data[0] == REMOTE_CMD_TEXT && status == REMOTE_OK)
+		{
+			start_text();
+		}
+	}
+}
+
+static void start_binary(void)
+{
+	binary = 1;
+	handshake = 0;
+	have_last = 0;
+	serial_set_text_output(0);
+	uint8_t packet[2 + 2] = {REMOTE_HELLO, REMOTE_PROTOCOL_VERSION};
+	send(packet, 2);
+}
+
+// Back to the terminal, as the firmware starts. The terminal is cleared,
+// as what it showed before binary mode is out of date.
+static void start_text(void)
+{
+	binary = 0;
+	serial_set_text_output(1);
+	set_fire_animation(1);
+	screen_clear();
+}
+
+// The bytes since the zero weren't a HELLO frame, so they are keys. Any
+// that don't fit in the input queue are lost.
+static void end_handshake(void)
+{
+	handshake = 0;
+	for (uint8_t i = 0; i < num_held; i++)
+	{
+		if (held[i] != 0)
+		{
+			input_post(INPUT_KEY, held[i], handshake_time);
+		}
+	}
+	num_held = 0;
+}
+
+static void handshake_byte(char c)
+{
+	held[num_held++] = c;
+	int8_t length = frame_decode_byte(&decoder, c);
+	if (length == 3 && decoder.data[0] == REMOTE_CMD_HELLO &&
+			decoder.data[2] == REMOTE_PROTOCOL_VERSION)
+	{
+		start_binary();
+	} else if (length != 0 || num_held == HANDSHAKE_MAX)
+	{
+		end_handshake();
+	}
+}
+
+static uint8_t handshake_timed_out(void)
+{
+	return handshake && get_current_time() - handshake_time > HANDSHAKE_TIMEOUT_MS;
+}
+
+void remote_poll(void)
+{
+	if (handshake_timed_out())
+	{
+		end_handshake();
+	}
+	while (serial_input_available())
+	{
+		if (binary)
+		{
+			// Commands that don't fit are answered REMOTE_BUSY
+			uint16_t time = serial_input_time();
+			receive_byte(serial_get_byte(), time);
+		} else
+		{
+			// Keys that don't fit wait in the serial input buffer
+			if (!input_room())
+			{
+				return;
+			}
+			uint16_t time = serial_input_time();
+			char c = fgetc(stdin);
+			if (handshake)
+			{
+				handshake_byte(c);
+			} else if (c != 0)
+			{
+				input_post(INPUT_KEY, c, time);
+			} else
+			{
+				// Perhaps the start of a HELLO frame
+				handshake = 1;
+				num_held = 0;
+				handshake_time = get_current_time();
+				frame_decoder_init(&decoder);
+			}
+		}
+	}
+}
+
+uint8_t remote_input_waiting(void)
+{
+	// Held bytes are keys once the handshake times out
+	return serial_input_available() || handshake_timed_out();
+}
+
+void remote_clear_input(void)
+{
+	if (!binary)
+	{
+		clear_serial_input_buffer();
+		num_held = 0;
+	}
+}
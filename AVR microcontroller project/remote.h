@@ -0,0 +1,40 @@
+/*
+ * remote.h
+ *
+ * Input from the serial port, as terminal keys or as binary commands.
+ *
+ * The port starts out as the text terminal. A zero byte followed by a
+ * frame (frame.h) carrying REMOTE_CMD_HELLO with the right protocol
+ * version switches it to the binary protocol in remote_protocol.h, and
+ * REMOTE_CMD_TEXT switches it back. Anything else after a zero, or a
+ * frame that doesn't finish within 50 ms, is taken as keys, so a stray
+ * zero from a terminal only holds up the keys after it. In binary mode
+ * text output is turned off, commands are read from framed packets and
+ * turned into input events, and
+ * the game's events, the time each turn takes and the state of the
+ * buffers are sent back as packets. Keys and commands both go into the
+ * input queue (input.h), so a host tool can drive the game as a player
+ * at the terminal would, only faster and without having to parse the
+ * screen.
+ */
+
+#ifndef REMOTE_H_
+#define REMOTE_H_
+
+#include <stdint.h>
+
+// Start in text mode and subscribe to the game's events. Call after
+// events_init() and init_serial_stdio().
+void remote_init(void);
+
+// Turn the serial input waiting into keys in the input queue. Called by
+// input_get().
+void remote_poll(void);
+
+// Returns non-zero if there is serial input that may make a key
+uint8_t remote_input_waiting(void);
+
+// Forget keys typed before now. In binary mode commands are kept.
+void remote_clear_input(void);
+
+#endif /* REMOTE_H_ */
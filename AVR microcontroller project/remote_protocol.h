@@ -0,0 +1,71 @@
+/*
+ * remote_protocol.h
+ *
+ * The binary serial protocol (see remote.h), shared with the host tools.
+ * Each packet is framed as described in frame.h. Its first byte is its
+ * type; multi-byte numbers are little endian.
+ *
+ * Commands from the host carry a sequence number after the type, and
+ * each is answered with an ACK carrying the same number. A command with
+ * the same number as the last one run is taken to be that command sent
+ * again after its ACK was lost: it is acknowledged with the same status
+ * but not run again (except REMOTE_CMD_STATUS, which changes nothing), so
+ * the host must number each new command differently. Commands go into
+ * the input queue as events of their own kind, so each does the same
+ * thing whichever screen the game is showing, or nothing where it
+ * doesn't apply (REMOTE_CMD_START and REMOTE_CMD_SET_MODE only act on
+ * the start and game over screens, REMOTE_CMD_MOVE and REMOTE_CMD_FIRE
+ * only during a game). A REMOTE_CMD_FIRE sent while the computer's shot
+ * is still being animated is kept until the shot lands, as a key would
+ * be, so it is only answered REMOTE_BUSY when the input queue is full.
+ * Whatever happens as a result arrives as REMOTE_EVENT packets.
+ *
+ * To start binary mode the host sends a zero then REMOTE_CMD_HELLO, which
+ * is answered with REMOTE_HELLO (or, if binary mode had already started,
+ * an ACK). The ACK of REMOTE_CMD_TEXT is the last packet before the
+ * terminal output comes back.
+ */
+
+#ifndef REMOTE_PROTOCOL_H_
+#define REMOTE_PROTOCOL_H_
+
+#define REMOTE_PROTOCOL_VERSION 2
+
+typedef enum {
+	// Host to board: type, sequence number, then
+	REMOTE_CMD_MOVE = 0x01,		// dx, dy (signed, -7 to 7): move the cursor
+	REMOTE_CMD_FIRE = 0x02,		// -: fire at the cursor
+	REMOTE_CMD_SET_MODE = 0x03,	// mode (GameMode): the computer's mode next game
+	REMOTE_CMD_PAUSE = 0x04,	// -: pause or resume the game
+	REMOTE_CMD_START = 0x05,	// -: leave the start or game over screen
+	REMOTE_CMD_STATUS = 0x06,	// -: send a REMOTE_STATUS packet
+	REMOTE_CMD_ANIMATION = 0x07,// on (0 or 1): play the computer's firing
+								// animation (the default) or land its shots
+								// at once
+	REMOTE_CMD_HELLO = 0x08,	// REMOTE_PROTOCOL_VERSION: start binary mode
+	REMOTE_CMD_TEXT = 0x09,		// -: go back to the text terminal
+	
+	// Board to host
+	REMOTE_HELLO = 0x80,		// REMOTE_PROTOCOL_VERSION: binary mode has started
+	REMOTE_ACK = 0x81,			// sequence number, RemoteStatus
+	REMOTE_BAD_FRAME = 0x82,	// -: a frame failed its CRC or was too long
+	REMOTE_EVENT = 0x83,		// type, player, cell, detail (as Event, events.h)
+	REMOTE_TURN = 0x84,			// microseconds (32 bits) from the human's shot
+								// to the computer's reply landing
+	REMOTE_STATUS = 0x85		// output buffer space, input events queued,
+								// most events queued, then (16 bits each)
+								// output stalls, output bytes dropped, input
+								// overruns and bad frames (serialio.h)
+} RemotePacketType;
+
+typedef enum {
+	REMOTE_OK,
+	REMOTE_BUSY,			// no room for the command yet; send it again
+	REMOTE_BAD_ARGUMENT,
+	REMOTE_UNKNOWN_COMMAND
+} RemoteStatus;
+
+// Largest move REMOTE_CMD_MOVE takes in each direction
+#define REMOTE_MAX_MOVE 7
+
+#endif /* REMOTE_PROTOCOL_H_ */
@@ -0,0 +1,192 @@
+/*
+ * scheduler.c
+ *
+ * Cooperative task scheduler - see scheduler.h
+ */
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include "timer0.h"
+#include "bench_marker.h"
+
+typedef struct {
+	void (*run)(void);
+	// Event tasks only - NULL for a periodic task
+	uint8_t (*ready)(void);
+	// Time between runs of a periodic task, deadline of an event task
+	uint16_t period_ms;
+	uint8_t enabled;
+	// When a periodic task is next due, or when an event task was
+	// last checked
+	uint32_t due;
+	TaskStats stats;
+} Task;
+
+static Task tasks[SCHEDULER_MAX_TASKS];
+static uint8_t num_tasks;
+
+void scheduler_init(void)
+{
+	memset(tasks, 0, sizeof(tasks));
+	num_tasks = 0;
+	set_sleep_mode(SLEEP_MODE_IDLE);
+}
+
+static TaskId add_task(void (*run)(void), uint8_t (*ready)(void), uint16_t period_ms)
+{
+	if (num_tasks >= SCHEDULER_MAX_TASKS)
+	{
+		return -1;
+	}
+	Task* task = &tasks[num_tasks];
+	task->run = run;
+	task->ready = ready;
+	task->period_ms = period_ms;
+	scheduler_enable(num_tasks, 1);
+	return num_tasks++;
+}
+
+TaskId scheduler_add_periodic(void (*task)(void), uint16_t period_ms)
+{
+	return add_task(task, 0, period_ms);
+}
+
+TaskId scheduler_add_event(void (*task)(void), uint8_t (*ready)(void), uint16_t deadline_ms)
+{
+	return add_task(task, ready, deadline_ms);
+}
+
+void scheduler_enable(TaskId id, uint8_t enabled)
+{
+	if (id < 0 || id >= SCHEDULER_MAX_TASKS)
+	{
+		return;
+	}
+	Task* task = &tasks[id];
+	if (enabled && !task->enabled)
+	{
+		task->due = get_current_time();
+		if (!task->ready)
+		{
+			task->due += task->period_ms;
+		}
+	}
+	task->enabled = enabled;
+}
+
+static void run_task(Task* task)
+{
+	uint32_t start = get_current_time_us();
+	task->run();
+	uint32_t runtime = get_current_time_us() - start;
+	
+	task->stats.runs++;
+	if (runtime > task->stats.worst_runtime_us)
+	{
+		task->stats.worst_runtime_us = runtime;
+	}
+}
+
+// Returns non-zero if a task could run now
+static uint8_t work_waiting(void)
+{
+	uint32_t now = get_current_time();
+	for (uint8_t i = 0; i < num_tasks; i++)
+	{
+		Task* task = &tasks[i];
+		if (!task->enabled)
+		{
+			continue;
+		}
+		if (task->ready ? task->ready() : (int32_t)(now - task->due) >= 0)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+void scheduler_run_once(void)
+{
+	for (uint8_t i = 0; i < num_tasks; i++)
+	{
+		Task* task = &tasks[i];
+		if (!task->enabled)
+		{
+			continue;
+		}
+		uint32_t now = get_current_time();
+		if (task->ready)
+		{
+			if (now - task->due > task->period_ms)
+			{
+				task->stats.deadline_misses++;
+			}
+			task->due = now;
+			if (!task->ready())
+			{
+				continue;
+			}
+		} else
+		{
+			if ((int32_t)(now - task->due) < 0)
+			{
+				continue;
+			}
+			if (now - task->due >= task->period_ms)
+			{
+				// A whole period late - skip the runs we have missed
+				task->stats.deadline_misses++;
+				task->due = now;
+			}
+			task->due += task->period_ms;
+		}
+		run_task(task);
+	}
+	
+	scheduler_sleep_unless(work_waiting);
+}
+
+void scheduler_sleep_unless(uint8_t (*waiting)(void))
+{
+	// Interrupts are turned off while we check for work so that one
+	// arriving between the check and the sleep still wakes us (the
+	// instruction after sei() always runs).
+	cli();
+	if (!waiting())
+	{
+		BENCH_MARK(BENCH_SLEEP);
+		sleep_enable();
+		sei();
+		sleep_cpu();
+		sleep_disable();
+		BENCH_MARK(BENCH_WAKE);
+	}
+	sei();
+}
+
+const TaskStats* scheduler_task_stats(TaskId id)
+{
+	if (id < 0 || id >= num_tasks)
+	{
+		return 0;
+	}
+	return &tasks[id].stats;
+}
+
+uint8_t scheduler_num_tasks(void)
+{
+	return num_tasks;
+}
+
+void scheduler_reset_stats(void)
+{
+	for (uint8_t i = 0; i < num_tasks; i++)
+	{
+		memset(&tasks[i].stats, 0, sizeof(TaskStats));
+	}
+}
@@ -0,0 +1,62 @@
+/*
+ * scheduler.h
+ *
+ * A small cooperative scheduler built on the timer 0 millisecond tick.
+ * Periodic tasks run every so many milliseconds; event tasks run whenever
+ * their ready function says there is something for them to do. Tasks run
+ * one at a time, in the order they were added, and must return quickly.
+ * When nothing is ready the CPU sleeps (idle mode) until the next
+ * interrupt - at the latest the next tick.
+ *
+ * For each task we keep the number of runs, the longest run and the
+ * number of deadline misses. A periodic task misses its deadline when it
+ * starts a whole period or more late (so at least one run was lost); an
+ * event task misses its deadline when more than its deadline passes
+ * between checks of its ready function.
+ */
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include <stdint.h>
+
+#define SCHEDULER_MAX_TASKS 8
+
+typedef int8_t TaskId;
+
+typedef struct {
+	uint32_t runs;
+	uint32_t worst_runtime_us;
+	uint16_t deadline_misses;
+} TaskStats;
+
+// Remove all tasks. Requires timer 0 to have been set up.
+void scheduler_init(void);
+
+// Add a task that runs every period_ms milliseconds, first period_ms
+// from now. Returns the task's id, or -1 if there is no room.
+TaskId scheduler_add_periodic(void (*task)(void), uint16_t period_ms);
+
+// Add a task that runs whenever ready() returns non-zero. ready() must be
+// quick and must not change anything. Returns the task's id, or -1 if
+// there is no room.
+TaskId scheduler_add_event(void (*task)(void), uint8_t (*ready)(void), uint16_t deadline_ms);
+
+// Stop running a task or start running it again. A periodic task next
+// runs a whole period after it is enabled.
+void scheduler_enable(TaskId id, uint8_t enabled);
+
+// Run every task that is due or ready, then sleep until the next
+// interrupt if there is nothing more to do.
+void scheduler_run_once(void);
+
+// Sleep until the next interrupt unless waiting() says there is work,
+// for loops that poll outside the scheduler
+void scheduler_sleep_unless(uint8_t (*waiting)(void));
+
+// Statistics for a task, and the number of tasks added
+const TaskStats* scheduler_task_stats(TaskId id);
+uint8_t scheduler_num_tasks(void);
+void scheduler_reset_stats(void);
+
+#endif /* SCHEDULER_H_ */
@@ -0,0 +1,464 @@
+/*
+ * screen.c
+ *
+ * Shadow copy of the serial terminal's text - see screen.h
+ */
+
+#include "screen.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <avr/pgmspace.h>
+#include "terminalio.h"
+#include "serialio.h"
+
+// Columns the terminal has before it wraps
+#define TERMINAL_WIDTH 80
+
+// Not known: whatever is on the terminal there must be overwritten
+#define UNKNOWN 0
+
+// The most bytes a cursor movement takes
+#define MOVE_MAX 10
+
+// lines[i] holds row rows[i] (0 if unused). dirty has a bit for each
+// column written since the last flush. The line written longest ago is
+// the one reused.
+static char lines[SCREEN_LINES][SCREEN_WIDTH];
+static uint8_t dirty[SCREEN_LINES][SCREEN_WIDTH / 8];
+static uint8_t rows[SCREEN_LINES];
+static uint8_t last_used[SCREEN_LINES];
+static uint8_t use_count;
+static uint8_t any_dirty;
+
+// Rows (below 64) written to since the terminal was cleared. The rest are
+// still blank.
+static uint64_t written_rows;
+
+// Where the terminal's cursor is; row 0 if we don't know
+static uint8_t cursor_row;
+static uint8_t cursor_column;
+
+static uint32_t bytes_sent;
+static uint32_t bytes_unbuffered;
+
+// Texts too wide for a line's copy, sent from screen_flush() as the UART
+// has room for them. The first is being sent; pending_column is the
+// column its next character goes in (0 before it has started).
+typedef struct {
+	uint8_t x;
+	uint8_t y;
+	uint8_t id;
+} PendingText;
+
+static PendingText pending[SCREEN_PENDING];
+static uint8_t pending_first;
+static uint8_t pending_count;
+static uint8_t pending_column;
+static TextReader pending_reader;
+
+static void put(char c)
+{
+	putchar(c);
+	bytes_sent++;
+}
+
+static uint8_t digits(uint8_t n)
+{
+	return n < 10 ? 1 : n < 100 ? 2 : 3;
+}
+
+static void put_number(uint8_t n)
+{
+	bytes_sent += terminal_put_number(n);
+}
+
+// ESC [ n command, with n left out when it is 1
+static void put_escape(uint8_t n, char command)
+{
+	put('\x1b');
+	put('[');
+	if (n != 1)
+	{
+		put_number(n);
+	}
+	put(command);
+}
+
+// Bytes to move the cursor by n in one direction with put_escape()
+static uint8_t relative_cost(uint8_t n)
+{
+	return n == 0 ? 0 : n == 1 ? 3 : 3 + digits(n);
+}
+
+static uint8_t absolute_cost(uint8_t row, uint8_t column)
+{
+	return column == 1 ? 3 + digits(row) : 4 + digits(row) + digits(column);
+}
+
+static void put_relative(uint8_t from, uint8_t to, char forward, char back)
+{
+	if (to > from)
+	{
+		put_escape(to - from, forward);
+	} else if (to < from)
+	{
+		put_escape(from - to, back);
+	}
+}
+
+// Returns non-zero if what the terminal shows from column from up to
+// (not including) column to is known from the row's copy, line, so the
+// cursor can be moved right by sending those characters again
+static uint8_t known_between(const char* line, uint8_t from, uint8_t to)
+{
+	if (!line || to > SCREEN_WIDTH + 1)
+	{
+		return 0;
+	}
+	for (uint8_t c = from; c < to; c++)
+	{
+		if (line[c - 1] == UNKNOWN)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+// Move the cursor to (column, row) in as few bytes as we can. line is the
+// copy of the row, if there is one.
+static void move_to(uint8_t column, uint8_t row, const char* line)
+{
+	if (cursor_row == row && cursor_column == column)
+	{
+		return;
+	}
+	uint8_t best = absolute_cost(row, column);
+	enum { ABSOLUTE, RELATIVE, RETURN, RESEND } how = ABSOLUTE;
+	if (cursor_row)
+	{
+		uint8_t vertical = relative_cost(cursor_row > row ? cursor_row - row : row - cursor_row);
+		uint8_t cost = vertical + relative_cost(cursor_column > column ?
+				cursor_column - column : column - cursor_column);
+		if (cost < best)
+		{
+			best = cost;
+			how = RELATIVE;
+		}
+		cost = vertical + 1 + relative_cost(column - 1);
+		if (cost < best)
+		{
+			best = cost;
+			how = RETURN;
+		}
+		if (cursor_row == row && column > cursor_column && column - cursor_column < best
+				&& known_between(line, cursor_column, column))
+		{
+			how = RESEND;
+		}
+	}
+	switch (how)
+	{
+		case ABSOLUTE:
+			put('\x1b');
+			put('[');
+			put_number(row);
+			if (column != 1)
+			{
+				put(';');
+				put_number(column);
+			}
+			put('H');
+			break;
+		case RELATIVE:
+			put_relative(cursor_row, row, 'B', 'A');
+			put_relative(cursor_column, column, 'C', 'D');
+			break;
+		case RETURN:
+			put_relative(cursor_row, row, 'B', 'A');
+			put('\r');
+			put_relative(1, column, 'C', 'D');
+			break;
+		case RESEND:
+			for (uint8_t c = cursor_column; c < column; c++)
+			{
+				put(line[c - 1]);
+			}
+			break;
+	}
+	cursor_row = row;
+	cursor_column = column;
+}
+
+static uint8_t row_written(uint8_t row)
+{
+	return row >= 64 || (written_rows & ((uint64_t)1 << row));
+}
+
+// The copy of row, or -1 if there isn't one
+static int8_t find_line(uint8_t row)
+{
+	for (uint8_t i = 0; i < SCREEN_LINES; i++)
+	{
+		if (rows[i] == row)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+// The copy of row, reusing the least recently written line if there isn't
+// one yet
+static uint8_t get_line(uint8_t row)
+{
+	int8_t found = find_line(row);
+	if (found >= 0)
+	{
+		last_used[found] = ++use_count;
+		return found;
+	}
+	uint8_t oldest = 0;
+	for (uint8_t i = 1; i < SCREEN_LINES; i++)
+	{
+		if ((uint8_t)(use_count - last_used[i]) > (uint8_t)(use_count - last_used[oldest]))
+		{
+			oldest = i;
+		}
+	}
+	// Changes waiting in the line being reused are sent first
+	if (any_dirty)
+	{
+		screen_flush();
+	}
+	memset(lines[oldest], row_written(row) ? UNKNOWN : ' ', SCREEN_WIDTH);
+	rows[oldest] = row;
+	last_used[oldest] = ++use_count;
+	written_rows |= row < 64 ? (uint64_t)1 << row : 0;
+	return oldest;
+}
+
+// If the cursor has gone past the edge of the terminal it may have
+// wrapped
+static void check_wrap(void)
+{
+	if (cursor_column > TERMINAL_WIDTH)
+	{
+		cursor_row = 0;
+	}
+}
+
+// Send the pending texts, or as much of them as the UART has room for
+// unless block is non-zero
+static void send_pending(uint8_t block)
+{
+	while (pending_count)
+	{
+		const PendingText* text = &pending[pending_first];
+		if (!pending_column)
+		{
+			text_open(&pending_reader, text->id);
+			pending_column = text->x ? text->x : 1;
+		}
+		int8_t line = find_line(text->y);
+		for (;;)
+		{
+			if (!block && serial_output_space() <= MOVE_MAX)
+			{
+				// Out of room; carry on next time
+				check_wrap();
+				return;
+			}
+			char c = text_read(&pending_reader);
+			if (!c)
+			{
+				break;
+			}
+			move_to(pending_column, text->y, NULL);
+			if (line >= 0 && pending_column <= SCREEN_WIDTH)
+			{
+				lines[line][pending_column - 1] = c;
+			}
+			put(c);
+			cursor_column = ++pending_column;
+		}
+		check_wrap();
+		pending_column = 0;
+		pending_first = (pending_first + 1) % SCREEN_PENDING;
+		pending_count--;
+	}
+}
+
+// Everything else goes through here. next() gives each character in turn.
+static uint8_t write_text(uint8_t x, uint8_t y, uint8_t length, char (*next)(void))
+{
+	uint8_t column = x ? x : 1;
+	// What the old path would have sent: an escape with x and y in
+	// decimal, then the text
+	bytes_unbuffered += 4 + digits(y) + digits(x) + length;
+	if (y == 0 || length == 0)
+	{
+		return column;
+	}
+	
+	// Pending text on the row goes first
+	for (uint8_t i = 0; i < pending_count; i++)
+	{
+		if (pending[(pending_first + i) % SCREEN_PENDING].y == y)
+		{
+			send_pending(1);
+			break;
+		}
+	}
+	
+	if (column + length - 1 > SCREEN_WIDTH)
+	{
+		// Doesn't fit in a line's copy: send it now, after everything
+		// that is waiting
+		screen_flush();
+		send_pending(1);
+		int8_t line = find_line(y);
+		move_to(column, y, NULL);
+		for (uint8_t i = 0; i < length; i++)
+		{
+			char c = next();
+			if (line >= 0 && column + i <= SCREEN_WIDTH)
+			{
+				lines[line][column + i - 1] = c;
+			}
+			put(c);
+		}
+		written_rows |= y < 64 ? (uint64_t)1 << y : 0;
+		cursor_column = column + length;
+		check_wrap();
+		return column + length;
+	}
+	uint8_t line = get_line(y);
+	for (uint8_t i = 0; i < length; i++)
+	{
+		uint8_t c = column + i - 1;
+		char ch = next();
+		if (lines[line][c] != ch)
+		{
+			lines[line][c] = ch;
+			dirty[line][c / 8] |= 1 << (c % 8);
+			any_dirty = 1;
+		}
+	}
+	return column + length;
+}
+
+// Sources of characters for write_text()
+static const char* text_source;
+static char fill_character;
+
+static char next_from_ram(void)
+{
+	return *text_source++;
+}
+
+static char next_from_flash(void)
+{
+	return pgm_read_byte(text_source++);
+}
+
+static char next_fill(void)
+{
+	return fill_character;
+}
+
+static TextReader text_reader;
+
+static char next_from_text(void)
+{
+	return text_read(&text_reader);
+}
+
+uint8_t screen_write(uint8_t x, uint8_t y, const char* text)
+{
+	text_source = text;
+	return write_text(x, y, strlen(text), next_from_ram);
+}
+
+uint8_t screen_write_P(uint8_t x, uint8_t y, const char* text)
+{
+	text_source = text;
+	return write_text(x, y, strlen_P(text), next_from_flash);
+}
+
+uint8_t screen_write_text(uint8_t x, uint8_t y, TextId id)
+{
+	uint8_t column = x ? x : 1;
+	uint8_t length = text_length(id);
+	if (y == 0 || column + length - 1 <= SCREEN_WIDTH)
+	{
+		text_open(&text_reader, id);
+		return write_text(x, y, length, next_from_text);
+	}
+	
+	// Too wide for a line's copy: queue it
+	bytes_unbuffered += 4 + digits(y) + digits(x) + length;
+	if (pending_count == SCREEN_PENDING)
+	{
+		send_pending(1);
+	}
+	PendingText* text = &pending[(pending_first + pending_count) % SCREEN_PENDING];
+	text->x = x;
+	text->y = y;
+	text->id = id;
+	pending_count++;
+	written_rows |= y < 64 ? (uint64_t)1 << y : 0;
+	return column + length;
+}
+
+uint8_t screen_fill(uint8_t x, uint8_t y, uint8_t length, char c)
+{
+	fill_character = c;
+	return write_text(x, y, length, next_fill);
+}
+
+void screen_clear(void)
+{
+	clear_terminal();
+	bytes_sent += 4;
+	bytes_unbuffered += 4;
+	memset(rows, 0, sizeof(rows));
+	memset(dirty, 0, sizeof(dirty));
+	any_dirty = 0;
+	pending_count = 0;
+	pending_column = 0;
+	written_rows = 0;
+	// Clearing leaves the cursor where it was, which we may not know
+	cursor_row = 0;
+}
+
+void screen_flush(void)
+{
+	for (uint8_t i = 0; any_dirty && i < SCREEN_LINES; i++)
+	{
+		for (uint8_t c = 0; c < SCREEN_WIDTH; c++)
+		{
+			if (!(dirty[i][c / 8] & (1 << (c % 8))))
+			{
+				continue;
+			}
+			dirty[i][c / 8] &= ~(1 << (c % 8));
+			move_to(c + 1, rows[i], lines[i]);
+			put(lines[i][c]);
+			cursor_column++;
+		}
+	}
+	any_dirty = 0;
+	send_pending(0);
+}
+
+uint32_t screen_bytes_sent(void)
+{
+	return bytes_sent;
+}
+
+int32_t screen_bytes_saved(void)
+{
+	return bytes_unbuffered - bytes_sent;
+}
@@ -0,0 +1,58 @@
+/*
+ * screen.h
+ *
+ * Shadow copy of the serial terminal's text. Text written with the
+ * functions below goes into a copy of the lines it lands on; nothing is
+ * sent until screen_flush(), which sends only the characters that differ
+ * from what the terminal already shows, moving the cursor between them
+ * with whichever escape sequence (or run of unchanged characters) is
+ * shortest. Writing a line that is already on the screen costs nothing.
+ *
+ * There isn't the RAM for a copy of the whole screen, so only the
+ * SCREEN_LINES most recently written lines are kept, each SCREEN_WIDTH
+ * columns wide. Text that doesn't fit is sent straight away, after any
+ * pending changes - except for compressed texts (text.h), which are
+ * queued and sent by screen_flush() a little at a time, as the UART's
+ * output buffer has room, so the start screen's banner doesn't hold up
+ * the main loop.
+ *
+ * Coordinates are as for move_terminal_cursor(): x is the column and y
+ * the row, both starting from 1 (column 0 is treated as column 1).
+ */
+
+#ifndef SCREEN_H_
+#define SCREEN_H_
+
+#include <stdint.h>
+#include "text.h"
+
+#define SCREEN_LINES 2
+// Must be a multiple of 8. Wide enough for the message line.
+#define SCREEN_WIDTH 48
+// Compressed texts that can wait to be sent
+#define SCREEN_PENDING 12
+
+// Clear the terminal. The whole screen is then known to be blank.
+void screen_clear(void);
+
+// Write a string from RAM or from flash (PSTR) at (x, y). Returns the
+// column after the end of the text, to carry on writing from.
+uint8_t screen_write(uint8_t x, uint8_t y, const char* text);
+uint8_t screen_write_P(uint8_t x, uint8_t y, const char* text);
+
+// Write one of the compressed texts. Returns the column after it.
+uint8_t screen_write_text(uint8_t x, uint8_t y, TextId id);
+
+// Write length copies of c at (x, y), e.g. spaces to clear a message
+uint8_t screen_fill(uint8_t x, uint8_t y, uint8_t length, char c);
+
+// Send the changes made since the last flush
+void screen_flush(void);
+
+// UART bytes sent for the screen, and the number saved compared to
+// sending every write straight away with move_terminal_cursor() and
+// printf()
+uint32_t screen_bytes_sent(void);
+int32_t screen_bytes_saved(void);
+
+#endif /* SCREEN_H_ */
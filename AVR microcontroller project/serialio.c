@@ -9,9 +9,11 @@
  * and a circular buffer to store output messages. (This allows us 
  * to print many characters at once to the buffer and have them 
  * output by the UART as speed permits.) If the buffer fills up, the
- * put method will either
- * (1) if interrupts are enabled, block until there is room in it, or
- * (2) if interrupts are disabled, will discard the character.
+ * put method will, depending on the policy set with
+ * serial_set_full_policy(), either
+ * (1) block until there is room in it (if interrupts are enabled),
+ * (2) discard the character, or
+ * (3) discard the oldest character waiting to be output.
  * Input is blocking - requesting input from stdin will block
  * until a character is available. If interrupts are disabled when 
  * input is sought, then this will block forever.
@@ -23,37 +25,47 @@
 #include "serialio.h"
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include "timer0.h"
 
 /* System clock rate in Hz. (L at the end indicates this is a long constant) */
 #define SYSCLK 8000000L
 
+#if (SERIAL_OUTPUT_BUFFER_SIZE & (SERIAL_OUTPUT_BUFFER_SIZE - 1)) || SERIAL_OUTPUT_BUFFER_SIZE > 128
+#error "SERIAL_OUTPUT_BUFFER_SIZE must be a power of two no larger than 128"
+#endif
+#if (SERIAL_INPUT_BUFFER_SIZE & (SERIAL_INPUT_BUFFER_SIZE - 1)) || SERIAL_INPUT_BUFFER_SIZE > 128
+#error "SERIAL_INPUT_BUFFER_SIZE must be a power of two no larger than 128"
+#endif
+
 /* Global variables */
-/* Circular buffer to hold outgoing characters. The insert_pos variable
- * keeps track of the position (0 to OUTPUT_BUFFER_SIZE-1) that the next
- * outgoing character should be written to. bytes_in_buffer keeps
- * count of the number of characters currently stored in the buffer 
- * (ranging from 0 to OUTPUT_BUFFER_SIZE). This number of bytes immediately
- * prior to the current insert_pos are the bytes waiting to be output.
- * If the insert_pos reaches the end of the buffer it will wrap around
- * to the beginning (assuming those bytes have been output).
- * NOTE - OUTPUT_BUFFER_SIZE can not be larger than 255 without changing
- * the type of the variables below (currently defined as 8 bit unsigned ints).
+/* Circular buffers for outgoing and incoming characters. Each has one
+ * writer and one reader: the head is only changed by the code putting
+ * characters in and the tail only by the code taking them out, so
+ * neither needs interrupts disabled. The indices run freely from 0 to
+ * 255 and are masked to index the buffer, so head - tail (in 8 bits) is
+ * the number of characters waiting, and a full buffer (size waiting)
+ * can't be mistaken for an empty one as long as the size is at most 128.
  */
-#define OUTPUT_BUFFER_SIZE 255
-volatile char out_buffer[OUTPUT_BUFFER_SIZE];
-volatile uint8_t out_insert_pos;
-volatile uint8_t bytes_in_out_buffer;
+#define OUTPUT_MASK (SERIAL_OUTPUT_BUFFER_SIZE - 1)
+static volatile char out_buffer[SERIAL_OUTPUT_BUFFER_SIZE];
+static volatile uint8_t out_head;
+static volatile uint8_t out_tail;
 
-/* Circular buffer to hold incoming characters. Works on same principle
- * as output buffer
+#define INPUT_MASK (SERIAL_INPUT_BUFFER_SIZE - 1)
+static volatile char input_buffer[SERIAL_INPUT_BUFFER_SIZE];
+static volatile uint8_t input_head;
+static volatile uint8_t input_tail;
+/* When each input character arrived, so that the time it spent waiting
+ * here counts towards how long the player waited for it
  */
-#define INPUT_BUFFER_SIZE 16
-volatile char input_buffer[INPUT_BUFFER_SIZE];
-volatile uint8_t input_insert_pos;
-volatile uint8_t bytes_in_input_buffer;
-volatile uint8_t input_overrun;
+static volatile uint16_t input_time[SERIAL_INPUT_BUFFER_SIZE];
+
+static SerialFullPolicy full_policy;
+static SerialStats stats;
+static uint8_t text_output;
 
 /* Variable to keep track of whether incoming characters are to be echoed
  * back or not.
@@ -65,6 +77,7 @@ static int8_t do_echo;
 void init_serial_stdio(long baudrate, int8_t echo);
 static int uart_put_char(char, FILE*);
 static int uart_get_char(FILE*);
+static int output_byte(char);
 
 /* Setup a stream that uses the uart get and put functions. We will
  * make standard input and output use this stream below.
@@ -74,15 +87,15 @@ static FILE myStream = FDEV_SETUP_STREAM(uart_put_char, uart_get_char,
 
 void init_serial_stdio(long baudrate, int8_t echo)
 {
-	uint16_t ubrr;
+	uint16_t ubrr, ubrr_double;
 	/*
 	 * Initialise our buffers
 	*/
-	out_insert_pos = 0;
-	bytes_in_out_buffer = 0;
-	input_insert_pos = 0;
-	bytes_in_input_buffer = 0;
-	input_overrun = 0;
+	out_head = out_tail = 0;
+	input_head = input_tail = 0;
+	full_policy = SERIAL_FULL_BLOCK;
+	stats = (SerialStats){0};
+	text_output = 1;
 	
 	/*
 	 * Record whether we're going to echo characters or not
@@ -93,9 +106,23 @@ void init_serial_stdio(long baudrate, int8_t echo)
 	/* (This differs from the datasheet formula so that we get 
 	 * rounding to the nearest integer while using integer division
 	 * (which truncates)).
+	 * Double speed (U2X) halves the divider, which can get closer to
+	 * faster baud rates: at 8MHz 57600 baud is 3.5% out at normal speed
+	 * but 2.1% at double speed. Normal speed is kept when they are
+	 * equally close, as the receiver is more tolerant of error at it.
 	*/
 	ubrr = (((SYSCLK / (8 * baudrate)) + 1) / 2) - 1;
-	UBRR0 = ubrr;
+	ubrr_double = (((SYSCLK / (4 * baudrate)) + 1) / 2) - 1;
+	if (labs(SYSCLK / (8L * (ubrr_double + 1)) - baudrate)
+			< labs(SYSCLK / (16L * (ubrr + 1)) - baudrate))
+	{
+		UCSR0A |= (1 << U2X0);
+		UBRR0 = ubrr_double;
+	} else
+	{
+		UCSR0A &= ~(1 << U2X0);
+		UBRR0 = ubrr;
+	}
 	
 	/*
 	 * Enable transmission and receiving via UART. We don't enable
@@ -121,109 +148,186 @@ void init_serial_stdio(long baudrate, int8_t echo)
 
 int8_t serial_input_available(void)
 {
-	return bytes_in_input_buffer != 0;
+	return input_head != input_tail;
+}
+
+uint8_t serial_output_space(void)
+{
+	return SERIAL_OUTPUT_BUFFER_SIZE - (uint8_t)(out_head - out_tail);
+}
+
+void serial_set_text_output(uint8_t enabled)
+{
+	text_output = enabled;
+}
+
+void serial_set_full_policy(SerialFullPolicy policy)
+{
+	full_policy = policy;
+}
+
+SerialStats serial_stats(void)
+{
+	/* rx_overruns is counted by the receive interrupt */
+	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	SerialStats copy = stats;
+	if (interrupts_enabled)
+	{
+		sei();
+	}
+	return copy;
 }
 
 void clear_serial_input_buffer(void)
 {
 	/* Just adjust our buffer data so it looks empty */
-	input_insert_pos = 0;
-	bytes_in_input_buffer = 0;
+	input_tail = input_head;
+}
+
+static uint8_t output_full(void)
+{
+	return (uint8_t)(out_head - out_tail) == SERIAL_OUTPUT_BUFFER_SIZE;
+}
+
+/* Add a character to the output buffer, which must have room, and make
+ * sure the UDR empty interrupt is enabled to send it.
+ */
+static void output_insert(char c)
+{
+	out_buffer[out_head & OUTPUT_MASK] = c;
+	out_head++;
+	UCSR0B |= (1 << UDRIE0);
 }
 
 static int uart_put_char(char c, FILE* stream)
 {
-	uint8_t interrupts_enabled;
+	if (!text_output)
+	{
+		return 0;
+	}
 	
-	/* Add the character to the buffer for transmission (if there 
-	 * is space to do so). If not we wait until the buffer has space.
-	 * If the character is \n, we output \r (carriage return)
+	/* If the character is \n, we output \r (carriage return)
 	 * also.
 	*/
 	if (c == '\n')
 	{
-		uart_put_char('\r', stream);
+		output_byte('\r');
 	}
+	return output_byte(c);
+}
+
+void serial_put_byte(uint8_t byte)
+{
+	(void)output_byte(byte);
+}
+
+/* Add a character to the output buffer, following the full policy.
+ * Returns non-zero if it was discarded.
+ */
+static int output_byte(char c)
+{
+	uint8_t interrupts_enabled;
 	
-	/* If the buffer is full and interrupts are disabled then we
-	 * abort - we don't output the character since the buffer will
-	 * never be emptied if interrupts are disabled. If the buffer is full
-	 * and interrupts are enabled then we loop until the buffer has 
-	 * enough space. The bytes_in_buffer variable will get modified by the
-	 * ISR which extracts bytes from the buffer.
+	/* If the buffer is full, follow the policy. The buffer will never
+	 * be emptied if interrupts are disabled, so we can only wait if
+	 * they are enabled. out_tail gets advanced by the ISR which
+	 * extracts bytes from the buffer.
 	*/
 	interrupts_enabled = bit_is_set(SREG, SREG_I);
-	while (bytes_in_out_buffer >= OUTPUT_BUFFER_SIZE)
+	if (output_full())
 	{
-		if (!interrupts_enabled)
+		if (full_policy == SERIAL_FULL_BLOCK && interrupts_enabled)
+		{
+			stats.tx_stalls++;
+			while (output_full())
+			{
+				/* do nothing */
+			}
+		} else if (full_policy == SERIAL_FULL_DROP_OLDEST)
+		{
+			/* The tail belongs to the ISR, so mask the UDR empty
+			 * interrupt while we move it on. output_insert()
+			 * reenables it. */
+			UCSR0B &= ~(1 << UDRIE0);
+			if (output_full())
+			{
+				out_tail++;
+				stats.tx_dropped++;
+			}
+		} else
 		{
+			stats.tx_dropped++;
 			return 1;
-		}		
-		/* else do nothing */
+		}
 	}
 	
-	/* Add the character to the buffer for transmission if there
-	 * is space to do so. We advance the insert_pos to the next
-	 * character position. If this is beyond the end of the buffer
-	 * we wrap around back to the beginning of the buffer 
-	 * NOTE: we disable interrupts before modifying the buffer. This
-	 * prevents the ISR from modifying the buffer at the same time.
+	/* With echo on, the receive interrupt also adds characters, so
+	 * then (only) we disable interrupts while adding ours, and check
+	 * again that an echoed character hasn't taken the last space.
 	 * We reenable them if they were enabled when we entered the
 	 * function.
-	*/	
-	cli();
-	out_buffer[out_insert_pos++] = c;
-	bytes_in_out_buffer++;
-	if (out_insert_pos == OUTPUT_BUFFER_SIZE)
+	*/
+	if (do_echo)
+	{
+		cli();
+		if (output_full())
+		{
+			stats.tx_dropped++;
+		} else
+		{
+			output_insert(c);
+		}
+		if (interrupts_enabled)
+		{
+			sei();
+		}
+	} else
 	{
-		/* Wrap around buffer pointer if necessary */
-		out_insert_pos = 0;
+		output_insert(c);
 	}
-	/* Reenable interrupts (UDR Empty interrupt may have been
-	 * disabled) - we ensure it is now enabled so that it will
-	 * fire and deal with the next character in the buffer. */
-	UCSR0B |= (1 << UDRIE0);
+	return 0;
+}
+
+uint16_t serial_input_time(void)
+{
+	/* Read with interrupts off, as it is two bytes */
+	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	uint16_t time = input_time[input_tail & INPUT_MASK];
 	if (interrupts_enabled)
 	{
 		sei();
 	}
-	return 0;
+	return time;
 }
 
-int uart_get_char(FILE* stream)
+uint8_t serial_get_byte(void)
 {
 	/* Wait until we've received a character */
-	while (bytes_in_input_buffer == 0)
+	while (input_head == input_tail)
 	{
 		/* do nothing */
 	}
 	
-	/*
-	 * Turn interrupts off and remove a character from the input
-	 * buffer. We reenable interrupts if they were on.
-	 * The pending character is the one which is byte_in_input_buffer
-	 * characters before the insert position (taking into account
-	 * that we may need to wrap around).
+	/* Take the oldest character. Only the receive interrupt moves the
+	 * head, so interrupts can stay on.
 	 */
-	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
-	cli();
-	char c;
-	if (input_insert_pos - bytes_in_input_buffer < 0)
-	{
-		/* Need to wrap around */
-		c = input_buffer[input_insert_pos - bytes_in_input_buffer
-				+ INPUT_BUFFER_SIZE];
-	} else
+	uint8_t c = input_buffer[input_tail & INPUT_MASK];
+	input_tail++;
+	return c;
+}
+
+int uart_get_char(FILE* stream)
+{
+	/* If the character is a carriage return, turn it into a
+	 * linefeed 
+	*/
+	char c = serial_get_byte();
+	if (c == '\r')
 	{
-		c = input_buffer[input_insert_pos - bytes_in_input_buffer];
+		c = '\n';
 	}
-	
-	/* Decrement our count of bytes in the input buffer */
-	bytes_in_input_buffer--;
-	if (interrupts_enabled)
-	{
-		sei();
-	}	
 	return c;
 }
 
@@ -234,31 +338,13 @@ int uart_get_char(FILE* stream)
 ISR(USART0_UDRE_vect) 
 {
 	/* Check if we have data in our buffer */
-	if (bytes_in_out_buffer > 0)
+	if (out_head != out_tail)
 	{
-		/* Yes we do - remove the pending byte and output it
-		 * via the UART. The pending byte (character) is the
-		 * one which is "bytes_in_buffer" characters before the 
-		 * insert_pos (taking into account that we may 
-		 * need to wrap around to the end of the buffer).
-		 */
-		char c;
-		if (out_insert_pos - bytes_in_out_buffer < 0)
-		{
-			/* Need to wrap around */
-			c = out_buffer[out_insert_pos - bytes_in_out_buffer
-				+ OUTPUT_BUFFER_SIZE];
-		} else
-		{
-			c = out_buffer[out_insert_pos - bytes_in_out_buffer];
-		}
-		/* Decrement our count of the number of bytes in the 
-		 * buffer 
+		/* Yes we do - remove the oldest byte and output it
+		 * via the UART.
 		 */
-		bytes_in_out_buffer--;
-		
-		/* Output the character via the UART */
-		UDR0 = c;
+		UDR0 = out_buffer[out_tail & OUTPUT_MASK];
+		out_tail++;
 	} else
 	{
 		/* No data in the buffer. We disable the UART Data
@@ -279,48 +365,40 @@ ISR(USART0_UDRE_vect)
 
 ISR(USART0_RX_vect) 
 {
-	/* Read the character - we ignore the possibility of overrun. */
+	/* Check for a hardware overrun (a character that arrived before
+	 * the last one was read) before reading UDR0 clears the flag.
+	 */
+	if (UCSR0A & (1 << DOR0))
+	{
+		stats.rx_overruns++;
+	}
 	char c;
 	c = UDR0;
 		
-	if (do_echo && bytes_in_out_buffer < OUTPUT_BUFFER_SIZE)
+	if (do_echo && !output_full())
 	{
 		/* If echoing is enabled and there is output buffer
 		 * space, echo the received character back to the UART.
 		 * (If there is no output buffer space, characters
 		 * will be lost.)
 		 */
-		uart_put_char(c, 0);
+		output_insert(c);
 	}
 	
 	/* 
-	 * Check if we have space in our buffer. If not, set the overrun
-	 * flag and throw away the character. (We never clear the 
-	 * overrun flag - it's up to the programmer to check/clear
-	 * this flag if desired.)
+	 * Check if we have space in our buffer. If not, count the
+	 * overrun and throw away the character.
 	 */
-	if (bytes_in_input_buffer >= INPUT_BUFFER_SIZE)
+	if ((uint8_t)(input_head - input_tail) == SERIAL_INPUT_BUFFER_SIZE)
 	{
-		input_overrun = 1;
+		stats.rx_overruns++;
 	} else
 	{
-		/* If the character is a carriage return, turn it into a
-		 * linefeed 
-		*/
-		if (c == '\r')
-		{
-			c = '\n';
-		}
-		
 		/* 
 		 * There is room in the input buffer 
 		 */
-		input_buffer[input_insert_pos++] = c;
-		bytes_in_input_buffer++;
-		if (input_insert_pos == INPUT_BUFFER_SIZE)
-		{
-			/* Wrap around buffer pointer if necessary */
-			input_insert_pos = 0;
-		}
+		input_buffer[input_head & INPUT_MASK] = c;
+		input_time[input_head & INPUT_MASK] = get_current_time();
+		input_head++;
 	}
 }
@@ -18,10 +18,39 @@
 
 #include <stdint.h>
 
+/* Buffer sizes, which can be set with -D. Each must be a power of two
+ * no larger than 128.
+ */
+#ifndef SERIAL_OUTPUT_BUFFER_SIZE
+#define SERIAL_OUTPUT_BUFFER_SIZE 64
+#endif
+#ifndef SERIAL_INPUT_BUFFER_SIZE
+#define SERIAL_INPUT_BUFFER_SIZE 16
+#endif
+
+/* What output does when the output buffer is full */
+typedef enum {
+	SERIAL_FULL_BLOCK,		/* wait for room (the default) */
+	SERIAL_FULL_DROP,		/* discard the new character */
+	SERIAL_FULL_DROP_OLDEST	/* discard the oldest waiting character */
+} SerialFullPolicy;
+
+typedef struct {
+	/* Characters output that had to wait for room */
+	uint16_t tx_stalls;
+	/* Characters discarded by the full policy */
+	uint16_t tx_dropped;
+	/* Characters lost on input, because the input buffer was full or
+	 * the UART overran
+	 */
+	uint16_t rx_overruns;
+} SerialStats;
+
 /* Initialise serial IO using the UART. baudrate specifies the desired
  * baud rate (e.g. 19200) and echo determines whether incoming characters
  * are echoed back to the UART output as they are received (zero means no
- * echo, non-zero means echo)
+ * echo, non-zero means echo). The UART runs at double speed (U2X) if that
+ * gets closer to the baud rate, as it does from 57600 up.
  */
 void init_serial_stdio(long baudrate, int8_t echo);
 
@@ -31,6 +60,38 @@ void init_serial_stdio(long baudrate, int8_t echo);
  */
 int8_t serial_input_available(void);
 
+/* Return the number of characters that can be output without waiting
+ * for room in the output buffer.
+ */
+uint8_t serial_output_space(void);
+
+/* Read a byte from the serial port as it was received (standard input
+ * turns carriage returns into linefeeds), waiting for one if necessary.
+ */
+uint8_t serial_get_byte(void);
+
+/* The low 16 bits of get_current_time() when the next byte to be read
+ * arrived. Only meaningful if serial_input_available().
+ */
+uint16_t serial_input_time(void);
+
+/* Output a byte as it is, bypassing standard output */
+void serial_put_byte(uint8_t byte);
+
+/* Turn standard output on or off. While it is off, characters written
+ * to it are discarded, so that only serial_put_byte() reaches the UART.
+ */
+void serial_set_text_output(uint8_t enabled);
+
+/* Choose what happens to output when the output buffer is full. If
+ * interrupts are disabled the buffer can't drain, so SERIAL_FULL_BLOCK
+ * then discards the new character instead.
+ */
+void serial_set_full_policy(SerialFullPolicy policy);
+
+/* Counts since init_serial_stdio() */
+SerialStats serial_stats(void);
+
 /* Discard any input waiting to be read from the serial port. (Characters may
  * have been typed when we didn't want them - clear them.
  */
@@ -0,0 +1,202 @@
+/*
+ * sound.c
+ *
+ * Timer 1 runs in fast PWM mode 15: it counts at 1MHz (CLK/8) from 0 up
+ * to OCR1A, so OCR1A sets the period of the note, and OC1B is high for
+ * the first OCR1B + 1 counts. The compare A interrupt happens once per
+ * period - it counts down the periods left in the note and loads the next
+ * note when they run out (OCR1A and OCR1B are double buffered so the
+ * change takes effect at the start of the next period).
+ */
+
+#include "sound.h"
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+#define TIMER1_HZ 1000000UL
+
+// A note: timer 1 TOP and compare values, its length in periods and how
+// far (in timer counts either way) the period randomly wanders. A pulse
+// of zero is a rest and a length of zero ends the sequence.
+typedef struct {
+	uint16_t top;
+	uint16_t pulse;
+	uint16_t periods;
+	uint16_t jitter;
+} Note;
+
+// Notes are given in Hz, percent duty cycle and ms, and converted to
+// timer values by the compiler. Rests tick at 1kHz so each period is 1ms.
+#define NOTE(freq, duty, ms, jitter_percent) \
+	{ TIMER1_HZ / (freq) - 1, TIMER1_HZ / (freq) * (duty) / 100 - 1, \
+	  (uint32_t)(ms) * (freq) / 1000, TIMER1_HZ / (freq) * (jitter_percent) / 100 }
+#define REST(ms) { TIMER1_HZ / 1000 - 1, 0, (ms), 0 }
+#define END { 0, 0, 0, 0 }
+
+// Where a sequence starts playing from when nothing is playing
+static const Note no_note PROGMEM = END;
+
+static const Note computer_hit[] PROGMEM = {
+	NOTE(200, 50, 50, 0), END
+};
+
+// More "corrupted"-sounding than the computer hit
+static const Note human_hit[] PROGMEM = {
+	NOTE(100, 50, 200, 10), END
+};
+
+static const Note computer_sink[] PROGMEM = {
+	NOTE(200, 50, 100, 0), NOTE(300, 50, 100, 0), END
+};
+
+static const Note human_sink[] PROGMEM = {
+	NOTE(400, 50, 200, 5), NOTE(600, 50, 200, 5), END
+};
+
+static const Note human_wins[] PROGMEM = {
+	NOTE(800, 50, 250, 0), REST(50),
+	NOTE(800, 50, 100, 0), REST(50),
+	NOTE(800, 50, 100, 0), REST(50),
+	NOTE(800, 50, 800, 0), END
+};
+
+static const Note computer_wins[] PROGMEM = {
+	NOTE(500, 50, 300, 5), NOTE(400, 50, 300, 5), NOTE(300, 50, 300, 5),
+	NOTE(200, 50, 300, 5), NOTE(100, 50, 300, 5), END
+};
+
+static const Note* const sequences[NUM_SOUNDS] PROGMEM = {
+	computer_hit, human_hit, computer_sink, human_sink, human_wins, computer_wins
+};
+
+// Sounds waiting to be played
+#define SOUND_QUEUE_SIZE 4
+static volatile uint8_t sound_queue[SOUND_QUEUE_SIZE];
+static volatile uint8_t queue_head;
+static volatile uint8_t queue_length;
+
+// The note being played (NULL when silent), the periods left in it, and
+// its values if it wanders
+static const Note* volatile note;
+static uint16_t periods_left;
+static uint16_t note_top;
+static uint16_t note_pulse;
+static uint16_t note_jitter;
+static uint16_t lfsr = 0xACE1;
+
+void init_sound(void)
+{
+	// Make pin OC1B be an output (port D, pin 4)
+	DDRD |= (1 << DDD4);
+	
+	// Fast PWM with TOP in OCR1A. The clock is only started when a
+	// sound plays.
+	TCCR1A = (1 << WGM11) | (1 << WGM10);
+	TCCR1B = (1 << WGM13) | (1 << WGM12);
+	TIMSK1 |= (1 << OCIE1A);
+}
+
+static void silence(void)
+{
+	TCCR1A &= ~(1 << COM1B1);
+	TCCR1B &= ~((1 << CS12) | (1 << CS11) | (1 << CS10));
+	note = 0;
+}
+
+// Load the note at note, moving on to the next queued sound at the end of
+// a sequence. Must be called with interrupts disabled.
+static void start_note(void)
+{
+	uint16_t periods;
+	while ((periods = pgm_read_word(&note->periods)) == 0)
+	{
+		if (queue_length == 0)
+		{
+			silence();
+			return;
+		}
+		note = pgm_read_ptr(&sequences[sound_queue[queue_head]]);
+		queue_head = (queue_head + 1) % SOUND_QUEUE_SIZE;
+		queue_length--;
+	}
+	periods_left = periods;
+	note_top = pgm_read_word(&note->top);
+	note_pulse = pgm_read_word(&note->pulse);
+	note_jitter = pgm_read_word(&note->jitter);
+	OCR1A = note_top;
+	if (note_pulse)
+	{
+		OCR1B = note_pulse;
+		TCCR1A |= (1 << COM1B1);
+	} else
+	{
+		TCCR1A &= ~(1 << COM1B1);
+	}
+}
+
+// End of a period
+ISR(TIMER1_COMPA_vect)
+{
+	if (!note)
+	{
+		return;
+	}
+	if (--periods_left == 0)
+	{
+		note++;
+		start_note();
+	} else if (note_jitter)
+	{
+		// Wander by up to note_jitter counts either way
+		lfsr = (lfsr >> 1) ^ (-(lfsr & 1) & 0xB400);
+		uint16_t offset = lfsr % (2 * note_jitter + 1);
+		OCR1A = note_top - note_jitter + offset;
+		OCR1B = note_pulse - note_jitter / 2 + offset / 2;
+	}
+}
+
+void sound_play(Sound sound)
+{
+	if (sound >= NUM_SOUNDS)
+	{
+		return;
+	}
+	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	if (queue_length < SOUND_QUEUE_SIZE)
+	{
+		sound_queue[(queue_head + queue_length) % SOUND_QUEUE_SIZE] = sound;
+		queue_length++;
+		if (!note)
+		{
+			// Idle - start the timer with the new sound
+			note = &no_note;
+			start_note();
+			TCNT1 = 0;
+			TCCR1B |= (1 << CS11);
+		}
+	}
+	if (interrupts_enabled)
+	{
+		sei();
+	}
+}
+
+void sound_stop(void)
+{
+	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	queue_length = 0;
+	silence();
+	if (interrupts_enabled)
+	{
+		sei();
+	}
+}
+
+uint8_t sound_is_playing(void)
+{
+	return note != 0;
+}
@@ -0,0 +1,40 @@
+/*
+ * sound.h
+ *
+ * Sound effects on the piezo buzzer (OC1B, port D pin 4). A sound is a
+ * sequence of notes held in flash; timer 1 generates each note and its
+ * compare match interrupt moves on to the next one, so sounds play in the
+ * background while the game carries on. Sounds requested while another is
+ * playing are queued and play in order.
+ */
+
+#ifndef SOUND_H_
+#define SOUND_H_
+
+#include <stdint.h>
+
+typedef enum {
+	SOUND_COMPUTER_HIT,		// human hits a computer ship
+	SOUND_HUMAN_HIT,		// computer hits a human ship
+	SOUND_COMPUTER_SINK,	// human sinks a computer ship
+	SOUND_HUMAN_SINK,		// computer sinks a human ship
+	SOUND_HUMAN_WINS,
+	SOUND_COMPUTER_WINS,
+	NUM_SOUNDS
+} Sound;
+
+// Set up timer 1 for the buzzer. Interrupts must be enabled globally for
+// sounds to play.
+void init_sound(void);
+
+// Queue a sound to be played and return straight away. The sound is
+// dropped if the queue is full.
+void sound_play(Sound sound);
+
+// Stop the current sound and forget any queued ones
+void sound_stop(void);
+
+// Returns non-zero while a sound is playing
+uint8_t sound_is_playing(void);
+
+#endif /* SOUND_H_ */
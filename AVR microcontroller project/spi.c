@@ -6,6 +6,20 @@
 
 #include "spi.h"
 #include <avr/io.h>
+#include <avr/interrupt.h>
+
+// Bytes waiting to be sent. The interrupt handler takes bytes from the
+// head of the queue; spi_queue_byte() adds them at the tail. The SPIE0
+// bit doubles as our "transfer in progress" flag - the handler clears it
+// when it finds the queue empty.
+#ifndef SPI_QUEUE_SIZE
+#define SPI_QUEUE_SIZE 64
+#endif
+static volatile uint8_t spi_queue[SPI_QUEUE_SIZE];
+static volatile uint8_t queue_head;
+static volatile uint8_t queue_tail;
+static volatile uint8_t queue_length;
+static uint8_t high_water_mark;
 
 void spi_setup_master(uint8_t clockdivider)
 {
@@ -54,10 +68,101 @@ void spi_setup_master(uint8_t clockdivider)
 	
 	// Take SS (slave select) line low
 	PORTB &= ~(1 << PORTB4);
+	
+	// Empty the transmit queue
+	queue_head = 0;
+	queue_tail = 0;
+	queue_length = 0;
+	high_water_mark = 0;
+}
+
+// Start sending the next queued byte, or mark the transmitter idle if
+// there isn't one. Called once the previous transfer has completed.
+static void send_next_byte(void)
+{
+	if (queue_length > 0)
+	{
+		SPDR0 = spi_queue[queue_head];
+		queue_head = (queue_head + 1) & (SPI_QUEUE_SIZE - 1);
+		queue_length--;
+	} else
+	{
+		SPCR0 &= ~(1 << SPIE0);
+	}
+}
+
+// With interrupts disabled the handler can't run, so wait for the
+// current transfer and do its job here.
+static void send_next_byte_polled(void)
+{
+	while ((SPSR0 & (1 << SPIF0)) == 0)
+	{
+		; // wait
+	}
+	send_next_byte();
+}
+
+void spi_queue_byte(uint8_t byte)
+{
+	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
+	
+	// Wait for room in the queue. The interrupt handler will make room
+	// (queue_length is modified by the handler).
+	while (queue_length >= SPI_QUEUE_SIZE)
+	{
+		if (!interrupts_enabled)
+		{
+			send_next_byte_polled();
+		}
+	}
+	
+	cli();
+	if (SPCR0 & (1 << SPIE0))
+	{
+		// A transfer is under way - the handler will send this byte
+		spi_queue[queue_tail] = byte;
+		queue_tail = (queue_tail + 1) & (SPI_QUEUE_SIZE - 1);
+		queue_length++;
+		if (queue_length > high_water_mark)
+		{
+			high_water_mark = queue_length;
+		}
+	} else
+	{
+		// Idle - send it now. Reading SPSR0 first clears any SPIF left
+		// over from an earlier transfer so the interrupt only fires
+		// when this one completes.
+		(void)SPSR0;
+		SPDR0 = byte;
+		SPCR0 |= (1 << SPIE0);
+	}
+	if (interrupts_enabled)
+	{
+		sei();
+	}
+}
+
+void spi_flush(void)
+{
+	uint8_t interrupts_enabled = bit_is_set(SREG, SREG_I);
+	while (SPCR0 & (1 << SPIE0))
+	{
+		if (!interrupts_enabled)
+		{
+			send_next_byte_polled();
+		}
+	}
+}
+
+uint8_t spi_queue_high_water_mark(void)
+{
+	return high_water_mark;
 }
 
 uint8_t spi_send_byte(uint8_t byte)
 {
+	spi_flush();
+	
 	// Write out the byte to the SPDR0 register. This will initiate
 	// the transfer. We then wait until the most significant byte of
 	// SPSR0 (SPIF0 bit) is set - this indicates that the transfer is
@@ -71,3 +176,9 @@ uint8_t spi_send_byte(uint8_t byte)
 	}
 	return SPDR0;
 }
+
+// SPI transfer complete - send the next byte in the queue
+ISR(SPI_STC_vect)
+{
+	send_next_byte();
+}
@@ -14,7 +14,22 @@
 void spi_setup_master(uint8_t clockdivider);
 
 // Send and receive an SPI byte. This function will take at least 8 
-// cyles of the divided clock (i.e. will busy wait).
+// cyles of the divided clock (i.e. will busy wait). Anything still in the
+// transmit queue is sent first.
 uint8_t spi_send_byte(uint8_t byte);
 
+// Queue a byte to be sent and return straight away. The bytes are sent in
+// order by the SPI transfer complete interrupt. If the queue is full this
+// waits for room (sending the bytes itself if interrupts are disabled).
+// Received bytes are discarded.
+void spi_queue_byte(uint8_t byte);
+
+// Wait until every queued byte has been sent.
+void spi_flush(void);
+
+// The most bytes that have been waiting in the queue at once, so the
+// queue can be sized from real traffic. SPI_QUEUE_SIZE can be set at
+// build time (a power of two, at most 128).
+uint8_t spi_queue_high_water_mark(void);
+
 #endif /* SPI_H_ */
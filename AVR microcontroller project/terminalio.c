@@ -2,72 +2,151 @@
  * terminalio.c
  *
  * Author: Peter Sutton
+ *
+ * Escape sequences are sent a character at a time from flash, with
+ * numbers converted by hand, so nothing here needs printf (avr-libc's
+ * vfprintf takes thousands of cycles per call and a lot of flash).
  */
 
 #include "terminalio.h"
 #include <stdio.h>
 #include <stdint.h>
 #include <avr/pgmspace.h>
+#include "bench_marker.h"
+
+// The digits of 0 to 99, two per number, so the numbers in cursor
+// escapes need no division
+static const char digit_pairs[200] PROGMEM =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+static const uint16_t powers_of_ten[] PROGMEM = {10000, 1000, 100};
+
+void terminal_put_P(const char* text)
+{
+	char c;
+	while ((c = pgm_read_byte(text++)))
+	{
+		putchar(c);
+	}
+}
 
+uint8_t terminal_put_number(uint16_t n)
+{
+	uint8_t count = 0;
+	if (n >= 100)
+	{
+		// Leading digits by repeated subtraction
+		for (uint8_t i = 0; i < 3; i++)
+		{
+			uint16_t power = pgm_read_word(&powers_of_ten[i]);
+			char digit = '0';
+			while (n >= power)
+			{
+				n -= power;
+				digit++;
+			}
+			if (digit != '0' || count)
+			{
+				putchar(digit);
+				count++;
+			}
+		}
+	} else if (n < 10)
+	{
+		putchar('0' + n);
+		return 1;
+	}
+	putchar(pgm_read_byte(&digit_pairs[2 * n]));
+	putchar(pgm_read_byte(&digit_pairs[2 * n + 1]));
+	return count + 2;
+}
+
+// ESC [ n then the command character
+static void put_escape(int n, char command)
+{
+	putchar('\x1b');
+	putchar('[');
+	terminal_put_number(n < 0 ? 0 : n);
+	putchar(command);
+}
 
 void move_terminal_cursor(int x, int y)
 {
-    printf_P(PSTR("\x1b[%d;%dH"), y, x);
+	putchar('\x1b');
+	putchar('[');
+	terminal_put_number(y < 0 ? 0 : y);
+	putchar(';');
+	terminal_put_number(x < 0 ? 0 : x);
+	putchar('H');
 }
 
 void normal_display_mode(void)
 {
-	printf_P(PSTR("\x1b[0m"));
+	terminal_put_P(PSTR("\x1b[0m"));
 }
 
 void reverse_video(void)
 {
-	printf_P(PSTR("\x1b[7m"));
+	terminal_put_P(PSTR("\x1b[7m"));
 }
 
 void clear_terminal(void)
 {
-	printf_P(PSTR("\x1b[2J"));
+	terminal_put_P(PSTR("\x1b[2J"));
 }
 
 void clear_to_end_of_line(void)
 {
-	printf_P(PSTR("\x1b[K"));
+	terminal_put_P(PSTR("\x1b[K"));
 }
 
 void set_display_attribute(DisplayParameter parameter)
 {
-	printf_P(PSTR("\x1b[%dm"), parameter);
+	put_escape(parameter, 'm');
 }
 
 void hide_cursor()
 {
-	printf_P(PSTR("\x1b[?25l"));
+	terminal_put_P(PSTR("\x1b[?25l"));
 }
 
 void show_cursor()
 {
-	printf_P(PSTR("\x1b[?25h"));
+	terminal_put_P(PSTR("\x1b[?25h"));
 }
 
 void enable_scrolling_for_whole_display(void)
 {
-	printf_P(PSTR("\x1b[r"));
+	terminal_put_P(PSTR("\x1b[r"));
 }
 
 void set_scroll_region(int8_t y1, int8_t y2)
 {
-	printf_P(PSTR("\x1b[%d;%dr"), y1, y2);
+	putchar('\x1b');
+	putchar('[');
+	terminal_put_number(y1 < 0 ? 0 : y1);
+	putchar(';');
+	terminal_put_number(y2 < 0 ? 0 : y2);
+	putchar('r');
 }
 
 void scroll_down(void)
 {
-	printf_P(PSTR("\x1bM"));	// ESC-M
+	terminal_put_P(PSTR("\x1bM"));	// ESC-M
 }
 
 void scroll_up(void)
 {
-	printf_P(PSTR("\x1b\x44"));	// ESC-D
+	terminal_put_P(PSTR("\x1b\x44"));	// ESC-D
 }
 
 void draw_horizontal_line(int8_t y, int8_t start_x, int8_t end_x)
@@ -76,10 +155,7 @@ void draw_horizontal_line(int8_t y, int8_t start_x, int8_t end_x)
 	reverse_video();
 	for (int8_t i = start_x; i <= end_x; i++)
 	{
-		printf(" ");	/* No need to use printf_P - printing 
-						 * a single character gets optimised
-						 * to a putchar call 
-						 */
+		putchar(' ');
 	}
 	normal_display_mode();
 }
@@ -90,10 +166,42 @@ void draw_vertical_line(int8_t x, int8_t start_y, int8_t end_y)
 	reverse_video();
 	for(int8_t i = start_y; i < end_y; i++)
 	{
-		printf(" ");
+		putchar(' ');
 		/* Move down one and back to the left one */
-		printf_P(PSTR("\x1b[B\x1b[D"));
+		terminal_put_P(PSTR("\x1b[B\x1b[D"));
+	}
+	putchar(' ');
+	normal_display_mode();
+}
+
+#ifdef BENCH_MARKERS
+// The printf path this file used to take, for comparison
+static void move_terminal_cursor_printf(int x, int y)
+{
+	printf_P(PSTR("\x1b[%d;%dH"), y, x);
+}
+
+static void set_display_attribute_printf(DisplayParameter parameter)
+{
+	printf_P(PSTR("\x1b[%dm"), parameter);
+}
+
+void terminal_bench(void)
+{
+	// Few enough calls that the UART buffer never fills
+	BENCH_MARK(BENCH_TERMINAL_PRINTF);
+	for (uint8_t i = 0; i < BENCH_TERMINAL_CALLS; i++)
+	{
+		move_terminal_cursor_printf(i * 9 + 1, i + 1);
+		set_display_attribute_printf(FG_BLACK + i);
+	}
+	BENCH_MARK(BENCH_TERMINAL_DIRECT);
+	for (uint8_t i = 0; i < BENCH_TERMINAL_CALLS; i++)
+	{
+		move_terminal_cursor(i * 9 + 1, i + 1);
+		set_display_attribute(FG_BLACK + i);
 	}
-	printf(" ");
+	BENCH_MARK(BENCH_TERMINAL_END);
 	normal_display_mode();
 }
+#endif
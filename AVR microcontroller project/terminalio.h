@@ -56,6 +56,12 @@ typedef enum
 } DisplayParameter;
 
 void move_terminal_cursor(int x, int y);
+
+// Send a string from flash (PSTR), or a number in decimal. The number
+// of characters sent is returned.
+void terminal_put_P(const char* text);
+uint8_t terminal_put_number(uint16_t n);
+
 void normal_display_mode(void);
 void reverse_video(void);
 void clear_terminal(void);
@@ -86,4 +92,10 @@ void scroll_up(void);
 void draw_horizontal_line(int8_t y, int8_t startx, int8_t endx);
 void draw_vertical_line(int8_t x, int8_t starty, int8_t endy);
 
+#ifdef BENCH_MARKERS
+// Time move_terminal_cursor() and set_display_attribute() against the
+// printf_P() calls they used to make (see bench_marker.h)
+void terminal_bench(void);
+#endif
+
 #endif /* TERMINAL_IO_H */
@@ -0,0 +1,47 @@
+/*
+ * text.c
+ *
+ * Decoder for the compressed terminal text - see text.h
+ */
+
+#include "text.h"
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+#include "text_table.h"
+
+uint8_t text_length(TextId id)
+{
+	return pgm_read_byte(&text_lengths[id]);
+}
+
+void text_open(TextReader* reader, TextId id)
+{
+	reader->next = pgm_read_word(&text_starts[id]);
+	reader->end = pgm_read_word(&text_starts[id + 1]);
+	reader->depth = 0;
+}
+
+char text_read(TextReader* reader)
+{
+	uint8_t symbol;
+	if (reader->depth)
+	{
+		symbol = reader->stack[--reader->depth];
+	} else if (reader->next < reader->end)
+	{
+		symbol = pgm_read_byte(&text_symbols[reader->next++]);
+	} else
+	{
+		return 0;
+	}
+	
+	// Follow pairs down their left halves, keeping the right halves for
+	// later. The generator keeps the nesting within the stack.
+	while (symbol >= TEXT_FIRST_PAIR)
+	{
+		reader->stack[reader->depth++] = pgm_read_byte(&text_pairs[symbol - TEXT_FIRST_PAIR][1]);
+		symbol = pgm_read_byte(&text_pairs[symbol - TEXT_FIRST_PAIR][0]);
+	}
+	return symbol;
+}
@@ -0,0 +1,31 @@
+/*
+ * text.h
+ *
+ * The terminal text in text_assets.txt, compressed in flash (see
+ * host/make_text_tables.c). A TextReader decodes a text a character at a
+ * time without copying it into RAM, so it can be sent a little at a time.
+ */
+
+#ifndef TEXT_H_
+#define TEXT_H_
+
+#include <stdint.h>
+#include "text_ids.h"
+
+typedef struct {
+	uint16_t next;		// next symbol in text_symbols
+	uint16_t end;
+	uint8_t depth;		// symbols waiting on the stack
+	uint8_t stack[TEXT_STACK_SIZE];
+} TextReader;
+
+// Length of a text once decoded
+uint8_t text_length(TextId id);
+
+// Start reading a text
+void text_open(TextReader* reader, TextId id);
+
+// The next character of the text, or 0 at the end
+char text_read(TextReader* reader);
+
+#endif /* TEXT_H_ */
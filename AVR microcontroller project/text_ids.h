@@ -0,0 +1,48 @@
+/*
+ * text_ids.h
+ *
+ * Generated by host/make_text_tables.c from text_assets.txt -
+ * don't edit. The texts, in the order given.
+ */
+
+#ifndef TEXT_IDS_H_
+#define TEXT_IDS_H_
+
+// Deepest nesting of pairs, which sets the decoder's stack size
+#define TEXT_STACK_SIZE 8
+
+typedef enum {
+	TEXT_BANNER_1,
+	TEXT_BANNER_2,
+	TEXT_BANNER_3,
+	TEXT_BANNER_4,
+	TEXT_BANNER_5,
+	TEXT_BANNER_6,
+	TEXT_BANNER_7,
+	TEXT_BANNER_8,
+	TEXT_BANNER_9,
+	TEXT_STUDENT,
+	TEXT_MODE,
+	TEXT_MODE_BASIC,
+	TEXT_MODE_SEARCH,
+	TEXT_MODE_PROBABILITY,
+	TEXT_SHIP_CARRIER,
+	TEXT_SHIP_CRUISER,
+	TEXT_SHIP_DESTROYER,
+	TEXT_SHIP_FRIGATE,
+	TEXT_SHIP_CORVETTE,
+	TEXT_SHIP_SUBMARINE,
+	TEXT_INVALID_MOVE_1,
+	TEXT_INVALID_MOVE_2,
+	TEXT_INVALID_MOVE_3,
+	TEXT_COMPUTER_SANK,
+	TEXT_HUMAN_SANK,
+	TEXT_PAUSED,
+	TEXT_HUMAN_WINS,
+	TEXT_COMPUTER_WINS,
+	TEXT_GAME_OVER,
+	TEXT_PLAY_AGAIN,
+	NUM_TEXTS
+} TextId;
+
+#endif /* TEXT_IDS_H_ */
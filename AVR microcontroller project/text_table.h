@@ -0,0 +1,70 @@
+/*
+ * text_table.h
+ *
+ * Generated by host/make_text_tables.c from text_assets.txt -
+ * don't edit. 1293 bytes of text in 500 bytes,
+ * plus 116 bytes of pairs.
+ */
+
+#define TEXT_FIRST_PAIR 128
+
+// The two symbols each symbol from TEXT_FIRST_PAIR up stands for
+static const uint8_t text_pairs[58][2] PROGMEM = {
+	{32, 32}, {36, 36}, {32, 129}, {124, 130}, {128, 128}, {95, 95}, {128, 131}, {129, 129},
+	{32, 92}, {133, 133}, {131, 132}, {128, 92}, {101, 114}, {135, 129}, {128, 32}, {32, 116},
+	{131, 134}, {32, 97}, {97, 114}, {101, 115}, {124, 132}, {128, 136}, {132, 92}, {101, 32},
+	{131, 133}, {132, 134}, {137, 133}, {153, 142}, {80, 114}, {104, 151}, {105, 110}, {124, 139},
+	{134, 155}, {135, 36}, {135, 135}, {138, 129}, {138, 134}, {145, 32}, {149, 129}, {32, 83},
+	{47, 130}, {95, 32}, {99, 116}, {101, 116}, {101, 170}, {103, 97}, {105, 115}, {110, 116},
+	{111, 117}, {121, 32}, {124, 128}, {131, 161}, {133, 132}, {136, 141}, {137, 137}, {141, 92},
+	{148, 150}, {179, 92}
+};
+
+// Where each text's symbols start; the last entry is the end
+static const uint16_t text_starts[NUM_TEXTS + 1] PROGMEM = {
+	0, 24, 49, 63, 79, 93, 110, 130, 147, 169, 221, 227,
+	239, 254, 268, 273, 278, 285, 291, 298, 305, 332, 349, 374,
+	384, 393, 421, 437, 455, 464, 500
+};
+
+// Length of each text once decoded
+static const uint8_t text_lengths[NUM_TEXTS] PROGMEM = {
+	97, 97, 97, 97, 97, 97, 97, 97, 97, 56, 6, 18,
+	18, 18, 7, 7, 9, 7, 8, 9, 31, 26, 37, 12,
+	12, 33, 25, 27, 9, 45
+};
+
+static const uint8_t text_symbols[500] PROGMEM = {
+	32, 154, 95, 132, 154, 128, 182, 128, 182, 128, 180, 132, 182, 142, 154, 142,
+	180, 133, 128, 154, 128, 154, 95, 128, 148, 149, 128, 47, 132, 139, 184, 184,
+	159, 132, 128, 184, 32, 47, 132, 139, 32, 159, 128, 159, 148, 139, 148, 149,
+	32, 185, 178, 183, 92, 162, 136, 162, 164, 141, 178, 183, 144, 181, 185, 152,
+	168, 152, 144, 155, 164, 180, 152, 95, 92, 129, 152, 144, 134, 133, 168, 163,
+	163, 160, 164, 139, 150, 129, 150, 32, 163, 134, 134, 132, 129, 185, 131, 141,
+	160, 164, 129, 36, 132, 95, 92, 183, 131, 141, 134, 134, 161, 32, 152, 168,
+	144, 160, 131, 137, 169, 131, 137, 169, 159, 133, 131, 144, 32, 95, 131, 169,
+	138, 128, 163, 144, 160, 138, 136, 138, 136, 136, 129, 132, 129, 144, 178, 130,
+	136, 138, 128, 181, 36, 139, 129, 166, 166, 132, 166, 150, 162, 136, 162, 139,
+	141, 139, 129, 166, 181, 136, 129, 132, 128, 67, 83, 83, 69, 50, 48, 49,
+	48, 47, 55, 50, 48, 49, 32, 156, 111, 106, 172, 32, 98, 177, 60, 72,
+	97, 111, 122, 104, 105, 32, 82, 121, 97, 110, 32, 89, 97, 110, 103, 62,
+	32, 45, 32, 60, 52, 54, 57, 54, 56, 48, 57, 54, 62, 77, 79, 68,
+	69, 58, 32, 66, 97, 115, 105, 99, 32, 77, 111, 118, 147, 132, 142, 83,
+	101, 146, 99, 104, 145, 110, 100, 32, 68, 147, 116, 114, 111, 121, 156, 111,
+	98, 97, 98, 105, 108, 105, 116, 177, 72, 117, 175, 128, 67, 146, 114, 105,
+	140, 67, 114, 117, 174, 140, 68, 147, 116, 114, 111, 121, 140, 70, 114, 105,
+	173, 116, 101, 67, 111, 114, 118, 171, 116, 101, 83, 117, 98, 109, 146, 158,
+	101, 73, 110, 118, 97, 108, 105, 100, 32, 109, 111, 118, 101, 44, 32, 112,
+	108, 101, 97, 115, 101, 143, 114, 121, 145, 173, 158, 46, 83, 101, 108, 172,
+	165, 100, 105, 102, 102, 140, 101, 175, 143, 146, 103, 171, 33, 83, 140, 105,
+	176, 115, 108, 121, 63, 167, 101, 108, 172, 165, 100, 105, 102, 102, 140, 101,
+	175, 143, 146, 103, 171, 33, 73, 167, 117, 110, 107, 32, 89, 176, 114, 32,
+	89, 176, 167, 117, 110, 107, 32, 77, 177, 71, 97, 109, 151, 80, 97, 117,
+	115, 101, 100, 46, 32, 156, 147, 115, 32, 39, 80, 39, 143, 111, 32, 114,
+	147, 117, 109, 101, 46, 84, 157, 112, 108, 97, 121, 140, 32, 174, 143, 157,
+	119, 158, 110, 140, 33, 84, 157, 99, 111, 109, 112, 117, 116, 140, 32, 174,
+	143, 157, 119, 158, 110, 140, 33, 71, 65, 77, 69, 32, 79, 86, 69, 82,
+	156, 147, 115, 165, 98, 117, 116, 116, 111, 110, 32, 111, 114, 32, 39, 115,
+	39, 47, 39, 83, 39, 143, 111, 32, 115, 116, 146, 116, 165, 110, 101, 119,
+	32, 173, 109, 101
+};
@@ -9,6 +9,7 @@
  */
 
 #include "timer0.h"
+#include "buttons.h"
 #include <avr/io.h>
 #include <avr/interrupt.h>
 
@@ -75,8 +76,35 @@ uint32_t get_current_time(void)
 	return return_value;
 }
 
+uint32_t get_current_time_us(void)
+{
+	uint32_t ticks;
+	uint8_t count;
+
+	uint8_t interrupts_were_enabled = bit_is_set(SREG, SREG_I);
+	cli();
+	ticks = clock_ticks_ms;
+	count = TCNT0;
+	/* If the timer has reached its compare value since the interrupt
+	 * was last handled, the tick we read is one behind the count.
+	 */
+	if ((TIFR0 & (1 << OCF0A)) && count < 62)
+	{
+		ticks++;
+	}
+	if (interrupts_were_enabled)
+	{
+		sei();
+	}
+	/* Each count is 64 clock cycles, i.e. 8 microseconds */
+	return ticks * 1000 + count * 8;
+}
+
 ISR(TIMER0_COMPA_vect)
 {
 	/* Increment our clock tick count */
 	clock_ticks_ms++;
+	
+	/* Debounce the push buttons */
+	buttons_sample();
 }
@@ -30,4 +30,10 @@ void init_timer0(void);
  */
 uint32_t get_current_time(void);
 
+/* Return the time in microseconds (to the nearest 8) since the timer was
+ * initialised. Wraps around every ~71 minutes so is only good for
+ * measuring short intervals.
+ */
+uint32_t get_current_time_us(void);
+
 #endif /* TIMER0_H_ */
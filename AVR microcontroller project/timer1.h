@@ -1,19 +0,0 @@
-/*
- * timer1.h
- *
- * Author: Peter Sutton
- *
- * timer 1 skeleton
- */
-
-#ifndef TIMER1_H_
-#define TIMER1_H_
-
-#include <stdint.h>
-
-/* Set up our timer 
- */
-void init_timer1(void);
-
-
-#endif /* TIMER1_H_ */